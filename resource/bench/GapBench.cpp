@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Fixture and measurement for the gap between two tracks of the music player, which only the pen itself can play.
+//
+//   GapBench --write /userdisk/Music/gap [--parts 6] [--seconds 5]
+//     Splits one continuous 1kHz tone into numbered MP3 files, and times probing them as the preload does.
+//     Play the folder in order on the pen and record the headphone output, before and after a change.
+//
+//   GapBench --measure recording.wav
+//     Reports every dropout of the tone in a 16-bit PCM recording, the first channel is used.
+//     The encoder delay and padding of the fixture (about 50ms per switch at 44.1kHz) are part of what is measured,
+//     compare runs against each other rather than against zero.
+
+#include "filemanager/player/TrackProbe.h"
+#include "recorder/AudioEncoder.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <numbers>
+#include <numeric>
+
+using namespace mod;
+
+constexpr int    SAMPLE_RATE   = 44100;
+constexpr double TONE_HZ       = 1000;
+constexpr double TONE_LEVEL    = 0.25; // -12dBFS
+constexpr int    WINDOW_MS     = 1;
+constexpr double GAP_THRESHOLD = 0.02; // RMS, about 22dB below the tone.
+
+static bool writeFixture(const QString& dir, int parts, int seconds) {
+    if (!QDir().mkpath(dir)) {
+        spdlog::error("Failed to create {}.", dir.toStdString());
+        return false;
+    }
+    RecordingProfile   profile{RecordingProfile::Format::Mp3, true, -1, 128, 2, "gap"};
+    std::vector<int16> pcm((size_t)SAMPLE_RATE * seconds);
+    int64              sample = 0; // the phase carries on from one part to the next.
+    for (int part = 1; part <= parts; part++) {
+        for (auto& value : pcm) {
+            value = (int16)(std::sin(2 * std::numbers::pi * TONE_HZ * (double)sample++ / SAMPLE_RATE) * TONE_LEVEL
+                            * 32767);
+        }
+        auto               encoder = AudioEncoder::create(profile, SAMPLE_RATE, 1);
+        std::vector<uint8> bytes;
+        encoder->begin(bytes);
+        encoder->encode(pcm.data(), pcm.size(), bytes);
+        encoder->flush(bytes);
+        auto header = encoder->getFinalHeader((int64)bytes.size());
+        std::copy(header.begin(), header.end(), bytes.begin());
+
+        QFile file(QDir(dir).filePath(QString("%1 gap.mp3").arg(part, 2, 10, QChar('0'))));
+        if (!file.open(QIODevice::WriteOnly) || file.write((const char*)bytes.data(), (qint64)bytes.size()) < 0) {
+            spdlog::error("Failed to write {}.", file.fileName().toStdString());
+            return false;
+        }
+    }
+    spdlog::info("Wrote {} parts of {}s to {}.", parts, seconds, dir.toStdString());
+
+    // What the preload does ahead of a switch. The files were just written, the first probe doesn't wait for the disk
+    // here as it may on the pen.
+    for (auto& info : QDir(dir).entryInfoList({"*.mp3"}, QDir::Files, QDir::Name)) {
+        QElapsedTimer timer;
+        timer.start();
+        auto probe   = filemanager::probeTrack(info.absoluteFilePath());
+        auto firstUs = timer.nsecsElapsed() / 1000;
+        timer.restart();
+        filemanager::probeTrack(info.absoluteFilePath());
+        auto againUs = timer.nsecsElapsed() / 1000;
+        if (!probe.mValid) {
+            spdlog::error("{} doesn't probe as MPEG audio.", info.fileName().toStdString());
+            return false;
+        }
+        spdlog::info("Probed {} in {}us, {}us again.", info.fileName().toStdString(), firstUs, againUs);
+    }
+    return true;
+}
+
+// Only what a plain recorder writes, a "fmt " chunk of PCM and a "data" chunk.
+static std::optional<std::vector<int16>> readWav(const QString& path, int& sampleRate) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    auto data = file.readAll();
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE") {
+        return std::nullopt;
+    }
+    auto read16   = [&](int pos) { return (uint16)((uint8)data[pos] | (uint8)data[pos + 1] << 8); };
+    auto read32   = [&](int pos) { return (uint32)read16(pos) | (uint32)read16(pos + 2) << 16; };
+    int  channels = 0;
+    for (int pos = 12; pos + 8 <= data.size();) {
+        auto id   = data.mid(pos, 4);
+        auto size = (int)read32(pos + 4);
+        auto body = pos + 8;
+        if (id == "fmt " && size >= 16 && body + 16 <= data.size()) {
+            if (read16(body) != 1 || read16(body + 14) != 16) {
+                return std::nullopt; // not 16-bit PCM.
+            }
+            channels   = read16(body + 2);
+            sampleRate = (int)read32(body + 4);
+        } else if (id == "data" && channels > 0) {
+            auto               frames = (std::min(size, (int)data.size() - body)) / 2 / channels;
+            std::vector<int16> samples(frames);
+            for (int i = 0; i < frames; i++) {
+                samples[i] = (int16)read16(body + i * 2 * channels);
+            }
+            return samples;
+        }
+        pos = body + size + (size & 1);
+    }
+    return std::nullopt;
+}
+
+static bool measureGaps(const QString& path) {
+    int  sampleRate = 0;
+    auto samples    = readWav(path, sampleRate);
+    if (!samples || sampleRate <= 0) {
+        spdlog::error("{} isn't a 16-bit PCM WAV file.", path.toStdString());
+        return false;
+    }
+    auto                  window = (size_t)sampleRate * WINDOW_MS / 1000;
+    std::vector<double>   gaps;
+    std::optional<size_t> gapStart;
+    bool                  toneSeen = false;
+    for (size_t pos = 0; pos + window <= samples->size(); pos += window) {
+        double sum = 0;
+        for (size_t i = pos; i < pos + window; i++) {
+            auto x  = (*samples)[i] / 32768.0;
+            sum    += x * x;
+        }
+        auto silent = std::sqrt(sum / (double)window) < GAP_THRESHOLD;
+        if (!silent && gapStart) {
+            // Silence before the tone first starts isn't a gap.
+            if (toneSeen) {
+                gaps.emplace_back((double)(pos - *gapStart) * 1000 / sampleRate);
+            }
+            gapStart.reset();
+        }
+        if (silent && !gapStart) {
+            gapStart = pos;
+        }
+        toneSeen |= !silent;
+    }
+    if (gaps.empty()) {
+        spdlog::info("No gap in {}s of audio.", samples->size() / sampleRate);
+        return true;
+    }
+    for (size_t i = 0; i < gaps.size(); i++) {
+        spdlog::info("Gap {}: {:.0f}ms.", i + 1, gaps[i]);
+    }
+    spdlog::info(
+        "{} gaps, mean {:.1f}ms, max {:.0f}ms.",
+        gaps.size(),
+        std::accumulate(gaps.begin(), gaps.end(), 0.0) / (double)gaps.size(),
+        *std::max_element(gaps.begin(), gaps.end())
+    );
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    QString write, measure;
+    int     parts   = 6;
+    int     seconds = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--write" && i + 1 < argc) {
+            write = argv[++i];
+        } else if (arg == "--measure" && i + 1 < argc) {
+            measure = argv[++i];
+        } else if (arg == "--parts" && i + 1 < argc) {
+            parts = std::max(std::stoi(argv[++i]), 2);
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::max(std::stoi(argv[++i]), 1);
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+    if (write.isEmpty() == measure.isEmpty()) {
+        spdlog::error("Either --write or --measure is required.");
+        return 1;
+    }
+    auto ok = write.isEmpty() ? measureGaps(measure) : writeFixture(write, parts, seconds);
+    return ok ? 0 : 1;
+}
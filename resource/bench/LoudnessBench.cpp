@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Measures how fast tracks are analyzed for loudness normalization: the meter alone on synthetic PCM for the
+// common rates and channel counts, then decoding and metering of the given MP3 files, as LoudnessStore does.
+//
+//   LoudnessBench [--seconds 60] [file.mp3...]
+
+#include "filemanager/player/Loudness.h"
+#include "filemanager/player/TrackMetadata.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <numbers>
+
+using namespace mod::filemanager;
+
+constexpr size_t CHUNK_FRAMES = 1152; // as decoded, one MPEG frame at a time.
+
+// Pink-ish noise under a slow envelope, so that the gates have something to reject.
+static std::vector<int16> synthesize(int sampleRate, int channels, int seconds) {
+    std::vector<int16> pcm((size_t)sampleRate * seconds * channels);
+    uint32             noise = 1;
+    double             low   = 0;
+    for (size_t i = 0; i < pcm.size() / channels; i++) {
+        auto t    = (double)i / sampleRate;
+        noise     = noise * 1664525 + 1013904223;
+        low       = low * 0.95 + ((int)(noise >> 16) - 32768) / 32768.0 * 0.05;
+        auto gain = 0.05 + 0.45 * (0.5 + 0.5 * std::sin(2 * std::numbers::pi * 0.1 * t));
+        for (int ch = 0; ch < channels; ch++) {
+            pcm[i * channels + ch] = (int16)std::clamp(low * gain * (ch ? 0.8 : 1.0) * 32767 * 4, -32768.0, 32767.0);
+        }
+    }
+    return pcm;
+}
+
+int main(int argc, char* argv[]) {
+    int         seconds = 60;
+    QStringList files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::max(QString(argv[++i]).toInt(), 1);
+        } else if (arg.starts_with("--")) {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        } else {
+            files.append(QString::fromStdString(arg));
+        }
+    }
+
+    spdlog::info("{:<24} {:>8} {:>10} {:>12} {:>8} {:>8}", "input", "len(s)", "wall(ms)", "samples/s", "LUFS", "peak");
+    for (auto sampleRate : {44100, 48000}) {
+        for (auto channels : {1, 2}) {
+            auto pcm = synthesize(sampleRate, channels, seconds);
+
+            QElapsedTimer timer;
+            timer.start();
+            LoudnessMeter meter(sampleRate, channels);
+            for (size_t pos = 0; pos < pcm.size(); pos += CHUNK_FRAMES * channels) {
+                meter.add(pcm.data() + pos, std::min(CHUNK_FRAMES * channels, pcm.size() - pos));
+            }
+            auto result = meter.getResult();
+            auto wall   = (double)timer.nsecsElapsed() / 1e9;
+            spdlog::info(
+                "{:<24} {:>8} {:>10.1f} {:>12.0f} {:>8.1f} {:>8.1f}",
+                fmt::format("meter {}Hz {}ch", sampleRate, channels),
+                seconds,
+                wall * 1000,
+                (double)pcm.size() / wall,
+                result ? result->mLoudness : 0.0f,
+                result ? result->mPeak : 0.0f
+            );
+        }
+    }
+
+    auto              failed = false;
+    std::atomic<bool> cancelled{false};
+    for (auto& file : files) {
+        QElapsedTimer timer;
+        timer.start();
+        auto result = analyzeLoudness(file, cancelled);
+        auto wall   = (double)timer.nsecsElapsed() / 1e9;
+        if (!result) {
+            spdlog::error("Unable to measure {}.", file.toStdString());
+            failed = true;
+            continue;
+        }
+        // Decoded samples, counted from what the tags and frame headers tell.
+        auto meta    = readTrackMetadata(file).value_or(TrackMetadata{});
+        auto samples = (double)meta.mDuration / 1000 * meta.mSampleRate * meta.mChannels;
+        spdlog::info(
+            "{:<24} {:>8.0f} {:>10.1f} {:>12.0f} {:>8.1f} {:>8.1f}  gain {:+.1f}dB",
+            QFileInfo(file).fileName().left(24).toStdString(),
+            (double)meta.mDuration / 1000,
+            wall * 1000,
+            samples / wall,
+            result->mLoudness,
+            result->mPeak,
+            getNormalizationGain(*result)
+        );
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Parses synthetic lyrics of growing size (bilingual lines, several timestamps per line, an offset), in UTF-8 and
+// GB18030, and times the lookups the player makes while playing. Exits with 1 if a lookup is wrong.
+//
+//   LrcBench [--lines 1000,10000,100000]
+
+#include "common/util/TextEncoding.h"
+#include "filemanager/player/Lyrics.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace mod;
+using namespace mod::filemanager;
+
+constexpr int   LOOKUPS = 100000;
+constexpr int64 LINE_MS = 1000; // keeps 100000 lines and their repeats under the 4 digit minutes of a timestamp.
+
+static volatile int64 gSink; // keeps the lookups from being optimized out.
+
+static QString timestamp(int64 ms) {
+    return QString("[%1:%2.%3]")
+        .arg(ms / 60000, 2, 10, QChar('0'))
+        .arg(ms / 1000 % 60, 2, 10, QChar('0'))
+        .arg(ms / 10 % 100, 2, 10, QChar('0'));
+}
+
+// Every third line carries a second timestamp (a chorus), every line a translation under the same timestamp.
+static QString synthesize(int lines) {
+    QString text = "[ti:示例歌曲]\n[ar:Artist]\n[al:Album]\n[offset:+120]\n";
+    text.reserve(lines * 64);
+    for (int i = 0; i < lines; i++) {
+        auto time = (int64)i * LINE_MS;
+        auto tags = timestamp(time);
+        if (i % 3 == 0) {
+            tags += timestamp(time + (int64)lines * LINE_MS);
+        }
+        text += QString("%1第%2行 The quick brown fox jumps\n").arg(tags).arg(i);
+        text += QString("%1Line %2 敏捷的棕色狐狸\n").arg(timestamp(time)).arg(i);
+    }
+    return text;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes{1000, 10000, 100000};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) {
+            sizes.clear();
+            for (auto& item : QString(argv[++i]).split(',')) {
+                sizes.emplace_back(std::max(item.toInt(), 10));
+            }
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+
+    spdlog::info(
+        "{:>7} {:>8} {:>8} | {:>9} {:>8} {:>8} | {:>10} {:>10}",
+        "lines",
+        "encoding",
+        "KB",
+        "parse(ms)",
+        "MB/s",
+        "entries",
+        "lookup(ns)",
+        "cached(us)"
+    );
+    QTemporaryDir dir;
+    auto          failed = false;
+    for (auto lines : sizes) {
+        auto text = synthesize(lines);
+        for (auto encoding : {util::TextEncoding::Utf8, util::TextEncoding::Gb18030}) {
+            auto data = util::encodeText(text, encoding);
+
+            QElapsedTimer timer;
+            timer.start();
+            auto lyrics  = Lyrics::parse(data);
+            auto parseMs = (double)timer.nsecsElapsed() / 1e6;
+
+            // Chorus lines are repeated, translations are folded into their line.
+            auto  expected = (size_t)lines + (lines + 2) / 3;
+            auto& entries  = lyrics.getLines();
+            if (entries.size() != expected || !lyrics.hasTranslation() || lyrics.mTitle != "示例歌曲") {
+                spdlog::error("{} lines parsed into {} entries, {} expected.", lines, entries.size(), expected);
+                failed = true;
+                continue;
+            }
+
+            // Positions as the player polls them, checked against a linear search on a sample.
+            uint32 seed  = 1;
+            auto   total = entries.back().mTime + LINE_MS;
+            int64  sum   = 0;
+            timer.restart();
+            for (int i = 0; i < LOOKUPS; i++) {
+                seed  = seed * 1664525 + 1013904223;
+                sum  += lyrics.indexAt((int64)(seed % (uint32)total));
+            }
+            auto lookupNs = (double)timer.nsecsElapsed() / LOOKUPS;
+            for (int i = 0; i < 1000; i++) {
+                seed          = seed * 1664525 + 1013904223;
+                auto position = (int64)(seed % (uint32)total);
+                int  linear   = -1;
+                while (linear + 1 < (int)entries.size() && entries[linear + 1].mTime <= position) {
+                    linear++;
+                }
+                if (lyrics.indexAt(position) != linear) {
+                    spdlog::error("indexAt({}) is {}, {} expected.", position, lyrics.indexAt(position), linear);
+                    failed = true;
+                    break;
+                }
+            }
+
+            // A second get() of the same file is what the player pays when the preload already parsed it.
+            auto  path = dir.filePath(QString("%1.lrc").arg(lines));
+            QFile file(path);
+            file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+            file.write(data);
+            file.close();
+            LyricsCache cache;
+            cache.get(path);
+            timer.restart();
+            auto cached   = cache.get(path);
+            auto cachedUs = (double)timer.nsecsElapsed() / 1e3;
+            if (!cached || cached->getLines().size() != expected) {
+                spdlog::error("The cache doesn't return the parsed file.");
+                failed = true;
+            }
+
+            spdlog::info(
+                "{:>7} {:>8} {:>8} | {:>9.2f} {:>8.1f} {:>8} | {:>10.0f} {:>10.1f}",
+                lines,
+                encoding == util::TextEncoding::Utf8 ? "utf-8" : "gb18030",
+                data.size() / 1024,
+                parseMs,
+                (double)data.size() / 1e6 / (parseMs / 1000),
+                entries.size(),
+                lookupNs,
+                cachedUs
+            );
+            gSink = sum;
+        }
+    }
+    return failed ? 1 : 0;
+}
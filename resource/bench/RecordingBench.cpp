@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Feeds synthetic PCM through the recording pipeline AudioRecorder uses (level meter, ring, encoder thread,
+// block writer) as fast as it takes it, for every profile, and reports how it keeps up.
+//
+//   RecordingBench [--seconds 10,60,300] [--out /tmp] [--keep]
+
+#include "recorder/LevelMeter.h"
+#include "recorder/RecordingPipeline.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+
+#include <map>
+#include <numbers>
+#include <thread>
+
+static std::atomic<uint64> gAllocations{0};
+
+void* operator new(size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+using namespace mod;
+
+constexpr size_t CAPTURE_SAMPLES = 16 * 1024 / sizeof(int16); // as read by AudioRecorder.
+constexpr int    LOOP_SECONDS    = 10;
+
+// Phrases of a voiced, harmonic tone with syllable-rate modulation, separated by pauses with a little noise.
+// Not speech, but it exercises the encoder the same way: tonal content, dynamics and near-silence.
+static std::vector<int16> synthesize(int sampleRate, int channels) {
+    std::vector<int16> pcm((size_t)sampleRate * LOOP_SECONDS * channels);
+    uint32             noise = 1;
+    double             phase = 0;
+    for (size_t i = 0; i < pcm.size() / channels; i++) {
+        auto t      = (double)i / sampleRate;
+        auto pitch  = 150 + 50 * std::sin(2 * std::numbers::pi * 0.3 * t);
+        auto inWord = std::fmod(t, 2.2) < 1.5;
+        phase      += 2 * std::numbers::pi * pitch / sampleRate;
+
+        double voiced = 0;
+        for (int harmonic = 1; harmonic <= 8; harmonic++) {
+            voiced += std::sin(phase * harmonic) / harmonic;
+        }
+        noise = noise * 1664525 + 1013904223;
+
+        auto envelope = inWord ? 0.5 + 0.5 * std::sin(2 * std::numbers::pi * 4 * t) : 0;
+        auto hiss     = ((int)(noise >> 16) - 32768) / 32768.0 * 0.01;
+        auto value    = voiced * envelope * 0.25 + hiss;
+        for (int ch = 0; ch < channels; ch++) {
+            // The second channel a little quieter, so that joint stereo has something to do.
+            pcm[i * channels + ch] = (int16)std::clamp(value * (ch ? 0.8 : 1.0) * 32767, -32768.0, 32767.0);
+        }
+    }
+    return pcm;
+}
+
+struct Result {
+    double mWall{};   // s
+    double mRtf{};    // encoder time / audio time.
+    double mAllocs{}; // per second of audio, operator new only, LAME's own mallocs are not seen.
+    int64  mBytes{};
+    uint64 mDropped{};
+    bool   mOk{};
+};
+
+static Result run(const RecordingProfile& profile, int sampleRate, int channels, int seconds, const QString& path) {
+    static std::map<std::pair<int, int>, std::vector<int16>> loops;
+    auto& loop = loops[{sampleRate, channels}];
+    if (loop.empty()) {
+        loop = synthesize(sampleRate, channels);
+    }
+
+    Result        result;
+    VoiceDetector detector;
+    auto          total = (size_t)sampleRate * seconds * channels;
+
+    QElapsedTimer timer;
+    timer.start();
+    auto allocations = gAllocations.load();
+
+    RecordingPipeline pipeline(AudioEncoder::create(profile, sampleRate, channels), sampleRate, channels);
+    if (!pipeline.start(path)) {
+        return result;
+    }
+    for (size_t fed = 0; fed < total;) {
+        auto offset = fed % loop.size();
+        auto count  = std::min({CAPTURE_SAMPLES, total - fed, loop.size() - offset});
+        // The device would wait, the bench doesn't, but nothing may be dropped.
+        while (pipeline.getCapacity() - pipeline.getBacklog() < count) {
+            std::this_thread::yield();
+        }
+        auto level = measureLevel(loop.data() + offset, count);
+        detector.update(level.getRmsDb(), (double)count * 1000 / channels / sampleRate);
+        pipeline.push(loop.data() + offset, count);
+        fed += count;
+    }
+    result.mOk      = pipeline.stop();
+    result.mWall    = (double)timer.nsecsElapsed() / 1e9;
+    result.mAllocs  = (double)(gAllocations.load() - allocations) / seconds;
+    result.mRtf     = pipeline.getRealTimeFactor();
+    result.mBytes   = pipeline.getStats().mBytes;
+    result.mDropped = pipeline.getStats().mDropped;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> lengths{10, 60, 300};
+    QString          dir  = QDir::tempPath();
+    bool             keep = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            lengths.clear();
+            for (auto& item : QString(argv[++i]).split(',')) {
+                lengths.emplace_back(item.toInt());
+            }
+        } else if (arg == "--out" && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (arg == "--keep") {
+            keep = true;
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+
+    spdlog::info(
+        "{:<9} {:>2} {:>6} {:>5} | {:>8} {:>8} {:>7} {:>9} {:>10} {:>8}",
+        "profile",
+        "ch",
+        "rate",
+        "len",
+        "wall(ms)",
+        "speed",
+        "rtf",
+        "allocs/s",
+        "bytes",
+        "KB/min"
+    );
+    auto failed = false;
+    for (auto& profile : RecordingProfile::getPresets()) {
+        for (auto channels : {1, 2}) {
+            for (auto sampleRate : {16000, 48000}) {
+                for (auto seconds : lengths) {
+                    auto name   = QString("bench-%1-%2-%3-%4").arg(profile.mName).arg(channels).arg(sampleRate);
+                    auto path   = QDir(dir).filePath(name.arg(seconds) + profile.getSuffix());
+                    auto result = run(profile, sampleRate, channels, seconds, path);
+                    if (!keep) {
+                        QFile::remove(path);
+                    }
+                    if (!result.mOk || result.mDropped) {
+                        spdlog::error("{} failed, {} samples dropped.", path.toStdString(), result.mDropped);
+                        failed = true;
+                        continue;
+                    }
+                    spdlog::info(
+                        "{:<9} {:>2} {:>6} {:>5} | {:>8.0f} {:>7.1f}x {:>7.3f} {:>9.1f} {:>10} {:>8.0f}",
+                        profile.mName,
+                        channels,
+                        sampleRate,
+                        seconds,
+                        result.mWall * 1000,
+                        seconds / result.mWall,
+                        result.mRtf,
+                        result.mAllocs,
+                        result.mBytes,
+                        (double)result.mBytes / 1024 / seconds * 60
+                    );
+                }
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
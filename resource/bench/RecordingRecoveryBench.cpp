@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Records a PCM fixture in a child process at the pace of the microphone and kills it with SIGKILL at a random
+// point, for every profile, then repairs the file from the journal as AudioRecorder does at startup and checks
+// that it plays: whole frames only, a frame count matching them, or a WAV header matching the data.
+// Killed before the first checkpoint, the file may hold nothing yet and is then expected to be removed.
+// Exits with 1 if a recording can't be repaired, or is lost although it was killed past the first checkpoint.
+//
+// The journal lives in the cache directory of PenMods, don't run it on the pen while recording.
+//
+//   RecordingRecoveryBench [--rounds 3] [--pcm fixture.s16le] [--out /tmp]
+//     The fixture is raw 16-bit stereo at 16kHz as AudioRecorder captures it, a synthetic one by default.
+
+#include "filemanager/player/TrackMetadata.h"
+#include "filemanager/player/TrackProbe.h"
+#include "recorder/RecordingJournal.h"
+#include "recorder/RecordingPipeline.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtEndian>
+
+#include <numbers>
+#include <thread>
+
+#include <csignal>
+#include <cstring>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace mod;
+
+constexpr int SAMPLE_RATE     = 16000;
+constexpr int CHANNELS        = 2;
+constexpr int CHUNK_MS        = 20;
+constexpr int MIN_RUN_MS      = 200;
+constexpr int MAX_RUN_MS      = 7000; // past a checkpoint or two.
+constexpr int CHECKPOINT_MS   = 1000; // the first one of RecordingPipeline.
+constexpr int STARTUP_MS      = 500;  // for the child to get the pipeline going.
+constexpr int WAV_HEADER      = 44;
+constexpr int FIXTURE_SECONDS = 10;
+
+static std::vector<int16> synthesize() {
+    std::vector<int16> pcm((size_t)SAMPLE_RATE * FIXTURE_SECONDS * CHANNELS);
+    for (size_t i = 0; i < pcm.size() / CHANNELS; i++) {
+        auto t     = (double)i / SAMPLE_RATE;
+        auto value = std::fmod(t, 2) < 1.4 ? std::sin(2 * std::numbers::pi * 220 * t) * 0.3 : 0;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+            pcm[i * CHANNELS + ch] = (int16)(value * 32767);
+        }
+    }
+    return pcm;
+}
+
+// Never returns, the parent kills it.
+[[noreturn]] static void record(const RecordingProfile& profile, const QString& path, const std::vector<int16>& pcm) {
+    RecordingPipeline pipeline(AudioEncoder::create(profile, SAMPLE_RATE, CHANNELS), SAMPLE_RATE, CHANNELS);
+    if (!pipeline.start(path)) {
+        _exit(1);
+    }
+    auto chunk = (size_t)SAMPLE_RATE * CHUNK_MS / 1000 * CHANNELS;
+    auto next  = std::chrono::steady_clock::now();
+    for (size_t offset = 0;; offset = (offset + chunk) % (pcm.size() - pcm.size() % chunk)) {
+        pipeline.push(pcm.data() + offset, chunk);
+        next += std::chrono::milliseconds(CHUNK_MS);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+// Duration in ms of what the repaired file holds, nullopt if it isn't well formed.
+static std::optional<int64> checkMp3(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    auto   data    = file.readAll();
+    auto*  bytes   = (const uint8*)data.constData();
+    auto   size    = (size_t)data.size();
+    auto   first   = size >= 4 ? filemanager::parseMp3FrameHeader(bytes) : std::nullopt;
+    int64  samples = 0;
+    size_t pos     = 0;
+    while (first && pos + 4 <= size) {
+        auto header = filemanager::parseMp3FrameHeader(bytes + pos);
+        if (!header) {
+            spdlog::error("No frame at {} of {} bytes.", pos, size);
+            return std::nullopt;
+        }
+        samples += header->mSamplesPerFrame;
+        pos     += header->mFrameSize;
+    }
+    if (!first || pos != size) {
+        spdlog::error("The last frame ends at {}, the file at {}.", pos, size);
+        return std::nullopt;
+    }
+    // The first frame is the Xing/Info one, its count is what players go by.
+    auto frames   = (samples - first->mSamplesPerFrame) / first->mSamplesPerFrame;
+    auto expected = frames * first->mSamplesPerFrame * 1000 / first->mSampleRate;
+    auto meta     = filemanager::readTrackMetadata(path);
+    if (!meta || std::abs(meta->mDuration - expected) > 100) {
+        spdlog::error("The header gives {}ms, the frames {}ms.", meta ? meta->mDuration : -1, expected);
+        return std::nullopt;
+    }
+    return expected;
+}
+
+static std::optional<int64> checkWav(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    auto header = file.read(WAV_HEADER);
+    auto size   = file.size();
+    if (header.size() != WAV_HEADER || !header.startsWith("RIFF")) {
+        return std::nullopt;
+    }
+    auto read32 = [&](int pos) { return qFromLittleEndian<quint32>(header.constData() + pos); };
+    auto data   = (int64)read32(40);
+    if ((int64)read32(4) != size - 8 || data != size - WAV_HEADER || data % (CHANNELS * 2)) {
+        spdlog::error("The header says {} bytes of data, the file holds {}.", data, size - WAV_HEADER);
+        return std::nullopt;
+    }
+    return data / (CHANNELS * 2) * 1000 / SAMPLE_RATE;
+}
+
+int main(int argc, char* argv[]) {
+    int     rounds = 3;
+    QString fixture;
+    QString dir = QDir::tempPath();
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::max(std::stoi(argv[++i]), 1);
+        } else if (arg == "--pcm" && i + 1 < argc) {
+            fixture = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+    std::vector<int16> pcm;
+    if (fixture.isEmpty()) {
+        pcm = synthesize();
+    } else {
+        QFile file(fixture);
+        if (!file.open(QIODevice::ReadOnly) || file.size() < SAMPLE_RATE * CHANNELS * 2) {
+            spdlog::error("{} can't be read or holds less than a second.", fixture.toStdString());
+            return 1;
+        }
+        auto data = file.readAll();
+        pcm.resize(data.size() / sizeof(int16));
+        memcpy(pcm.data(), data.constData(), pcm.size() * sizeof(int16));
+    }
+
+    uint32 seed   = (uint32)::getpid();
+    auto   failed = false;
+    for (auto& profile : RecordingProfile::getPresets()) {
+        for (int round = 0; round < rounds; round++) {
+            auto name = QString("recovery-%1-%2%3").arg(profile.mName).arg(round).arg(profile.getSuffix());
+            auto path = QDir(dir).filePath(name);
+            QFile::remove(path);
+            // Written by AudioRecorder when the recording starts, before any audio.
+            RecordingJournal journal{path, profile.mFormat, SAMPLE_RATE, CHANNELS};
+            if (!journal.save()) {
+                spdlog::error("Unable to write the journal, is the PenMods cache directory writable?");
+                return 1;
+            }
+            // The first round is always killed before the first checkpoint.
+            seed       = seed * 1664525 + 1013904223;
+            auto limit = round == 0 ? CHECKPOINT_MS : MAX_RUN_MS;
+            auto runMs = MIN_RUN_MS + (int)(seed >> 8) % (limit - MIN_RUN_MS);
+
+            QElapsedTimer timer;
+            timer.start();
+            auto child = ::fork();
+            if (child < 0) {
+                spdlog::error("Unable to fork.");
+                return 1;
+            }
+            if (child == 0) {
+                record(profile, path, pcm);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(runMs));
+            ::kill(child, SIGKILL);
+            ::waitpid(child, nullptr, 0);
+            auto recordedMs = timer.elapsed();
+
+            // What AudioRecorder does at the next start.
+            auto loaded = RecordingJournal::load();
+            auto ok     = loaded && loaded->mPath == path && loaded->repair();
+            RecordingJournal::remove();
+            // Nothing may have reached the file before the first checkpoint, repair() then removes it.
+            if (ok && !QFile::exists(path)) {
+                if (recordedMs < CHECKPOINT_MS + STARTUP_MS) {
+                    spdlog::info(
+                        "{:<9} killed after {:>5}ms, before the first checkpoint, removed.",
+                        profile.mName,
+                        recordedMs
+                    );
+                    continue;
+                }
+                spdlog::error("{}: removed although killed after {}ms.", path.toStdString(), recordedMs);
+                failed = true;
+                continue;
+            }
+            std::optional<int64> keptMs;
+            if (ok) {
+                keptMs = profile.mFormat == RecordingProfile::Format::Wav ? checkWav(path) : checkMp3(path);
+            }
+            if (!keptMs) {
+                spdlog::error("{}: not repaired after {}ms.", path.toStdString(), recordedMs);
+                failed = true;
+                continue;
+            }
+            spdlog::info(
+                "{:<9} killed after {:>5}ms, {:>5}ms kept, {:>4}ms lost.",
+                profile.mName,
+                recordedMs,
+                *keptMs,
+                recordedMs - *keptMs
+            );
+            QFile::remove(path);
+        }
+    }
+    return failed ? 1 : 0;
+}
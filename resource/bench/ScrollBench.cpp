@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Scrolls a ListView with a file manager delegate through a synthetic folder, one step per frame, and reports
+// frame times. --uncached resolves role values from QFileInfo on every data() call, as before the role cache.
+// Without a display, run it with QT_QPA_PLATFORM=offscreen.
+//
+//   ScrollBench [--files 2000] [--step 24] [--uncached]
+
+#include "filemanager/FileEntity.h"
+#include "filemanager/FileSorter.h"
+
+#include <QAbstractListModel>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QQmlComponent>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QTemporaryDir>
+
+#include <numeric>
+
+using namespace mod::filemanager;
+
+// The roles of FileManager, under the same names.
+enum class Role { FileName = Qt::UserRole + 1, IsDirectory, SizeString, ExtensionName, ExtensionIcon, Title, Artist };
+
+class EntityModel : public QAbstractListModel {
+public:
+    EntityModel(std::vector<FileEntity> entities, bool uncached)
+    : mEntities(std::move(entities)),
+      mUncached(uncached) {}
+
+    [[nodiscard]] int rowCount(const QModelIndex&) const override { return (int)mEntities.size(); }
+
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role) const override {
+        mCalls++;
+        auto& entity = mEntities[index.row()];
+        if (mUncached) {
+            auto& info = *entity.mInfo;
+            switch ((Role)role) {
+            case Role::FileName:
+                return info.fileName();
+            case Role::IsDirectory:
+                return info.isDir();
+            case Role::SizeString:
+                return info.isDir() ? QString("…") : formatSize(info.size());
+            case Role::ExtensionName:
+                return info.suffix().toLower();
+            case Role::ExtensionIcon:
+                return getExtIcon(info.suffix().toLower(), info.isDir());
+            default:
+                return QString();
+            }
+        }
+        // As FileManager::data().
+        switch ((Role)role) {
+        case Role::FileName:
+            return entity.mFileName;
+        case Role::IsDirectory:
+            return entity.mIsDir;
+        case Role::SizeString:
+            return entity.mSizeString;
+        case Role::ExtensionName:
+            return entity.mExtName;
+        case Role::ExtensionIcon:
+            return entity.getExtIcon();
+        case Role::Title:
+            return entity.mTitle;
+        case Role::Artist:
+            return entity.mArtist;
+        default:
+            return {};
+        }
+    }
+
+    [[nodiscard]] QHash<int, QByteArray> roleNames() const override {
+        return QHash<int, QByteArray>{
+            {(int)Role::FileName,      "fileName"},
+            {(int)Role::IsDirectory,   "isDir"   },
+            {(int)Role::SizeString,    "sizeStr" },
+            {(int)Role::ExtensionName, "extName" },
+            {(int)Role::ExtensionIcon, "extIcon" },
+            {(int)Role::Title,         "title"   },
+            {(int)Role::Artist,        "artist"  }
+        };
+    }
+
+    [[nodiscard]] uint64 getCalls() const { return mCalls; }
+
+private:
+    std::vector<FileEntity> mEntities;
+    bool                    mUncached;
+    mutable uint64          mCalls{};
+};
+
+// Close to the file list of the pen, the icon is bound but not loaded since the qrc isn't there.
+static const char* DELEGATE_QML = R"(
+import QtQuick 2.12
+
+ListView {
+    width: 560
+    height: 320
+    model: entities
+    delegate: Item {
+        width: ListView.view.width
+        height: 48
+        property string icon: extIcon
+        Rectangle { anchors.fill: parent; color: index % 2 ? "#1A1B1F" : "#24252A" }
+        Column {
+            x: 52
+            anchors.verticalCenter: parent.verticalCenter
+            Text { text: title.length ? title : fileName; color: "white"; font.pixelSize: 18; elide: Text.ElideRight }
+            Text { text: isDir ? "文件夹" : (artist.length ? artist : extName + " · " + sizeStr); color: "#888" }
+        }
+        Text { anchors.right: parent.right; anchors.rightMargin: 12; text: sizeStr; color: "#888" }
+    }
+}
+)";
+
+static std::vector<FileEntity> createEntities(const QString& dir, int count) {
+    static const char* suffixes[] = {"mp3", "txt", "lrc", "md", "json", "mp4", "bin"};
+    for (int i = 0; i < count; i++) {
+        if (i % 10 == 0) {
+            QDir(dir).mkdir(QString("第%1课").arg(i));
+            continue;
+        }
+        QFile file(QDir(dir).filePath(QString("Track %1 - 歌曲.%2").arg(i).arg(suffixes[i % std::size(suffixes)])));
+        if (file.open(QIODevice::WriteOnly)) {
+            file.resize(i * 1024);
+        }
+    }
+    std::vector<FileEntity> entities;
+    for (auto& info : QDir(dir).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDir::Unsorted)) {
+        entities.emplace_back(info);
+    }
+    sortEntities(entities, QDir::Name, false);
+    return entities;
+}
+
+int main(int argc, char* argv[]) {
+    QGuiApplication app(argc, argv);
+
+    int  files    = 2000;
+    int  step     = 24; // px per frame, a brisk fling.
+    bool uncached = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--files" && i + 1 < argc) {
+            files = std::max(std::stoi(argv[++i]), 100);
+        } else if (arg == "--step" && i + 1 < argc) {
+            step = std::max(std::stoi(argv[++i]), 1);
+        } else if (arg == "--uncached") {
+            uncached = true;
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        spdlog::error("Failed to create the folder.");
+        return 1;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    EntityModel model(createEntities(dir.path(), files), uncached);
+    spdlog::info("{} entries loaded and sorted in {}ms.", model.rowCount({}), timer.elapsed());
+
+    QQmlEngine engine;
+    engine.rootContext()->setContextProperty("entities", &model);
+    QQmlComponent component(&engine);
+    component.setData(DELEGATE_QML, {});
+    auto* list = qobject_cast<QQuickItem*>(component.create());
+    if (!list) {
+        spdlog::error("Failed to create the list: {}", component.errorString().toStdString());
+        return 1;
+    }
+    QQuickWindow window;
+    window.resize((int)list->width(), (int)list->height());
+    list->setParentItem(window.contentItem());
+    window.show();
+
+    // Every swapped frame moves the list one step further, until the end of it.
+    std::vector<double> frames;
+    QElapsedTimer       frameTimer;
+    QObject::connect(&window, &QQuickWindow::frameSwapped, &app, [&]() {
+        if (frameTimer.isValid()) {
+            frames.emplace_back((double)frameTimer.nsecsElapsed() / 1e6);
+        }
+        frameTimer.start();
+        // contentHeight is an estimate that firms up as delegates are created.
+        auto maxY = list->property("contentHeight").toDouble() - list->height();
+        auto y    = list->property("contentY").toDouble();
+        if (y >= maxY) {
+            app.quit();
+            return;
+        }
+        list->setProperty("contentY", std::min(y + step, maxY));
+    });
+    auto calls = model.getCalls();
+    app.exec();
+
+    if (frames.empty()) {
+        spdlog::error("No frame was rendered.");
+        return 1;
+    }
+    std::sort(frames.begin(), frames.end());
+    auto percentile = [&](double p) { return frames[std::min((size_t)(p * frames.size()), frames.size() - 1)]; };
+    auto mean       = std::accumulate(frames.begin(), frames.end(), 0.0) / frames.size();
+    spdlog::info(
+        "{} frames ({}): mean {:.2f}ms, p50 {:.2f}ms, p95 {:.2f}ms, p99 {:.2f}ms, max {:.2f}ms, {} data() calls.",
+        frames.size(),
+        uncached ? "uncached" : "cached",
+        mean,
+        percentile(0.5),
+        percentile(0.95),
+        percentile(0.99),
+        frames.back(),
+        model.getCalls() - calls
+    );
+    return 0;
+}
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Builds the search index over a synthetic music tree (artist/album/track, Chinese and Latin names), then times
+// saving, loading, refreshing, updating a folder and answering typical queries.
+//
+//   SearchIndexBench [--files 100000] [--root /path/to/tree] [--queries 200]
+
+#include "filemanager/search/SearchIndex.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace mod::filemanager;
+
+static const QStringList SYLLABLES = {"七里", "香",   "晴天", "稻香", "夜曲", "青花", "瓷",   "东风",
+                                      "破",   "告白", "气球", "Love", "Song", "Blue", "Moon", "River"};
+
+// Deterministic names, so that runs compare.
+static QString makeName(uint32& seed, int parts) {
+    QString name;
+    for (int i = 0; i < parts; i++) {
+        seed  = seed * 1664525 + 1013904223;
+        name += SYLLABLES[(int)(seed >> 16) % SYLLABLES.size()];
+    }
+    return name;
+}
+
+// 100 tracks per album, 10 albums per artist.
+static bool createTree(const QString& root, int files) {
+    uint32  seed = 1;
+    QString album;
+    for (int track = 0; track < files; track++) {
+        if (track % 100 == 0) {
+            album = QString("%1/%2 %3").arg(track / 1000).arg(track / 100 % 10).arg(makeName(seed, 2));
+            if (!QDir(root).mkpath(album)) {
+                return false;
+            }
+        }
+        auto path = QString("%1/%2/%3 %4.mp3").arg(root, album).arg(track % 100 + 1, 2, 10, QChar('0'));
+        if (!QFile(path.arg(makeName(seed, 3))).open(QIODevice::WriteOnly)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+static double measure(T&& task) {
+    QElapsedTimer timer;
+    timer.start();
+    task();
+    return (double)timer.nsecsElapsed() / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    int     files   = 100000;
+    int     queries = 200;
+    QString root;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--files" && i + 1 < argc) {
+            files = std::max(std::stoi(argv[++i]), 1000);
+        } else if (arg == "--root" && i + 1 < argc) {
+            root = argv[++i];
+        } else if (arg == "--queries" && i + 1 < argc) {
+            queries = std::max(std::stoi(argv[++i]), 1);
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+
+    QTemporaryDir temp;
+    if (!temp.isValid()) {
+        spdlog::error("Failed to create a temporary folder.");
+        return 1;
+    }
+    if (root.isEmpty()) {
+        root = temp.filePath("Music");
+        auto ms = measure([&]() {
+            if (!createTree(root, files)) {
+                root.clear();
+            }
+        });
+        if (root.isEmpty()) {
+            spdlog::error("Failed to create the tree.");
+            return 1;
+        }
+        spdlog::info("Created {} files in {:.0f}ms.", files, ms);
+    }
+
+    SearchIndex index(root);
+    auto        buildMs = measure([&]() { index.build(); });
+    spdlog::info("Built the index of {} entries in {:.0f}ms.", index.size(), buildMs);
+
+    auto cache  = temp.filePath("search.index");
+    auto saveMs = measure([&]() { index.save(cache); });
+    spdlog::info("Saved in {:.0f}ms, {} KB.", saveMs, QFileInfo(cache).size() / 1024);
+
+    SearchIndex loaded(root);
+    auto        loadOk = false;
+    auto        loadMs = measure([&]() { loadOk = loaded.load(cache); });
+    if (!loadOk || loaded.size() != index.size()) {
+        spdlog::error("The saved index doesn't load back.");
+        return 1;
+    }
+    auto refreshMs = measure([&]() { loaded.refresh(); });
+    spdlog::info("Loaded in {:.0f}ms, refreshed with nothing changed in {:.0f}ms.", loadMs, refreshMs);
+
+    // Removed again, --root may be a real library.
+    auto dir   = loaded.getDirPaths().value(1);
+    auto added = QDir(dir).filePath("New Track.mp3");
+    QFile(added).open(QIODevice::WriteOnly);
+    auto updateMs = measure([&]() { loaded.update(dir); });
+    auto found    = !loaded.query("new track", 10).empty();
+    QFile::remove(added);
+    if (!found) {
+        spdlog::error("The new file can't be found.");
+        return 1;
+    }
+    spdlog::info("Updated a folder with a new file in {:.2f}ms.", updateMs);
+
+    spdlog::info("{:<12} {:>6} | {:>9} {:>9} {:>9}", "query", "hits", "p50(ms)", "p99(ms)", "max(ms)");
+    for (auto text : {"晴天", "七里香", "love", "songblue", "qlx", "gbqq", "01", "zzzz"}) {
+        std::vector<double> times;
+        size_t              hits = 0;
+        for (int i = 0; i < queries; i++) {
+            times.emplace_back(measure([&]() { hits = loaded.query(text, 200).size(); }));
+        }
+        std::sort(times.begin(), times.end());
+        spdlog::info(
+            "{:<12} {:>6} | {:>9.3f} {:>9.3f} {:>9.3f}",
+            text,
+            hits,
+            times[times.size() / 2],
+            times[std::min(times.size() * 99 / 100, times.size() - 1)],
+            times.back()
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// Checks the shuffle order random mode plays in, and how much a step costs on a large play list.
+// Exits with 1 if a check fails.
+//
+//   ShuffleQueueBench [--size 65536]
+
+#include "filemanager/player/ShuffleQueue.h"
+
+#include <QElapsedTimer>
+
+#include <set>
+
+using namespace mod::filemanager;
+
+static bool gFailed = false;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        spdlog::error("Failed: {}.", what);
+        gFailed = true;
+    }
+}
+
+// Every track once per round, and a round never starts with the track the previous one ended with.
+static void checkRounds() {
+    constexpr size_t SIZE   = 16;
+    constexpr int    ROUNDS = 20000;
+
+    ShuffleQueue          queue;
+    std::vector<int64>    firsts(SIZE);
+    std::optional<size_t> last;
+    bool                  complete = true, repeated = false;
+    queue.reset(SIZE);
+    for (int round = 0; round < ROUNDS; round++) {
+        std::set<size_t> seen;
+        for (size_t i = 0; i < SIZE; i++) {
+            auto idx = *queue.next();
+            if (i == 0) {
+                firsts[idx]++;
+                repeated |= last == idx;
+            }
+            seen.insert(idx);
+            last = idx;
+        }
+        complete &= seen.size() == SIZE;
+    }
+    check(complete, "every track is played once per round");
+    check(!repeated, "no track is played twice in a row across rounds");
+
+    // Chi-square of the first track of each round, 15 degrees of freedom, p = 0.001 at 37.7.
+    // The track that ended the previous round is excluded, which is a small bias the bound allows for.
+    double expected = (double)ROUNDS / SIZE, chi = 0;
+    for (auto count : firsts) {
+        chi += (count - expected) * (count - expected) / expected;
+    }
+    spdlog::info("First track of a round: chi-square {:.1f} over {} rounds.", chi, ROUNDS);
+    check(chi < 45, "the first track of a round is uniformly distributed");
+}
+
+static void checkHistory() {
+    ShuffleQueue queue;
+    queue.reset(100);
+    std::vector<size_t> played;
+    for (int i = 0; i < 10; i++) {
+        played.emplace_back(*queue.next());
+    }
+    check(queue.prev() == played[8] && queue.prev() == played[7], "previous walks back what was played");
+    check(queue.next() == played[8] && queue.next() == played[9], "next replays what was played after");
+    auto peeked = queue.peek();
+    check(peeked && queue.next() == peeked, "next returns what was peeked");
+}
+
+// The player peeks at the next track to preload it, the user may then choose another one or that one.
+static void checkPeek() {
+    constexpr size_t SIZE = 10;
+
+    for (auto choosePeeked : {false, true}) {
+        ShuffleQueue queue;
+        queue.reset(SIZE);
+        queue.setCurrent(0);
+        auto peeked = *queue.peek();
+        auto chosen = choosePeeked ? peeked : peeked == 1 ? 2 : 1;
+        queue.setCurrent(chosen);
+        std::set<size_t> played{0, chosen};
+        for (size_t i = 0; i < SIZE - 2; i++) {
+            played.insert(*queue.next());
+        }
+        check(
+            played.size() == SIZE,
+            choosePeeked ? "a peeked track chosen by the user is played once"
+                         : "a peeked track that wasn't played stays in the round"
+        );
+    }
+}
+
+// After an edit, the indices stay in range and the round goes on with what wasn't played.
+static void checkEdits() {
+    ShuffleQueue queue;
+    queue.reset(1000);
+    std::set<size_t> played;
+    for (int i = 0; i < 600; i++) {
+        played.insert(*queue.next());
+    }
+    queue.resize(500);
+    std::set<size_t> unplayed;
+    for (size_t idx = 0; idx < 500; idx++) {
+        if (!played.contains(idx)) {
+            unplayed.insert(idx);
+        }
+    }
+    std::set<size_t> rest;
+    for (size_t i = 0; i < unplayed.size(); i++) {
+        rest.insert(*queue.next());
+    }
+    check(rest == unplayed, "the round goes on with the tracks not played yet after truncating");
+
+    queue.remove(10);
+    queue.resize(600);
+    std::set<size_t> all;
+    for (size_t i = 0; i < 2 * 600; i++) {
+        auto idx = *queue.next();
+        check(idx < 600, "indices are in range after removing and growing");
+        all.insert(idx);
+    }
+    check(all.size() == 600, "every track is played after removing and growing");
+    check(queue.prev().has_value(), "the history survives edits");
+}
+
+// A step costs the same at the start and at the end of a round.
+static void benchSteps(size_t size) {
+    constexpr size_t SAMPLE = 4096;
+
+    ShuffleQueue queue;
+    queue.reset(size);
+    auto time = [&](size_t steps) {
+        QElapsedTimer timer;
+        timer.start();
+        for (size_t i = 0; i < steps; i++) {
+            queue.next();
+        }
+        return (double)timer.nsecsElapsed() / (double)steps;
+    };
+    auto first = time(SAMPLE);
+    time(size - 2 * SAMPLE);
+    auto last = time(SAMPLE);
+    spdlog::info("{} tracks: {:.0f}ns per step at the start of a round, {:.0f}ns at the end.", size, first, last);
+    check(last < first * 4 + 200, "a step costs O(1) whatever the position in the round");
+
+    QElapsedTimer timer;
+    timer.start();
+    queue.resize(size / 2);
+    spdlog::info("Truncated to {} tracks in {}us.", size / 2, timer.nsecsElapsed() / 1000);
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = 65536;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) {
+            size = std::max<size_t>(std::stoul(argv[++i]), 16 * 1024);
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+    checkRounds();
+    checkHistory();
+    checkPeek();
+    checkEdits();
+    benchSteps(size);
+    return gFailed ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+// UTF-8 validation throughput of TextReader's encoding detection, against a byte by byte validator, on text
+// shaped like what the pen opens: English, Chinese, and a novel mixing both. Built for the pen it runs the NEON
+// path, on an x86 host the SSE2 one. Exits with 1 if both validators disagree on a corrupted buffer.
+//
+//   Utf8Bench [--mb 16] [--rounds 5]
+
+#include "common/util/TextEncoding.h"
+
+#include <QElapsedTimer>
+
+using namespace mod;
+
+static uint32 nextRandom(uint32& seed) { return seed = seed * 1664525 + 1013904223; }
+
+// The rules of RFC 3629, one byte at a time.
+static size_t referenceValidate(const uint8* data, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        auto   lead = data[i];
+        size_t length;
+        uint32 code;
+        if (lead < 0x80) {
+            i++;
+            continue;
+        } else if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            code   = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            code   = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            code   = lead & 0x07;
+        } else {
+            return i;
+        }
+        if (i + length > size) {
+            return i;
+        }
+        for (size_t j = 1; j < length; j++) {
+            if ((data[i + j] & 0xC0) != 0x80) {
+                return i;
+            }
+            code = code << 6 | (data[i + j] & 0x3F);
+        }
+        static constexpr uint32 minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (code < minimum[length] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+            return i;
+        }
+        i += length;
+    }
+    return size;
+}
+
+static QByteArray makeText(size_t size, int chinesePercent, uint32 seed) {
+    static const QString words[] = {"the ", "reader ", "page ", "chapter ", "and ", "of ", "a ", "story "};
+    QString              text;
+    while ((size_t)text.size() * 2 < size) {
+        nextRandom(seed);
+        if ((int)(seed >> 8) % 100 < chinesePercent) {
+            text += QChar(0x4E00 + (seed >> 12) % 0x5000); // CJK unified ideographs
+        } else {
+            text += words[(seed >> 16) % std::size(words)];
+        }
+        if ((seed >> 4) % 64 == 0) {
+            text += "\n";
+        }
+    }
+    auto data = text.toUtf8();
+    data.truncate((int)util::findCharBoundary(data.constData(), data.size(), size, util::TextEncoding::Utf8));
+    return data;
+}
+
+template <typename T>
+static double bestMBps(const QByteArray& data, int rounds, T&& validate) {
+    double best = 0;
+    for (int i = 0; i < rounds; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        auto valid = validate((const uint8*)data.constData(), (size_t)data.size());
+        auto ns    = (double)std::max<qint64>(timer.nsecsElapsed(), 1);
+        if (valid != (size_t)data.size()) {
+            spdlog::error("Valid text was rejected at {}.", valid);
+            return 0;
+        }
+        best = std::max(best, (double)data.size() / ns * 1e3);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = 16;
+    int    rounds    = 5;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mb" && i + 1 < argc) {
+            megabytes = std::max(std::stoul(argv[++i]), 1ul);
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = std::max(std::stoi(argv[++i]), 1);
+        } else {
+            spdlog::error("Unknown argument {}.", arg);
+            return 1;
+        }
+    }
+#if defined(__ARM_NEON)
+    spdlog::info("Vector path: NEON.");
+#elif defined(__SSE2__)
+    spdlog::info("Vector path: SSE2.");
+#else
+    spdlog::info("Vector path: none, scalar only.");
+#endif
+
+    spdlog::info("{:<8} {:>6} | {:>10} {:>10} {:>8}", "text", "MB", "fast MB/s", "ref MB/s", "speedup");
+    auto failed = false;
+    for (auto [name, chinese] : {std::pair{"english", 0}, std::pair{"chinese", 100}, std::pair{"novel", 60}}) {
+        auto data = makeText(megabytes << 20, chinese, 1);
+        auto fast = bestMBps(data, rounds, [](const uint8* bytes, size_t size) {
+            return util::validateUtf8((const char*)bytes, size);
+        });
+        auto reference = bestMBps(data, rounds, referenceValidate);
+        failed        |= fast == 0 || reference == 0;
+        spdlog::info(
+            "{:<8} {:>6} | {:>10.0f} {:>10.0f} {:>7.1f}x",
+            name,
+            megabytes,
+            fast,
+            reference,
+            reference > 0 ? fast / reference : 0
+        );
+    }
+
+    // Both have to stop at the same byte, whatever was broken.
+    auto   sample = makeText(4096, 30, 2);
+    uint32 seed   = 3;
+    for (int trial = 0; trial < 100000; trial++) {
+        auto broken = sample;
+        for (int flips = 0; flips < 1 + trial % 3; flips++) {
+            auto random = nextRandom(seed);
+            auto pos    = (int)((random >> 8) % broken.size());
+            broken[pos] = (char)(random >> 24);
+        }
+        auto fast      = util::validateUtf8(broken.constData(), broken.size());
+        auto reference = referenceValidate((const uint8*)broken.constData(), broken.size());
+        if (fast != reference) {
+            spdlog::error("Trial {}: validated up to {}, {} expected.", trial, fast, reference);
+            failed = true;
+            break;
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "common/util/Pinyin.h"
+
+#include <QTextCodec>
+
+namespace mod::util {
+
+constexpr char16_t CJK_BEGIN = 0x4E00;
+constexpr char16_t CJK_END   = 0x9FA6;
+
+// Converting through QTextCodec for every character is far too slow,
+// so the whole CJK block is encoded once and kept as a table (~41KB).
+static std::vector<uint16> const& gbTable() {
+    static std::vector<uint16> table = []() {
+        std::vector<uint16> ret(CJK_END - CJK_BEGIN, 0);
+        auto*               codec = QTextCodec::codecForName("GB2312");
+        if (!codec) {
+            spdlog::warn("GB2312 codec is unavailable, pinyin features are disabled.");
+            return ret;
+        }
+        QString all;
+        all.reserve(CJK_END - CJK_BEGIN);
+        for (char16_t ch = CJK_BEGIN; ch < CJK_END; ch++) {
+            all.append(QChar(ch));
+        }
+        QTextCodec::ConverterState state(QTextCodec::ConvertInvalidToNull);
+        auto                       bytes = codec->fromUnicode(all.constData(), all.size(), &state);
+        // Every character becomes exactly one byte (invalid -> '\0') or two bytes.
+        for (int i = 0, j = 0; i < bytes.size() && j < (int)ret.size(); j++) {
+            auto hi = (uchar)bytes[i];
+            if (hi < 0x80) {
+                i++;
+                continue;
+            }
+            // GB2312 only, GBK extensions (trail byte < 0xA1) don't follow the pinyin order.
+            if (i + 1 < bytes.size() && hi >= 0xA1 && (uchar)bytes[i + 1] >= 0xA1) {
+                ret[j] = (uint16)(hi << 8 | (uchar)bytes[i + 1]);
+            }
+            i += 2;
+        }
+        return ret;
+    }();
+    return table;
+}
+
+uint16 getGbCode(QChar ch) {
+    auto unicode = ch.unicode();
+    if (unicode < CJK_BEGIN || unicode >= CJK_END) {
+        return 0;
+    }
+    return gbTable()[unicode - CJK_BEGIN];
+}
+
+char getPinyinInitial(QChar ch) {
+    // The first level-1 character of each initial, i/u/v have none.
+    static constexpr struct {
+        uint16 mCode;
+        char   mInitial;
+    } bounds[] = {
+        {0xB0A1, 'a'},
+        {0xB0C5, 'b'},
+        {0xB2C1, 'c'},
+        {0xB4EE, 'd'},
+        {0xB6EA, 'e'},
+        {0xB7A2, 'f'},
+        {0xB8C1, 'g'},
+        {0xB9FE, 'h'},
+        {0xBBF7, 'j'},
+        {0xBFA6, 'k'},
+        {0xC0AC, 'l'},
+        {0xC2E8, 'm'},
+        {0xC4C3, 'n'},
+        {0xC5B6, 'o'},
+        {0xC5BE, 'p'},
+        {0xC6DA, 'q'},
+        {0xC8BB, 'r'},
+        {0xC8F6, 's'},
+        {0xCBFA, 't'},
+        {0xCDDA, 'w'},
+        {0xCEF4, 'x'},
+        {0xD1B9, 'y'},
+        {0xD4D1, 'z'},
+        {0xD7FA, 0  }, // end of level-1.
+    };
+    auto code = getGbCode(ch);
+    if (code < bounds[0].mCode || code >= bounds[std::size(bounds) - 1].mCode) {
+        return 0;
+    }
+    auto it = std::upper_bound(std::begin(bounds), std::end(bounds), code, [](uint16 code, const auto& bound) {
+        return code < bound.mCode;
+    });
+    return (it - 1)->mInitial;
+}
+
+QString toPinyinInitials(const QString& str) {
+    QString ret;
+    ret.reserve(str.size());
+    for (auto ch : str) {
+        auto initial = getPinyinInitial(ch);
+        ret.append(initial ? QChar(QLatin1Char(initial)) : ch.toLower());
+    }
+    return ret;
+}
+
+} // namespace mod::util
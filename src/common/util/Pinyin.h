@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+namespace mod::util {
+
+// GB2312 code of a CJK character, or 0 if it has none.
+// Level-1 characters (0xB0A1 ~ 0xD7F9) are ordered by pinyin, which makes the code usable as a collation key.
+uint16 getGbCode(QChar ch);
+
+// Lower-case pinyin initial of a level-1 GB2312 character, or 0 if unknown.
+char getPinyinInitial(QChar ch);
+
+// "第10课abc" -> "d10kabc", characters without an initial are kept as they are (lower-cased).
+QString toPinyinInitials(const QString& str);
+
+} // namespace mod::util
@@ -6,6 +6,8 @@
 
 #include "System.h"
 
+#include <QDir>
+
 #include <dlfcn.h>
 #include <unistd.h>
 
@@ -23,4 +25,13 @@ QFileInfo getApplicationFileInfo() {
     return QFileInfo(path);
 }
 
+QString getCachePath(const QString& name) {
+    static const QString dir = []() {
+        QString path = "/userdisk/.PenMods/cache";
+        QDir().mkpath(path);
+        return path;
+    }();
+    return dir + "/" + name;
+}
+
 } // namespace mod::util
\ No newline at end of file
@@ -14,4 +14,8 @@ extern QFileInfo getModuleFileInfo();
 
 extern QFileInfo getApplicationFileInfo();
 
+// Persistent caches live on the user partition, which survives system updates.
+// The directory is created on demand.
+extern QString getCachePath(const QString& name);
+
 } // namespace mod::util
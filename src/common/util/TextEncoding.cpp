@@ -0,0 +1,281 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "common/util/TextEncoding.h"
+
+#include <QTextCodec>
+#include <QtEndian>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mod::util {
+
+constexpr size_t SAMPLE_SIZE       = 64 * 1024;
+constexpr size_t UTF16_SAMPLE_SIZE = 4096;
+
+static size_t skipAscii(const uint8* data, size_t size) {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= size; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(data + i)) >= 0x80) {
+            break;
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(data + i)))) {
+            break;
+        }
+    }
+#endif
+    while (i < size && data[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+// Length of the UTF-8 sequence starting at `data`, 0 if it is invalid or cut by `size`.
+static size_t utf8Length(const uint8* data, size_t size) {
+    auto   lead = data[0];
+    size_t length;
+    uint8  low  = 0x80;
+    uint8  high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) low = 0xA0;  // overlong
+        if (lead == 0xED) high = 0x9F; // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) low = 0x90;  // overlong
+        if (lead == 0xF4) high = 0x8F; // above U+10FFFF
+    } else {
+        return 0;
+    }
+    if (length > size || data[1] < low || data[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; i++) {
+        if ((data[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Length of the GB18030 character starting at a byte >= 0x80, 0 if it is invalid or cut by `size`.
+static size_t gb18030Length(const uint8* data, size_t size) {
+    if (data[0] < 0x81 || data[0] == 0xFF || size < 2) {
+        return 0;
+    }
+    if (data[1] >= 0x40 && data[1] <= 0xFE && data[1] != 0x7F) {
+        return 2;
+    }
+    if (size >= 4 && data[1] >= 0x30 && data[1] <= 0x39 && data[2] >= 0x81 && data[2] <= 0xFE && data[3] >= 0x30
+        && data[3] <= 0x39) {
+        return 4;
+    }
+    return 0;
+}
+
+size_t validateUtf8(const char* data, size_t size) {
+    auto*  bytes = (const uint8*)data;
+    size_t i     = 0;
+    while (i < size) {
+        if (bytes[i] < 0x80) {
+            i += skipAscii(bytes + i, size - i);
+            continue;
+        }
+        auto length = utf8Length(bytes + i, size - i);
+        if (!length) {
+            return i;
+        }
+        i += length;
+    }
+    return size;
+}
+
+bool isUtf8(const char* data, size_t size, bool truncated) {
+    auto valid = validateUtf8(data, size);
+    if (valid == size) {
+        return true;
+    }
+    if (!truncated || size - valid >= 4) {
+        return false;
+    }
+    // Only an incomplete sequence may be left.
+    auto   lead   = (uint8)data[valid];
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 0;
+    if (size - valid >= length) {
+        return false;
+    }
+    return std::all_of(data + valid + 1, data + size, [](char c) { return ((uint8)c & 0xC0) == 0x80; });
+}
+
+// Mostly ASCII text has a zero in every other byte.
+static std::optional<TextEncoding> guessUtf16(const uint8* data, size_t size) {
+    size = std::min(size, UTF16_SAMPLE_SIZE) & ~(size_t)1;
+    if (size < 16) {
+        return std::nullopt;
+    }
+    size_t evenZeros = 0;
+    size_t oddZeros  = 0;
+    for (size_t i = 0; i < size; i += 2) {
+        evenZeros += data[i] == 0;
+        oddZeros += data[i + 1] == 0;
+    }
+    auto units = size / 2;
+    if (oddZeros * 10 >= units * 4 && evenZeros * 20 < units) {
+        return TextEncoding::Utf16LE;
+    }
+    if (evenZeros * 10 >= units * 4 && oddZeros * 20 < units) {
+        return TextEncoding::Utf16BE;
+    }
+    return std::nullopt;
+}
+
+// Well-formed double and four byte characters, a few stray bytes are tolerated.
+static bool looksLikeGb18030(const uint8* data, size_t size, bool truncated) {
+    size_t chars  = 0;
+    size_t errors = 0;
+    for (size_t i = 0; i < size;) {
+        if (data[i] < 0x80) {
+            i++;
+            continue;
+        }
+        if (auto length = gb18030Length(data + i, size - i)) {
+            chars++;
+            i += length;
+            continue;
+        }
+        if (truncated && size - i < 4) {
+            break;
+        }
+        errors++;
+        i++;
+    }
+    return chars > 0 && errors * 100 <= chars;
+}
+
+DetectedEncoding detectEncoding(const char* data, size_t size) {
+    auto* bytes = (const uint8*)data;
+    if (size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+        return {TextEncoding::Utf8, 3};
+    }
+    if (size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE) {
+        return {TextEncoding::Utf16LE, 2};
+    }
+    if (size >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF) {
+        return {TextEncoding::Utf16BE, 2};
+    }
+    auto sample = std::min(size, SAMPLE_SIZE);
+    if (auto utf16 = guessUtf16(bytes, sample)) {
+        return {*utf16, 0};
+    }
+    if (isUtf8(data, sample, sample < size)) {
+        return {TextEncoding::Utf8, 0};
+    }
+    if (looksLikeGb18030(bytes, sample, sample < size)) {
+        return {TextEncoding::Gb18030, 0};
+    }
+    return {TextEncoding::Utf8, 0};
+}
+
+size_t findCharBoundary(const char* data, size_t size, size_t pos, TextEncoding encoding) {
+    auto* bytes = (const uint8*)data;
+    if (pos >= size) {
+        return size;
+    }
+    switch (encoding) {
+    case TextEncoding::Utf8:
+        while (pos > 0 && (bytes[pos] & 0xC0) == 0x80) {
+            pos--;
+        }
+        return pos;
+    case TextEncoding::Utf16LE:
+    case TextEncoding::Utf16BE: {
+        pos &= ~(size_t)1;
+        if (pos >= 2) {
+            // Don't split a surrogate pair.
+            auto high = encoding == TextEncoding::Utf16LE ? bytes[pos - 1] : bytes[pos - 2];
+            if (high >= 0xD8 && high <= 0xDB) {
+                pos -= 2;
+            }
+        }
+        return pos;
+    }
+    case TextEncoding::Gb18030: {
+        // Trail bytes overlap ASCII and lead bytes, only a forward walk knows where characters start.
+        size_t i = 0;
+        while (i < pos) {
+            auto length = bytes[i] < 0x80 ? 1 : std::max(gb18030Length(bytes + i, size - i), (size_t)1);
+            if (i + length > pos) {
+                break;
+            }
+            i += length;
+        }
+        return i;
+    }
+    }
+    return pos;
+}
+
+QString decodeText(const char* data, size_t size, TextEncoding encoding) {
+    switch (encoding) {
+    case TextEncoding::Utf16LE:
+    case TextEncoding::Utf16BE: {
+        QString text((int)(size / 2), Qt::Uninitialized);
+        if (encoding == TextEncoding::Utf16LE) {
+            qFromLittleEndian<char16_t>(data, text.size(), text.data());
+        } else {
+            qFromBigEndian<char16_t>(data, text.size(), text.data());
+        }
+        return text;
+    }
+    case TextEncoding::Gb18030: {
+        static auto* gb = QTextCodec::codecForName("GB18030");
+        if (gb) {
+            return gb->toUnicode(data, (int)size);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return QString::fromUtf8(data, (int)size);
+}
+
+QByteArray encodeText(const QString& text, TextEncoding encoding) {
+    switch (encoding) {
+    case TextEncoding::Utf16LE:
+    case TextEncoding::Utf16BE: {
+        QByteArray bytes(text.size() * 2, Qt::Uninitialized);
+        if (encoding == TextEncoding::Utf16LE) {
+            qToLittleEndian<char16_t>(text.constData(), text.size(), bytes.data());
+        } else {
+            qToBigEndian<char16_t>(text.constData(), text.size(), bytes.data());
+        }
+        return bytes;
+    }
+    case TextEncoding::Gb18030: {
+        static auto* gb = QTextCodec::codecForName("GB18030");
+        if (gb) {
+            return gb->fromUnicode(text);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return text.toUtf8();
+}
+
+} // namespace mod::util
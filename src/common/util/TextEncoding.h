@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+namespace mod::util {
+
+enum class TextEncoding : uint8 { Utf8, Utf16LE, Utf16BE, Gb18030 };
+
+struct DetectedEncoding {
+    TextEncoding mEncoding{TextEncoding::Utf8};
+    size_t       mBomSize{};
+};
+
+// Length of the longest valid UTF-8 prefix, `size` if the whole buffer is valid.
+// ASCII runs are skipped 16 bytes at a time (NEON on the device, SSE2 on x86).
+size_t validateUtf8(const char* data, size_t size);
+
+// `truncated`: the buffer is a prefix, the sequence cut by its end is accepted.
+bool isUtf8(const char* data, size_t size, bool truncated = false);
+
+// BOM first, then the first 64KB are checked for UTF-16 without BOM, UTF-8 and GB18030 in this order.
+// Text that is none of them is decoded as UTF-8, invalid bytes becoming U+FFFD.
+DetectedEncoding detectEncoding(const char* data, size_t size);
+
+// Largest character boundary not after `pos`, `data` must start on one.
+size_t findCharBoundary(const char* data, size_t size, size_t pos, TextEncoding encoding);
+
+QString decodeText(const char* data, size_t size, TextEncoding encoding);
+
+QByteArray encodeText(const QString& text, TextEncoding encoding);
+
+} // namespace mod::util
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/DiskUsage.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mod::filemanager {
+
+constexpr int MAX_WORKERS       = 2;
+constexpr int PROGRESS_INTERVAL = 200; // ms
+
+class DiskUsageJob : public QRunnable {
+public:
+    DiskUsageJob(QString path, uint32 generation) : mPath(std::move(path)), mGeneration(generation) {}
+
+    void run() override { DiskUsage::getInstance()._run(mPath, mGeneration); }
+
+private:
+    QString mPath;
+    uint32  mGeneration;
+};
+
+DiskUsage::DiskUsage() : Logger("DiskUsage") { mPool.setMaxThreadCount(MAX_WORKERS); }
+
+DiskUsage::~DiskUsage() {
+    cancelAll();
+    mPool.waitForDone();
+}
+
+void DiskUsage::request(const QString& path) { mPool.start(new DiskUsageJob(path, mGeneration)); }
+
+void DiskUsage::cancelAll() {
+    mGeneration++;
+    mPool.clear();
+}
+
+void DiskUsage::_run(const QString& path, uint32 generation) {
+    QElapsedTimer timer;
+    timer.start();
+    int64 total = 0;
+    auto  tick  = [&]() {
+        if (timer.elapsed() >= PROGRESS_INTERVAL) {
+            timer.restart();
+            emit sizeUpdated(path, total, false);
+        }
+    };
+    if (_walk(path, total, tick, generation)) {
+        emit sizeUpdated(path, total, true);
+    }
+}
+
+bool DiskUsage::_walk(const QString& path, int64& total, const std::function<void()>& tick, uint32 generation) {
+    if (generation != mGeneration) {
+        return false;
+    }
+    auto        name = QFile::encodeName(path);
+    struct stat st {};
+    if (stat(name.constData(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return true;
+    }
+    auto mtime = (int64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+
+    CachedDir dir{};
+    bool      cached = false;
+    {
+        std::lock_guard lock(mCacheMutex);
+        if (auto it = mCache.constFind(path); it != mCache.constEnd() && it->mMtime == mtime) {
+            dir    = *it;
+            cached = true;
+        }
+    }
+    // The mtime of a directory changes whenever an entry is added, removed or renamed in it.
+    if (!cached) {
+        auto fd = open(name.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return true;
+        }
+        auto* handle = fdopendir(fd);
+        if (!handle) {
+            close(fd);
+            return true;
+        }
+        dir.mMtime = mtime;
+        while (auto* entry = readdir(handle)) {
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+                continue;
+            }
+            struct stat child {};
+            if (fstatat(fd, entry->d_name, &child, AT_SYMLINK_NOFOLLOW) != 0) {
+                continue;
+            }
+            if (S_ISREG(child.st_mode)) {
+                dir.mFileBytes += child.st_size;
+            } else if (S_ISDIR(child.st_mode)) {
+                dir.mSubDirs.emplace_back(QFile::decodeName(entry->d_name));
+            }
+        }
+        closedir(handle);
+        std::lock_guard lock(mCacheMutex);
+        mCache.insert(path, dir);
+    }
+
+    total += dir.mFileBytes;
+    tick();
+    for (auto& sub : dir.mSubDirs) {
+        if (!_walk(path + "/" + sub, total, tick, generation)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "common/service/Logger.h"
+
+#include <QHash>
+#include <QThreadPool>
+
+#include <mutex>
+
+namespace mod::filemanager {
+
+// Computes recursive directory sizes in the background.
+// Every directory visited is cached with its mtime, so walking an unchanged tree again only stats directories.
+class DiskUsage : public QObject, public Singleton<DiskUsage>, private Logger {
+    Q_OBJECT
+
+public:
+    ~DiskUsage() override;
+
+    // Queue `path` (absolute), partial results are streamed through `sizeUpdated`.
+    void request(const QString& path);
+
+    // Drop queued requests and stop the running ones, e.g. when leaving the directory.
+    void cancelAll();
+
+signals:
+
+    void sizeUpdated(const QString& path, qint64 size, bool finished);
+
+private:
+    friend Singleton<DiskUsage>;
+    explicit DiskUsage();
+
+    friend class DiskUsageJob;
+
+    struct CachedDir {
+        int64                mMtime;
+        int64                mFileBytes; // regular files directly inside.
+        std::vector<QString> mSubDirs;
+    };
+
+    QThreadPool mPool;
+
+    std::mutex                mCacheMutex;
+    QHash<QString, CachedDir> mCache;
+    std::atomic<uint32>       mGeneration{};
+
+    void _run(const QString& path, uint32 generation);
+
+    // Adds the size of `path` to `total`, returns false if cancelled.
+    bool _walk(const QString& path, int64& total, const std::function<void()>& tick, uint32 generation);
+};
+
+} // namespace mod::filemanager
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/FileEntity.h"
+#include "filemanager/FileSorter.h"
+
+#include "common/Utils.h"
+
+#include <QDateTime>
+
+namespace mod::filemanager {
+
+enum class ExtIcon : uint8 { File, Folder, Mp3, Md, Txt, Json, Xml, Mp4, _Count };
+
+// QString is implicitly shared, handing out these costs a ref-count only.
+static QString const& iconUrl(ExtIcon icon) {
+    static const QString urls[] = {
+        "qrc:/images/file-empty.png",
+        "qrc:/images/folder-empty.png",
+        "qrc:/images/format/suffix-mp3.png",
+        "qrc:/images/format/suffix-md.png",
+        "qrc:/images/format/suffix-txt.png",
+        "qrc:/images/format/suffix-json.png",
+        "qrc:/images/format/suffix-xml.png",
+        "qrc:/images/format/suffix-mp4.png",
+    };
+    static_assert(std::size(urls) == (size_t)ExtIcon::_Count);
+    return urls[(uint8)icon];
+}
+
+static ExtIcon matchIcon(const QString& ext) {
+    switch (do_hash_runtime(ext.toUtf8().constData())) {
+    case H("mp3"):
+        return ExtIcon::Mp3;
+    case H("md"):
+        return ExtIcon::Md;
+    case H("txt"):
+    case H("lrc"):
+    case H("m3u"):
+    case H("m3u8"):
+        return ExtIcon::Txt;
+    case H("json"):
+        return ExtIcon::Json;
+    case H("yml"):
+    case H("yaml"):
+    case H("xml"):
+        return ExtIcon::Xml;
+    case H("avi"):
+    case H("mp4"):
+    case H("mov"):
+    case H("flv"):
+    case H("mkv"):
+    case H("webm"):
+        return ExtIcon::Mp4;
+    default:
+        return ExtIcon::File;
+    }
+}
+
+QString formatSize(int64 size) {
+    if (size <= 0) {
+        return "0B";
+    }
+    static const char* units[] = {"B", "KB", "MB", "GB"};
+    for (int i = 0; i < (int)std::size(units); i++) {
+        auto step = 1ll << (10 * (i + 1));
+        if (size <= step) {
+            return QString::number((double)size / (double)(step >> 10), 'f', 0) + units[i];
+        }
+    } // dict pen's largest storage size is 32GB, lol.
+    spdlog::error("Abnormal file size({}) detected!", size);
+    return "-1B";
+}
+
+QString const& getExtIcon(const QString& extName, bool isDir) {
+    return iconUrl(isDir ? ExtIcon::Folder : matchIcon(extName));
+}
+
+FileEntity::FileEntity(const QFileInfo& info) : mInfo(std::make_shared<QFileInfo>(info)) { _resolve(); }
+
+void FileEntity::setFile(const QString& path) {
+    mInfo->setFile(path);
+    _resolve();
+}
+
+void FileEntity::setDirSize(int64 size, bool finished) {
+    mSize       = size;
+    mSizeString = finished ? formatSize(size) : formatSize(size) + "…";
+}
+
+void FileEntity::setMetadata(const TrackMetadata& meta) {
+    mTitle          = meta.mTitle;
+    mArtist         = meta.mArtist;
+    mDurationString = meta.mDuration > 0 ? formatDuration(meta.mDuration) : QString();
+}
+
+QString const& FileEntity::getExtIcon() const { return iconUrl((ExtIcon)mIcon); }
+
+void FileEntity::_resolve() {
+    mIsDir        = mInfo->isDir();
+    mFileName     = mInfo->fileName();
+    mExtName      = mInfo->suffix().toLower();
+    mSize         = mIsDir ? 0 : mInfo->size();
+    mSizeString   = mIsDir ? QString("…") : formatSize(mSize); // Directories are filled in by DiskUsage.
+    mIcon         = (uint8)(mIsDir ? ExtIcon::Folder : matchIcon(mExtName));
+    mSortKey      = makeSortKey(mFileName);
+    mModifiedTime = mInfo->lastModified().toMSecsSinceEpoch();
+    mTitle.clear();
+    mArtist.clear();
+    mDurationString.clear();
+}
+
+} // namespace mod::filemanager
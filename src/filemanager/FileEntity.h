@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/player/TrackMetadata.h"
+
+#include <QFileInfo>
+
+namespace mod::filemanager {
+
+// Formats a byte count like "12KB", shared by every size shown in the file manager.
+QString formatSize(int64 size);
+
+// Icon url for a lower-case suffix.
+QString const& getExtIcon(const QString& extName, bool isDir);
+
+// A row of FileManager.
+// All role values are resolved once at load, so that binding a delegate never touches QFileInfo again.
+struct FileEntity {
+    explicit FileEntity(const QFileInfo& info);
+
+    // Re-resolve role values after the file was renamed.
+    void setFile(const QString& path);
+
+    // Recursive size of a directory, `finished` is false for a partial total.
+    void setDirSize(int64 size, bool finished);
+
+    // Tags of an .mp3, filled in by MetadataStore after the folder is displayed.
+    void setMetadata(const TrackMetadata& meta);
+
+    [[nodiscard]] bool isTrack() const { return !mIsDir && mExtName == "mp3"; }
+
+    [[nodiscard]] QString const& getExtIcon() const;
+
+    std::shared_ptr<QFileInfo> mInfo;
+
+    QString mFileName;
+    QString mExtName; // lower case.
+    QString mSizeString;
+    uint8   mIcon{};
+    bool    mIsDir{};
+
+    // Empty until known.
+    QString mTitle;
+    QString mArtist;
+    QString mDurationString;
+
+    // For sorting.
+    QByteArray mSortKey;
+    int64      mModifiedTime{};
+    int64      mSize{};
+
+private:
+    void _resolve();
+};
+
+} // namespace mod::filemanager
@@ -5,6 +5,9 @@
  */
 
 #include "filemanager/FileManager.h"
+#include "filemanager/DiskUsage.h"
+#include "filemanager/FileSorter.h"
+#include "filemanager/player/MetadataStore.h"
 #include "filemanager/player/MusicPlayer.h"
 
 #include "common/Event.h"
@@ -15,9 +18,11 @@
 
 #include "tweaker/ColumnDBLimiter.h"
 
+#include <QDateTime>
 #include <QFile>
 #include <QHash>
 #include <QQmlContext>
+#include <QSet>
 #include <QTimer>
 #include <QUrl>
 
@@ -30,11 +35,20 @@ FileManager::FileManager() : QAbstractListModel(), Logger("FileManager") {
 
     mCfg = Config::getInstance().read(mClassName);
 
-    mOrder            = mCfg["order"]["basic"];
-    mOrderReversed    = mCfg["order"]["reversed"];
-    mHidePairedLyrics = mCfg["hide_paired_lyrics"];
+    mOrder             = mCfg["order"]["basic"];
+    mOrderReversed     = mCfg["order"]["reversed"];
+    mHidePairedLyrics  = mCfg["hide_paired_lyrics"];
+    mNormalizeLoudness = mCfg["normalize_loudness"];
 
     connect(&mFileSystemWatcher, &QFileSystemWatcher::directoryChanged, this, &FileManager::onDirectoryChanged);
+    connect(&mPlayingWatcher, &QFileSystemWatcher::directoryChanged, [this](const QString& path) {
+        if (path == mCurrentPlayingPath) {
+            refreshPlayList();
+        }
+    });
+    connect(&FileOperator::getInstance(), &FileOperator::finished, this, &FileManager::onOperationFinished);
+    connect(&DiskUsage::getInstance(), &DiskUsage::sizeUpdated, this, &FileManager::onDirSizeUpdated);
+    connect(&MetadataStore::getInstance(), &MetadataStore::metadataReady, this, &FileManager::onMetadataReady);
     connect(&Event::getInstance(), &Event::uiCompleted, [this]() {
         if (shouldHiddenAll()) {
             QTimer::singleShot(15000, this, [&]() { setMtpOnoff(false); });
@@ -59,72 +73,23 @@ QVariant FileManager::data(const QModelIndex& index, int role) const {
 
     auto& entity = mEntities.at(row);
 
-    auto getSizeString = [&]() -> QString {
-        auto size = entity->size();
-        if (size <= 0) {
-            return "0B";
-        }
-        QList<QString> units = {"B", "KB", "MB", "GB"};
-        for (int i = 1; i < units.size() + 1; i++) {
-            auto step = pow(1024, i);
-            if ((double)size <= step) {
-                return QString::number((double)size / step * 1024.0, 'f', 0) + units.at(i - 1);
-            }
-        } // dict pen's largest storage size is 32GB, lol.
-        const_cast<FileManager*>(this)->error("Abnormal file size({}) detected!", size);
-        return "-1B";
-    };
-
-    auto getExtIcon = [&]() -> QString {
-        if (entity->isDir()) {
-            return "qrc:/images/folder-empty.png";
-        }
-        auto    ext = entity->suffix().toLower();
-        QString name;
-        switch (H(ext.toUtf8())) {
-        case H("mp3"):
-            name = "mp3";
-            break;
-        case H("md"):
-            name = "md";
-            break;
-        case H("txt"):
-        case H("lrc"):
-            name = "txt";
-            break;
-        case H("json"):
-            name = "json";
-            break;
-        case H("yml"):
-        case H("yaml"):
-        case H("xml"):
-            name = "xml";
-            break;
-        case H("avi"):
-        case H("mp4"):
-        case H("mov"):
-        case H("flv"):
-        case H("mkv"):
-        case H("webm"):
-            name = "mp4";
-            break;
-        default:
-            return "qrc:/images/file-empty.png";
-        }
-        return QString("qrc:/images/format/suffix-%1.png").arg(name);
-    };
-
     switch ((UserRoles)role) {
     case UserRoles::FileName:
-        return entity->fileName();
+        return entity.mFileName;
     case UserRoles::IsDirectory:
-        return entity->isDir();
+        return entity.mIsDir;
     case UserRoles::SizeString:
-        return getSizeString();
+        return entity.mSizeString;
     case UserRoles::ExtensionName:
-        return entity->suffix().toLower();
+        return entity.mExtName;
     case UserRoles::ExtensionIcon:
-        return getExtIcon();
+        return entity.getExtIcon();
+    case UserRoles::Title:
+        return entity.mTitle;
+    case UserRoles::Artist:
+        return entity.mArtist;
+    case UserRoles::Duration:
+        return entity.mDurationString;
     default:
         return {};
     }
@@ -136,7 +101,10 @@ QHash<int, QByteArray> FileManager::roleNames() const {
         {(int)UserRoles::IsDirectory,   "isDir"   },
         {(int)UserRoles::SizeString,    "sizeStr" },
         {(int)UserRoles::ExtensionName, "extName" },
-        {(int)UserRoles::ExtensionIcon, "extIcon" }
+        {(int)UserRoles::ExtensionIcon, "extIcon" },
+        {(int)UserRoles::Title,         "title"   },
+        {(int)UserRoles::Artist,        "artist"  },
+        {(int)UserRoles::Duration,      "duration"}
     };
 };
 
@@ -148,13 +116,12 @@ void FileManager::onDirectoryChanged(const QString& path) {
     if (url.path() == mCurrentPath.path()) {
         emit directoryChanged();
     }
-    if (path == mCurrentPlayingPath.path()) {
-        refreshPlayList();
-    }
 }
 
 QDir const& FileManager::getCurrentPath() const { return mCurrentPath; }
 
+QString const& FileManager::getRoot() const { return mRoot; }
+
 bool FileManager::changeDir(const QString& dir) {
     if (dir.isEmpty()) {
         return changeDir(mRoot);
@@ -167,6 +134,8 @@ bool FileManager::changeDir(const QString& dir) {
     emit currentTitleChanged();
     reset();
     _initCurrentDir();
+    _requestDirSizes();
+    _requestMetadata();
     loadMore();
     if (!mFileSystemWatcher.addPath(mCurrentPath.absolutePath())) {
         debug("failed to add path watcher");
@@ -207,25 +176,8 @@ void FileManager::remove(const QString& fileName) {
     if (!mCurrentPath.exists(fileName)) {
         return;
     }
-    int idx = 0;
-    for (const auto& i : mEntities) {
-        if (i->fileName() != fileName) {
-            idx++;
-            continue;
-        }
-        if (i->isDir()) {
-            exec(QString("rm -rf \"%1\"").arg(mCurrentPath.absoluteFilePath(fileName)));
-        } else {
-            mCurrentPath.remove(fileName);
-        }
-        mEntities.erase(mEntities.begin() + idx);
-        beginRemoveRows(QModelIndex(), idx, idx);
-        mProxyCount--;
-        endRemoveRows();
-        markSuspendDirChangedNotifier();
-        emit hasMoreChanged();
-        break;
-    }
+    markSuspendDirChangedNotifier();
+    FileOperator::getInstance().post(FileOperator::Type::Remove, mCurrentPath.absoluteFilePath(fileName));
 }
 
 void FileManager::rename(const QString& fileName, const QString& newFileName) {
@@ -233,21 +185,149 @@ void FileManager::rename(const QString& fileName, const QString& newFileName) {
         showToast("文件名不能包含特殊字符", "#E9900C");
         return;
     }
-    auto newFilePath = mCurrentPath.absoluteFilePath(newFileName);
     markSuspendDirChangedNotifier();
-    if (!mCurrentPath.rename(fileName, newFileName)) {
-        showToast("修改失败", "#E9900C");
+    FileOperator::getInstance().post(
+        FileOperator::Type::Rename,
+        mCurrentPath.absoluteFilePath(fileName),
+        mCurrentPath.absoluteFilePath(newFileName)
+    );
+}
+
+void FileManager::copy(const QString& fileName) {
+    mClipboard = {mCurrentPath.absoluteFilePath(fileName), false};
+    emit clipboardChanged();
+}
+
+void FileManager::cut(const QString& fileName) {
+    mClipboard = {mCurrentPath.absoluteFilePath(fileName), true};
+    emit clipboardChanged();
+}
+
+void FileManager::paste() {
+    if (!canPaste()) {
+        return;
+    }
+    auto source = mClipboard.mPath;
+    auto isCut  = mClipboard.mIsCut;
+    if (mCurrentPath.absolutePath() == source || mCurrentPath.absolutePath().startsWith(source + "/")) {
+        showToast("不能粘贴到自身的子文件夹中", "#E9900C");
+        return;
+    }
+    auto target = mCurrentPath.absoluteFilePath(QFileInfo(source).fileName());
+    if (isCut) {
+        if (target == source) {
+            return;
+        }
+        mClipboard = {};
+        emit clipboardChanged();
+    }
+    markSuspendDirChangedNotifier();
+    FileOperator::getInstance().post(
+        isCut ? FileOperator::Type::Move : FileOperator::Type::Copy,
+        source,
+        FileOperator::getFreePath(target)
+    );
+}
+
+bool FileManager::canPaste() const { return !mClipboard.mPath.isEmpty() && QFileInfo::exists(mClipboard.mPath); }
+
+void FileManager::onDirSizeUpdated(const QString& path, qint64 size, bool finished) {
+    auto idx = _findEntity(path);
+    if (idx < 0) {
         return;
     }
-    auto idx = 0;
-    for (auto& i : mEntities) {
-        if (i->fileName() == fileName) {
-            i->setFile(newFilePath);
-            auto midx = index(idx);
-            emit dataChanged(midx, midx);
+    mEntities[idx].setDirSize(size, finished);
+    if (idx < mProxyCount) {
+        auto midx = index(idx);
+        emit dataChanged(midx, midx, {(int)UserRoles::SizeString});
+    }
+}
+
+void FileManager::onMetadataReady(const QStringList& paths) {
+    auto& store = MetadataStore::getInstance();
+    auto  dir   = mCurrentPath.absolutePath();
+    // Name -> row, only built when a batch concerns this directory.
+    QHash<QString, int> rows;
+    int                 first = INT_MAX, last = -1;
+    for (auto& path : paths) {
+        auto slash = path.lastIndexOf('/');
+        if (path.leftRef(slash) != dir) {
+            continue;
+        }
+        if (rows.isEmpty()) {
+            rows.reserve((int)mEntities.size());
+            for (int i = 0; i < (int)mEntities.size(); i++) {
+                rows.insert(mEntities[i].mFileName, i);
+            }
+        }
+        auto row  = rows.value(path.mid(slash + 1), -1);
+        auto meta = store.get(path);
+        if (row < 0 || !meta) {
+            continue;
+        }
+        mEntities[row].setMetadata(*meta);
+        first = std::min(first, row);
+        last  = std::max(last, row);
+    }
+    last = std::min(last, mProxyCount - 1);
+    if (first <= last) {
+        emit dataChanged(
+            index(first),
+            index(last),
+            {(int)UserRoles::Title, (int)UserRoles::Artist, (int)UserRoles::Duration}
+        );
+    }
+}
+
+void FileManager::onOperationFinished(
+    FileOperator::TaskId id,
+    FileOperator::Type   type,
+    const QString&       source,
+    const QString&       target,
+    bool                 succeed
+) {
+    markSuspendDirChangedNotifier();
+    if (!succeed) {
+        switch (type) {
+        case FileOperator::Type::Remove:
+            showToast("删除失败", "#E9900C");
+            break;
+        case FileOperator::Type::Rename:
+            showToast("修改失败", "#E9900C");
             break;
+        case FileOperator::Type::Copy:
+        case FileOperator::Type::Move:
+            showToast("粘贴失败", "#E9900C");
+            break;
+        }
+        return;
+    }
+    // Apply the result to the loaded rows only, the rest of the model is left untouched.
+    switch (type) {
+    case FileOperator::Type::Remove:
+        if (auto idx = _findEntity(source); idx >= 0) {
+            _removeEntity(idx);
         }
-        idx++;
+        break;
+    case FileOperator::Type::Rename:
+        if (auto idx = _findEntity(source); idx >= 0) {
+            // The new name may sort elsewhere.
+            auto entity = std::move(mEntities[idx]);
+            _removeEntity(idx);
+            entity.setFile(target);
+            _insertEntity(std::move(entity));
+        }
+        break;
+    case FileOperator::Type::Move:
+        if (auto idx = _findEntity(source); idx >= 0) {
+            _removeEntity(idx);
+        }
+        [[fallthrough]];
+    case FileOperator::Type::Copy:
+        if (QFileInfo(target).absolutePath() == mCurrentPath.absolutePath()) {
+            _insertEntity(FileEntity(QFileInfo(target)));
+        }
+        break;
     }
 }
 
@@ -292,6 +372,7 @@ void FileManager::setOrder(int order) {
         mOrder                 = order;
         mCfg["order"]["basic"] = order;
         WRITE_CFG;
+        _sortEntities();
         emit orderChanged();
     }
 }
@@ -301,6 +382,7 @@ void FileManager::setOrderReversed(bool val) {
         mOrderReversed            = val;
         mCfg["order"]["reversed"] = val;
         WRITE_CFG;
+        _sortEntities();
         emit orderReversedChanged();
     }
 }
@@ -331,14 +413,10 @@ void FileManager::_initCurrentDir() {
         return;
     }
 
-    auto order = getOrder();
-    if (getOrderReversed()) {
-        order |= QDir::Reversed;
-    }
-    order     = order | QDir::DirsFirst | QDir::IgnoreCase;
+    // Sorted by ourselves later, with keys computed once per entry.
     auto list = mCurrentPath.entryInfoList(
         QDir::Dirs | QDir::Files | QDir::NoSymLinks | QDir::NoDotAndDotDot,
-        static_cast<QDir::SortFlags>(order)
+        QDir::Unsorted
     );
 
     if (list.empty()) {
@@ -355,30 +433,110 @@ void FileManager::_initCurrentDir() {
     }
 
     // For paired lyrics auto-hidden.
-    std::vector<QString> pairedLyrics;
+    QSet<QString> pairedLyrics;
     if (getHidePairedLyrics()) {
+        QSet<QString> names;
         for (auto& i : list) {
-            auto path = i.absoluteFilePath();
-            if (path.endsWith(".mp3", Qt::CaseInsensitive)) { // Current only support mp3 format.
-                auto lrcPath = path.mid(0, path.length() - 4) + ".lrc";
-                if (QFile(lrcPath).exists()) {
-                    pairedLyrics.emplace_back(lrcPath);
+            names.insert(i.fileName());
+        }
+        for (auto& name : names) {
+            if (name.endsWith(".mp3", Qt::CaseInsensitive)) { // Current only support mp3 format.
+                auto lrcName = name.mid(0, name.length() - 4) + ".lrc";
+                if (names.contains(lrcName)) {
+                    pairedLyrics.insert(lrcName);
                 }
             }
         }
     }
 
+    // Role values are resolved here once, data() only hands out the cached ones.
+    mEntities.reserve(list.size());
     for (auto& i : list) {
-        if (std::find(pairedLyrics.begin(), pairedLyrics.end(), i.absoluteFilePath()) != pairedLyrics.end()) {
+        if (pairedLyrics.contains(i.fileName())) {
             continue;
         }
-        mEntities.emplace_back(std::make_shared<QFileInfo>(i));
+        mEntities.emplace_back(i);
+    }
+    sortEntities(mEntities, getOrder(), getOrderReversed());
+}
+
+void FileManager::_requestDirSizes() {
+    auto& du = DiskUsage::getInstance();
+    du.cancelAll();
+    for (auto& i : mEntities) {
+        if (i.mIsDir) {
+            du.request(i.mInfo->absoluteFilePath());
+        }
+    }
+}
+
+void FileManager::_requestMetadata() {
+    auto& store = MetadataStore::getInstance();
+    store.cancel(this); // the player may be waiting for the next track.
+    // In display order, so that the first page is filled in first.
+    for (auto& i : mEntities) {
+        if (i.isTrack()) {
+            store.request(i.mInfo->absoluteFilePath(), i.mSize, i.mModifiedTime, this);
+        }
+    }
+}
+
+void FileManager::_sortEntities() {
+    emit layoutAboutToBeChanged();
+    sortEntities(mEntities, getOrder(), getOrderReversed());
+    emit layoutChanged();
+}
+
+int FileManager::_findEntity(const QString& path) const {
+    QFileInfo info(path);
+    if (info.absolutePath() != mCurrentPath.absolutePath()) {
+        return -1;
+    }
+    auto fileName = info.fileName();
+    for (size_t i = 0; i < mEntities.size(); i++) {
+        if (mEntities[i].mFileName == fileName) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void FileManager::_insertEntity(FileEntity entity) {
+    auto path = entity.mInfo->absoluteFilePath();
+    if (entity.mIsDir) {
+        DiskUsage::getInstance().request(path);
+    } else if (entity.isTrack()) {
+        MetadataStore::getInstance().request(path, entity.mSize, entity.mModifiedTime, this);
+    }
+    auto pos = (int)findSortedPosition(mEntities, entity, getOrder(), getOrderReversed());
+    // Rows past mProxyCount are not visible yet, they will show up with loadMore().
+    if (pos > mProxyCount || (pos == mProxyCount && mProxyCount < (int)mEntities.size())) {
+        mEntities.insert(mEntities.begin() + pos, std::move(entity));
+        emit hasMoreChanged();
+        return;
+    }
+    beginInsertRows(QModelIndex(), pos, pos);
+    mEntities.insert(mEntities.begin() + pos, std::move(entity));
+    mProxyCount++;
+    endInsertRows();
+}
+
+void FileManager::_removeEntity(int idx) {
+    if (idx >= mProxyCount) {
+        mEntities.erase(mEntities.begin() + idx);
+        emit hasMoreChanged();
+        return;
     }
+    beginRemoveRows(QModelIndex(), idx, idx);
+    mEntities.erase(mEntities.begin() + idx);
+    mProxyCount--;
+    endRemoveRows();
+    emit hasMoreChanged();
 }
 
 void FileManager::forEachLoadedEntities(const std::function<void(std::shared_ptr<QFileInfo>)>& callback) {
     for (const auto& i : mEntities) {
-        callback(i);
+        callback(i.mInfo);
     }
 }
 
@@ -395,33 +553,84 @@ void FileManager::setHidePairedLyrics(bool val) {
     }
 }
 
+bool FileManager::getNormalizeLoudness() const { return mNormalizeLoudness; }
+
+void FileManager::setNormalizeLoudness(bool val) {
+    if (mNormalizeLoudness != val) {
+        mNormalizeLoudness         = val;
+        mCfg["normalize_loudness"] = val;
+        WRITE_CFG;
+        MusicPlayer::getInstance().updateTrackGain();
+        emit normalizeLoudnessChanged();
+    }
+}
+
 void FileManager::playFromView(const QString& fileName) {
-    if (mCurrentPlayingPath != mCurrentPath) {
+    auto& player = MusicPlayer::getInstance();
+    auto  path   = mCurrentPath.absoluteFilePath(fileName);
+    auto  suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "m3u" || suffix == "m3u8") {
+        _setPlayingPath({});
+        player.playSource(std::make_unique<M3uSource>(path));
+        return;
+    }
+    if (mCurrentPlayingPath != mCurrentPath.absolutePath()) {
+        _setPlayingPath(mCurrentPath.absolutePath());
         refreshPlayList();
-        mFileSystemWatcher.removePath(mCurrentPlayingPath.absolutePath());
-        mCurrentPlayingPath = mCurrentPath;
-        mFileSystemWatcher.addPath(mCurrentPlayingPath.absolutePath());
-    }
-    size_t idx   = 0;
-    bool   valid = false;
-    for (auto& file : MusicPlayer::getInstance().getPlayListRef()) {
-        if (file->fileName() == fileName) {
-            valid = true;
-            break;
-        }
-        idx++;
     }
-    if (valid) MusicPlayer::getInstance().play(idx);
+    if (auto idx = player.getPlayList().indexOf(path)) player.play(*idx);
+}
+
+void FileManager::playRecursive(const QString& dirName) {
+    auto dir = dirName.isEmpty() ? mCurrentPath.absolutePath() : mCurrentPath.absoluteFilePath(dirName);
+    _setPlayingPath({});
+    MusicPlayer::getInstance().playSource(std::make_unique<DirectorySource>(dir, true));
+}
+
+bool FileManager::savePlayList(const QString& name) {
+    auto& player = MusicPlayer::getInstance();
+    if (name.isEmpty() || name.contains('/') || player.getPlayList().empty()) {
+        return false;
+    }
+    auto path = FileOperator::getFreePath(mCurrentPath.absoluteFilePath(name + ".m3u"));
+    if (!player.savePlayList(path)) {
+        warn("Failed to save play list to {}", path.toStdString());
+        return false;
+    }
+    return true;
 }
 
 void FileManager::refreshPlayList() {
-    auto& list = MusicPlayer::getInstance().getPlayListRef();
-    list.clear();
-    forEachLoadedEntities([&](const std::shared_ptr<QFileInfo>& file) {
-        if (file->suffix().toLower() == "mp3") {
-            list.emplace_back(file);
+    if (mCurrentPlayingPath.isEmpty()) {
+        return; // Not playing a directory.
+    }
+    auto&    player = MusicPlayer::getInstance();
+    PlayList list;
+    // Rebuilt here, so that .lrc files added or removed while playing are picked up by the watcher.
+    player.refreshLyrics(mCurrentPlayingPath);
+    if (mCurrentPlayingPath == mCurrentPath.absolutePath()) {
+        // In the order of the view.
+        auto dir = list.addDir(mCurrentPlayingPath);
+        for (auto& entity : mEntities) {
+            if (!entity.mIsDir && entity.mExtName == "mp3") {
+                list.append(dir, entity.mFileName);
+            }
         }
-    });
+    } else {
+        DirectorySource source(mCurrentPlayingPath, false);
+        while (source.fill(list, SIZE_MAX)) {}
+    }
+    player.setPlayList(std::move(list));
+}
+
+void FileManager::_setPlayingPath(const QString& path) {
+    if (!mCurrentPlayingPath.isEmpty()) {
+        mPlayingWatcher.removePath(mCurrentPlayingPath);
+    }
+    mCurrentPlayingPath = path;
+    if (!mCurrentPlayingPath.isEmpty()) {
+        mPlayingWatcher.addPath(mCurrentPlayingPath);
+    }
 }
 } // namespace mod::filemanager
 
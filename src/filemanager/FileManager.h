@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include "filemanager/FileEntity.h"
+#include "filemanager/FileOperator.h"
+
 #include "mod/Config.h"
 
 #include "common/service/Logger.h"
@@ -24,9 +27,11 @@ class FileManager : public QAbstractListModel, public Singleton<FileManager>, pr
     Q_PROPERTY(int order READ getOrder WRITE setOrder NOTIFY orderChanged);
     Q_PROPERTY(bool orderReversed READ getOrderReversed WRITE setOrderReversed NOTIFY orderReversedChanged);
     Q_PROPERTY(bool hasMore READ isHasMore NOTIFY hasMoreChanged);
+    Q_PROPERTY(bool canPaste READ canPaste NOTIFY clipboardChanged);
 
     // MusicPlayer
     Q_PROPERTY(bool hidePairedLyrics READ getHidePairedLyrics WRITE setHidePairedLyrics NOTIFY hidePairedLyricsChanged);
+    Q_PROPERTY(bool normalizeLoudness READ getNormalizeLoudness WRITE setNormalizeLoudness NOTIFY normalizeLoudnessChanged);
 
 public:
     [[nodiscard]] int rowCount(const QModelIndex& parent) const override;
@@ -41,6 +46,8 @@ public:
 
     [[nodiscard]] QDir const& getCurrentPath() const;
 
+    [[nodiscard]] QString const& getRoot() const;
+
     Q_INVOKABLE bool changeDir(const QString& dir);
 
     Q_INVOKABLE [[nodiscard]] bool canCdUp() const;
@@ -58,6 +65,27 @@ public:
 
     Q_INVOKABLE void rename(const QString& fileName, const QString& newFileName);
 
+    // Clipboard, pasted into the current dir.
+    Q_INVOKABLE void copy(const QString& fileName);
+
+    Q_INVOKABLE void cut(const QString& fileName);
+
+    Q_INVOKABLE void paste();
+
+    [[nodiscard]] bool canPaste() const;
+
+    void onDirSizeUpdated(const QString& path, qint64 size, bool finished);
+
+    void onMetadataReady(const QStringList& paths);
+
+    void onOperationFinished(
+        FileOperator::TaskId id,
+        FileOperator::Type   type,
+        const QString&       source,
+        const QString&       target,
+        bool                 succeed
+    );
+
     [[nodiscard]] bool shouldHiddenAll() const;
 
     void negateHiddenAll();
@@ -88,8 +116,20 @@ public:
 
     void setHidePairedLyrics(bool);
 
+    // Tracks played at the same loudness, measured in background the first time they are played.
+    [[nodiscard]] bool getNormalizeLoudness() const;
+
+    void setNormalizeLoudness(bool);
+
+    // A .mp3 plays the current directory from it, a .m3u/.m3u8 plays the saved list.
     Q_INVOKABLE void playFromView(const QString& fileName);
 
+    // Plays every .mp3 below a directory of the view, or below the current one if `dirName` is empty.
+    Q_INVOKABLE void playRecursive(const QString& dirName);
+
+    // Saves what is being played as `name`.m3u in the current directory.
+    Q_INVOKABLE bool savePlayList(const QString& name);
+
 signals:
 
     void currentTitleChanged();
@@ -102,19 +142,32 @@ signals:
 
     void hasMoreChanged();
 
+    void clipboardChanged();
+
     void exception(const QString& msg);
 
     // MusicPlayer
 
     void hidePairedLyricsChanged();
 
+    void normalizeLoudnessChanged();
+
 private:
     friend Singleton<FileManager>;
     explicit FileManager();
 
     // FileManager
 
-    enum class UserRoles { FileName = Qt::UserRole + 1, IsDirectory, SizeString, ExtensionName, ExtensionIcon };
+    enum class UserRoles {
+        FileName = Qt::UserRole + 1,
+        IsDirectory,
+        SizeString,
+        ExtensionName,
+        ExtensionIcon,
+        Title,
+        Artist,
+        Duration
+    };
 
     std::string mClassName{"fm"};
     json        mCfg;
@@ -127,18 +180,44 @@ private:
     int  mOrder;
     bool mOrderReversed;
 
-    QDir                                    mCurrentPath;
-    std::vector<std::shared_ptr<QFileInfo>> mEntities;
-    int                                     mProxyCount{};
+    QDir                    mCurrentPath;
+    std::vector<FileEntity> mEntities;
+    int                     mProxyCount{};
+
+    struct {
+        QString mPath;
+        bool    mIsCut{};
+    } mClipboard;
 
     void _initCurrentDir();
 
+    // Re-sort the listed entities in place, without listing the directory again.
+    void _sortEntities();
+
+    void _requestDirSizes();
+
+    void _requestMetadata();
+
+    // Returns -1 if `path` is not an entity of the current dir.
+    int _findEntity(const QString& path) const;
+
+    // At its place in the current order, sizes and tags are requested again.
+    void _insertEntity(FileEntity entity);
+
+    void _removeEntity(int idx);
+
     // MusicPlayer
 
     bool mHidePairedLyrics;
+    bool mNormalizeLoudness;
 
-    QDir mCurrentPlayingPath;
+    // Absolute path of the directory being played, empty when playing a saved or recursive list.
+    // Watched on its own, QFileSystemWatcher doesn't count paths added twice and it is often the view's.
+    QString            mCurrentPlayingPath;
+    QFileSystemWatcher mPlayingWatcher;
 
     void refreshPlayList();
+
+    void _setPlayingPath(const QString& path);
 }; // namespace mod::filemanager
 } // namespace mod::filemanager
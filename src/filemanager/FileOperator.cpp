@@ -0,0 +1,382 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/FileOperator.h"
+
+#include "common/Event.h"
+
+#include <QDir>
+#include <QQmlContext>
+
+#include <cstring>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mod::filemanager {
+
+constexpr size_t COPY_CHUNK = 1024 * 1024;
+
+FileOperator::FileOperator() : Logger("FileOperator") {
+    mWorker = std::thread(&FileOperator::_workerLoop, this);
+    connect(&Event::getInstance(), &Event::beforeUiInitialization, [this](QQuickView& view, QQmlContext* context) {
+        context->setContextProperty("fileOperator", this);
+    });
+}
+
+FileOperator::~FileOperator() {
+    {
+        std::lock_guard lock(mMutex);
+        mExiting = true;
+        mTasks.clear();
+    }
+    mCancelled = true;
+    mCondition.notify_one();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+}
+
+FileOperator::TaskId FileOperator::post(Type type, const QString& source, const QString& target) {
+    auto id = mNextId++;
+    {
+        std::lock_guard lock(mMutex);
+        mTasks.push_back({id, type, source, target});
+    }
+    mCondition.notify_one();
+    mRunning++;
+    emit busyChanged();
+    return id;
+}
+
+void FileOperator::cancelAll() {
+    std::lock_guard lock(mMutex);
+    for (auto& task : mTasks) {
+        // Dropped tasks still report back, so that the counter stays right.
+        QMetaObject::invokeMethod(
+            this,
+            [this, task]() {
+                mRunning--;
+                emit busyChanged();
+                emit finished(task.mId, task.mType, task.mSource, task.mTarget, false);
+            },
+            Qt::QueuedConnection
+        );
+    }
+    mTasks.clear();
+    mCancelled = true;
+}
+
+bool FileOperator::isBusy() const { return mRunning > 0; }
+
+int FileOperator::getPendingCount() const { return mRunning; }
+
+int FileOperator::getProgress() const { return mProgress; }
+
+QString FileOperator::getFreePath(const QString& path) {
+    if (!QFileInfo::exists(path)) {
+        return path;
+    }
+    QFileInfo info(path);
+    auto      dir    = info.absoluteDir();
+    auto      base   = info.isDir() ? info.fileName() : info.completeBaseName();
+    auto      suffix = info.isDir() || info.suffix().isEmpty() ? QString() : "." + info.suffix();
+    for (int i = 1;; i++) {
+        auto candidate = dir.absoluteFilePath(QString("%1(%2)%3").arg(base).arg(i).arg(suffix));
+        if (!QFileInfo::exists(candidate)) {
+            return candidate;
+        }
+    }
+}
+
+void FileOperator::_workerLoop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this]() { return mExiting || !mTasks.empty(); });
+            if (mExiting) {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+            mCancelled = false;
+        }
+        mWorkerProgress = {};
+        auto succeed    = _run(task);
+        if (!succeed) {
+            warn("Operation({}) on '{}' failed: {}", (int)task.mType, task.mSource.toStdString(), strerror(errno));
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, task, succeed]() {
+                mRunning--;
+                mProgress = 0;
+                emit progressChanged();
+                emit busyChanged();
+                emit finished(task.mId, task.mType, task.mSource, task.mTarget, succeed);
+            },
+            Qt::QueuedConnection
+        );
+    }
+}
+
+bool FileOperator::_run(const Task& task) {
+    switch (task.mType) {
+    case Type::Remove:
+        return _remove(task.mSource);
+    case Type::Rename:
+        if (QFileInfo::exists(task.mTarget)) {
+            errno = EEXIST;
+            return false;
+        }
+        return ::rename(task.mSource.toUtf8().constData(), task.mTarget.toUtf8().constData()) == 0;
+    case Type::Copy:
+        return _copy(task.mSource, task.mTarget);
+    case Type::Move:
+        return _move(task.mSource, task.mTarget);
+    }
+    return false;
+}
+
+bool FileOperator::_remove(const QString& path) {
+    auto        bytes = path.toUtf8();
+    struct stat st {};
+    if (lstat(bytes.constData(), &st) != 0) {
+        return false;
+    }
+    auto isDir = S_ISDIR(st.st_mode);
+    if (isDir) {
+        _measure(AT_FDCWD, bytes.constData(), false);
+    }
+    return _removeAt(AT_FDCWD, bytes.constData(), isDir);
+}
+
+bool FileOperator::_removeAt(int dirFd, const char* name, bool isDir, bool force) {
+    if (!isDir) {
+        _advance(1);
+        return unlinkat(dirFd, name, 0) == 0;
+    }
+    auto fd = openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    auto* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return false;
+    }
+    auto succeed = true;
+    while (auto* entry = readdir(dir)) {
+        if (mCancelled && !force) {
+            succeed = false;
+            break;
+        }
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        auto childIsDir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st {};
+            if (fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+                childIsDir = S_ISDIR(st.st_mode);
+            }
+        }
+        succeed &= _removeAt(fd, entry->d_name, childIsDir, force);
+    }
+    closedir(dir); // fd is closed too.
+    if (!succeed) {
+        return false;
+    }
+    _advance(1);
+    return unlinkat(dirFd, name, AT_REMOVEDIR) == 0;
+}
+
+bool FileOperator::_copy(const QString& source, const QString& target) {
+    auto src = source.toUtf8();
+    auto dst = target.toUtf8();
+    if (QFileInfo::exists(target)) {
+        errno = EEXIST;
+        return false;
+    }
+    _measure(AT_FDCWD, src.constData(), true);
+    if (_copyAt(AT_FDCWD, src.constData(), AT_FDCWD, dst.constData())) {
+        return true;
+    }
+    // Never leave a half-copied tree behind, cancelled or not.
+    auto        err = errno;
+    struct stat st {};
+    if (lstat(dst.constData(), &st) == 0) {
+        _removeAt(AT_FDCWD, dst.constData(), S_ISDIR(st.st_mode), true);
+    }
+    errno = err;
+    return false;
+}
+
+bool FileOperator::_copyAt(int srcDirFd, const char* srcName, int dstDirFd, const char* dstName) {
+    struct stat st {};
+    if (fstatat(srcDirFd, srcName, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    if (S_ISREG(st.st_mode)) {
+        auto srcFd = openat(srcDirFd, srcName, O_RDONLY | O_CLOEXEC);
+        if (srcFd < 0) {
+            return false;
+        }
+        auto dstFd = openat(dstDirFd, dstName, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777);
+        if (dstFd < 0) {
+            close(srcFd);
+            return false;
+        }
+        auto succeed = _copyFileData(srcFd, dstFd, st.st_size);
+        close(srcFd);
+        succeed &= close(dstFd) == 0;
+        return succeed;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        return true; // Symlinks and special files are not copied, just like the file list ignores them.
+    }
+    if (mkdirat(dstDirFd, dstName, st.st_mode & 07777) != 0) {
+        return false;
+    }
+    auto srcFd = openat(srcDirFd, srcName, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    auto dstFd = openat(dstDirFd, dstName, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (srcFd < 0 || dstFd < 0) {
+        if (srcFd >= 0) close(srcFd);
+        if (dstFd >= 0) close(dstFd);
+        return false;
+    }
+    auto* dir = fdopendir(srcFd);
+    if (!dir) {
+        close(srcFd);
+        close(dstFd);
+        return false;
+    }
+    auto succeed = true;
+    while (auto* entry = readdir(dir)) {
+        if (mCancelled) {
+            succeed = false;
+            break;
+        }
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        if (!_copyAt(srcFd, entry->d_name, dstFd, entry->d_name)) {
+            succeed = false;
+            break;
+        }
+    }
+    closedir(dir);
+    close(dstFd);
+    return succeed;
+}
+
+bool FileOperator::_copyFileData(int srcFd, int dstFd, uint64 size) {
+    // copy_file_range() lets the kernel copy (or share) the extents directly,
+    // sendfile() is the fallback for kernels/filesystems which refuse it.
+    bool useSendfile = false;
+    for (uint64 left = size; left > 0;) {
+        if (mCancelled) {
+            errno = ECANCELED;
+            return false;
+        }
+        auto    chunk = std::min<uint64>(left, COPY_CHUNK);
+        ssize_t ret;
+        if (!useSendfile) {
+            ret = copy_file_range(srcFd, nullptr, dstFd, nullptr, chunk, 0);
+            if (ret < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useSendfile = true;
+                continue;
+            }
+        } else {
+            ret = sendfile(dstFd, srcFd, nullptr, chunk);
+        }
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (ret == 0) {
+            break; // Truncated by someone else while copying.
+        }
+        left -= ret;
+        _advance(ret);
+    }
+    return true;
+}
+
+bool FileOperator::_move(const QString& source, const QString& target) {
+    auto src = source.toUtf8();
+    auto dst = target.toUtf8();
+    if (QFileInfo::exists(target)) {
+        errno = EEXIST;
+        return false;
+    }
+    if (::rename(src.constData(), dst.constData()) == 0) {
+        return true;
+    }
+    if (errno != EXDEV) {
+        return false;
+    }
+    if (!_copy(source, target)) {
+        return false;
+    }
+    mWorkerProgress = {};
+    return _remove(source);
+}
+
+void FileOperator::_measure(int dirFd, const char* name, bool countBytes) {
+    struct stat st {};
+    if (fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return;
+    }
+    mWorkerProgress.mTotal += countBytes ? (S_ISREG(st.st_mode) ? st.st_size : 0) : 1;
+    if (!S_ISDIR(st.st_mode)) {
+        return;
+    }
+    auto fd = openat(dirFd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    auto* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return;
+    }
+    while (auto* entry = readdir(dir)) {
+        if (mCancelled) break;
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        _measure(fd, entry->d_name, countBytes);
+    }
+    closedir(dir);
+}
+
+void FileOperator::_advance(uint64 amount) {
+    auto& prog = mWorkerProgress;
+    prog.mDone += amount;
+    if (!prog.mTotal) {
+        return;
+    }
+    auto percent = (int)std::min<uint64>(prog.mDone * 100 / prog.mTotal, 100);
+    if (percent == prog.mReported) {
+        return;
+    }
+    prog.mReported = percent;
+    QMetaObject::invokeMethod(
+        this,
+        [this, percent]() {
+            mProgress = percent;
+            emit progressChanged();
+        },
+        Qt::QueuedConnection
+    );
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "common/service/Logger.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace mod::filemanager {
+
+// Runs file operations on a worker thread, one at a time, in the order they were posted.
+// Results are delivered on the GUI thread through `finished`.
+class FileOperator : public QObject, public Singleton<FileOperator>, private Logger {
+    Q_OBJECT
+
+    Q_PROPERTY(bool busy READ isBusy NOTIFY busyChanged);
+    Q_PROPERTY(int pendingCount READ getPendingCount NOTIFY busyChanged);
+    Q_PROPERTY(int progress READ getProgress NOTIFY progressChanged);
+
+public:
+    enum class Type { Remove, Rename, Copy, Move };
+
+    using TaskId = uint64;
+
+    ~FileOperator() override;
+
+    // `source` and `target` are absolute paths, `target` is unused by Remove.
+    TaskId post(Type type, const QString& source, const QString& target = {});
+
+    // Cancel the running operation and drop the pending ones.
+    Q_INVOKABLE void cancelAll();
+
+    [[nodiscard]] bool isBusy() const;
+
+    [[nodiscard]] int getPendingCount() const;
+
+    // Progress of the running operation, in percent.
+    [[nodiscard]] int getProgress() const;
+
+    // Returns `path` itself if it doesn't exist, otherwise `name(1).ext`, `name(2).ext`...
+    static QString getFreePath(const QString& path);
+
+signals:
+
+    void busyChanged();
+
+    void progressChanged();
+
+    void finished(TaskId id, Type type, const QString& source, const QString& target, bool succeed);
+
+private:
+    friend Singleton<FileOperator>;
+    explicit FileOperator();
+
+    struct Task {
+        TaskId  mId;
+        Type    mType;
+        QString mSource;
+        QString mTarget;
+    };
+
+    // Worker thread.
+
+    std::thread             mWorker;
+    mutable std::mutex      mMutex;
+    std::condition_variable mCondition;
+    std::deque<Task>        mTasks;
+    std::atomic<bool>       mCancelled{false};
+    bool                    mExiting{false};
+
+    // GUI thread.
+
+    TaskId mNextId{1};
+    int    mRunning{};
+    int    mProgress{};
+
+    struct Progress {
+        uint64 mTotal{};
+        uint64 mDone{};
+        int    mReported{-1};
+    } mWorkerProgress;
+
+    void _workerLoop();
+
+    bool _run(const Task& task);
+
+    bool _remove(const QString& path);
+
+    // `force` goes on after a cancel, to clean up what a cancelled copy left.
+    bool _removeAt(int dirFd, const char* name, bool isDir, bool force = false);
+
+    bool _copy(const QString& source, const QString& target);
+
+    bool _copyAt(int srcDirFd, const char* srcName, int dstDirFd, const char* dstName);
+
+    bool _copyFileData(int srcFd, int dstFd, uint64 size);
+
+    bool _move(const QString& source, const QString& target);
+
+    void _measure(int dirFd, const char* name, bool countBytes);
+
+    void _advance(uint64 amount);
+};
+
+} // namespace mod::filemanager
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/FileSorter.h"
+
+#include "common/util/Pinyin.h"
+
+#include <QDir>
+
+#include <cstring>
+#include <numeric>
+#include <thread>
+
+namespace mod::filemanager {
+
+// Below this, spawning threads costs more than it saves.
+constexpr size_t PARALLEL_THRESHOLD = 4096;
+constexpr uint32 MAX_SORT_THREADS   = 4;
+
+// Leading byte of each key segment, decides the order between classes.
+enum class KeyClass : char { Number = 0x10, Latin = 0x20, Hanzi = 0x30, Other = 0x40 };
+
+QByteArray makeSortKey(const QString& name) {
+    QByteArray key;
+    key.reserve(name.size() * 3);
+    auto append16 = [&](KeyClass cls, uint16 value) {
+        key.append((char)cls);
+        key.append((char)(value >> 8));
+        key.append((char)(value & 0xFF));
+    };
+    for (int i = 0; i < name.size(); i++) {
+        auto ch = name[i];
+        if (ch.unicode() >= '0' && ch.unicode() <= '9') {
+            // Leading zeros are dropped, a longer number is a larger one.
+            int begin = i;
+            while (begin < name.size() - 1 && name[begin] == '0' && name[begin + 1].isDigit()) begin++;
+            int end = begin;
+            while (end < name.size() && name[end].unicode() >= '0' && name[end].unicode() <= '9') end++;
+            key.append((char)KeyClass::Number);
+            key.append((char)std::min(end - begin, 0xFF));
+            for (int j = begin; j < end; j++) {
+                key.append((char)name[j].unicode());
+            }
+            i = end - 1;
+            continue;
+        }
+        if (auto gb = util::getGbCode(ch)) {
+            append16(KeyClass::Hanzi, gb);
+            continue;
+        }
+        if (ch.unicode() < 0x2E80) {
+            append16(KeyClass::Latin, ch.toCaseFolded().unicode());
+            continue;
+        }
+        append16(KeyClass::Other, ch.unicode());
+    }
+    return key;
+}
+
+static int compareKey(const QByteArray& a, const QByteArray& b) {
+    auto len = std::min(a.size(), b.size());
+    if (auto r = memcmp(a.constData(), b.constData(), len)) {
+        return r;
+    }
+    return a.size() - b.size();
+}
+
+template <typename T>
+static int compareValue(T a, T b) {
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Same semantics as QDir: newest and largest first, reversing keeps directories first.
+static bool lessEntity(const FileEntity& a, const FileEntity& b, int order, bool reversed) {
+    if (a.mIsDir != b.mIsDir) {
+        return a.mIsDir;
+    }
+    int r = 0;
+    if (order & QDir::Type) {
+        r = QString::compare(a.mExtName, b.mExtName);
+    }
+    if (!r) {
+        switch (order & QDir::SortByMask) {
+        case QDir::Time:
+            r = compareValue(b.mModifiedTime, a.mModifiedTime);
+            break;
+        case QDir::Size:
+            r = compareValue(b.mSize, a.mSize);
+            break;
+        default:
+            break;
+        }
+    }
+    if (!r) {
+        r = compareKey(a.mSortKey, b.mSortKey);
+    }
+    if (!r) {
+        r = QString::compare(a.mFileName, b.mFileName);
+    }
+    return reversed ? r > 0 : r < 0;
+}
+
+void sortEntities(std::vector<FileEntity>& entities, int order, bool reversed) {
+    auto less = [&](uint32 x, uint32 y) { return lessEntity(entities[x], entities[y], order, reversed); };
+
+    std::vector<uint32> indices(entities.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    auto threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), MAX_SORT_THREADS);
+    if (indices.size() < PARALLEL_THRESHOLD || threads < 2) {
+        std::sort(indices.begin(), indices.end(), less);
+    } else {
+        // Sort equal chunks in parallel, then merge neighbours pairwise.
+        std::vector<size_t> bounds;
+        for (uint32 i = 0; i <= threads; i++) {
+            bounds.emplace_back(indices.size() * i / threads);
+        }
+        auto parallel = [&](size_t count, const std::function<void(size_t)>& task) {
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < count; i++) {
+                workers.emplace_back(task, i);
+            }
+            task(0);
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        };
+        parallel(threads, [&](size_t i) {
+            std::sort(indices.begin() + bounds[i], indices.begin() + bounds[i + 1], less);
+        });
+        for (size_t width = 1; width < threads; width *= 2) {
+            auto pairs = (threads + 2 * width - 1) / (2 * width);
+            parallel(pairs, [&](size_t i) {
+                auto first  = std::min<size_t>(2 * width * i, threads);
+                auto middle = std::min<size_t>(first + width, threads);
+                auto last   = std::min<size_t>(first + 2 * width, threads);
+                std::inplace_merge(
+                    indices.begin() + bounds[first],
+                    indices.begin() + bounds[middle],
+                    indices.begin() + bounds[last],
+                    less
+                );
+            });
+        }
+    }
+
+    std::vector<FileEntity> sorted;
+    sorted.reserve(entities.size());
+    for (auto i : indices) {
+        sorted.emplace_back(std::move(entities[i]));
+    }
+    entities.swap(sorted);
+}
+
+size_t findSortedPosition(const std::vector<FileEntity>& entities, const FileEntity& entity, int order, bool reversed) {
+    auto it = std::upper_bound(entities.begin(), entities.end(), entity, [&](const FileEntity& a, const FileEntity& b) {
+        return lessEntity(a, b, order, reversed);
+    });
+    return it - entities.begin();
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/FileEntity.h"
+
+namespace mod::filemanager {
+
+// Builds a binary key which compares with memcmp() in natural order:
+// numeric runs by value ("第2课" < "第10课"), letters case-folded, CJK by pinyin.
+QByteArray makeSortKey(const QString& name);
+
+// Sort by a QDir::SortFlag (Name, Time, Size or Type), directories always come first.
+// Only precomputed values are compared, large lists are sorted on several threads.
+void sortEntities(std::vector<FileEntity>& entities, int order, bool reversed);
+
+// Index to insert `entity` at in `entities`, already sorted with the same order, in O(log n).
+size_t findSortedPosition(const std::vector<FileEntity>& entities, const FileEntity& entity, int order, bool reversed);
+
+} // namespace mod::filemanager
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/Loudness.h"
+#include "filemanager/player/TrackProbe.h"
+
+#include "recorder/LevelMeter.h"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <lame/lame.h>
+
+#include <numbers>
+
+namespace mod::filemanager {
+
+constexpr int    STEP_MS         = 100;
+constexpr int    STEPS_PER_BLOCK = 4; // 400ms blocks, a new one every step.
+constexpr double ABSOLUTE_GATE   = -70;
+constexpr double RELATIVE_GATE   = -10;
+
+constexpr float REFERENCE_LOUDNESS = -18; // LUFS, ReplayGain 2.0.
+constexpr float MAX_GAIN           = 12;  // the range of the gain stage above unity, see ASound.
+constexpr float MIN_GAIN           = -24;
+
+constexpr size_t READ_SIZE  = 16 * 1024;
+constexpr size_t MAX_FRAMES = 1152; // samples per channel in an MPEG frame.
+
+QDataStream& operator<<(QDataStream& stream, const TrackLoudness& loudness) {
+    return stream << loudness.mLoudness << loudness.mPeak;
+}
+
+QDataStream& operator>>(QDataStream& stream, TrackLoudness& loudness) {
+    return stream >> loudness.mLoudness >> loudness.mPeak;
+}
+
+// Samples in [-1, 1), squared they come out in LKFS once the -0.691 offset is applied.
+static double toLoudness(double meanSquare) { return -0.691 + 10 * std::log10(meanSquare); }
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+: mStates(channels),
+  mChannels(channels),
+  mStepFrames((size_t)sampleRate * STEP_MS / 1000) {
+    // The filters of BS.1770 given for 48kHz, derived again for the actual rate.
+    auto fs = (double)sampleRate;
+    {
+        constexpr double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+
+        auto k  = std::tan(std::numbers::pi * f0 / fs);
+        auto vh = std::pow(10.0, gain / 20);
+        auto vb = std::pow(vh, 0.4996667741545416);
+        auto a0 = 1 + k / q + k * k;
+        mShelf  = {
+            (vh + vb * k / q + k * k) / a0,
+            2 * (k * k - vh) / a0,
+            (vh - vb * k / q + k * k) / a0,
+            2 * (k * k - 1) / a0,
+            (1 - k / q + k * k) / a0
+        };
+    }
+    {
+        constexpr double f0 = 38.13547087602444, q = 0.5003270373238773;
+
+        auto k    = std::tan(std::numbers::pi * f0 / fs);
+        auto a0   = 1 + k / q + k * k;
+        mHighPass = {1, -2, 1, 2 * (k * k - 1) / a0, (1 - k / q + k * k) / a0};
+    }
+}
+
+void LoudnessMeter::add(const int16* samples, size_t count) {
+    // The filters run sample by sample, the peak doesn't have to.
+    mPeak = std::max(mPeak, measureLevel(samples, count).mPeak);
+
+    auto frames = count / mChannels;
+    for (size_t i = 0; i < frames; i++) {
+        for (int ch = 0; ch < mChannels; ch++) {
+            auto& state = mStates[ch];
+            auto  x     = samples[i * mChannels + ch] / 32768.0;
+
+            // Transposed direct form II, both stages.
+            auto y    = mShelf.b0 * x + state.z1;
+            state.z1  = mShelf.b1 * x - mShelf.a1 * y + state.z2;
+            state.z2  = mShelf.b2 * x - mShelf.a2 * y;
+            auto z    = mHighPass.b0 * y + state.w1;
+            state.w1  = mHighPass.b1 * y - mHighPass.a1 * z + state.w2;
+            state.w2  = mHighPass.b2 * y - mHighPass.a2 * z;
+            mEnergy  += z * z;
+        }
+        if (++mFrames == mStepFrames) {
+            mSteps.emplace_back(mEnergy / (double)mStepFrames);
+            mFrames = 0;
+            mEnergy = 0;
+        }
+    }
+}
+
+std::optional<TrackLoudness> LoudnessMeter::getResult() const {
+    if (mSteps.size() < STEPS_PER_BLOCK) {
+        return std::nullopt;
+    }
+    std::vector<double> blocks;
+    blocks.reserve(mSteps.size() - STEPS_PER_BLOCK + 1);
+    double window = 0;
+    for (size_t i = 0; i < mSteps.size(); i++) {
+        window += mSteps[i];
+        if (i >= STEPS_PER_BLOCK) {
+            window -= mSteps[i - STEPS_PER_BLOCK];
+        }
+        if (i + 1 >= STEPS_PER_BLOCK) {
+            blocks.emplace_back(std::max(window / STEPS_PER_BLOCK, 0.0));
+        }
+    }
+    auto gatedMean = [&](double gate) {
+        double sum   = 0;
+        size_t count = 0;
+        for (auto block : blocks) {
+            if (block > 0 && toLoudness(block) > gate) {
+                sum += block;
+                count++;
+            }
+        }
+        return count ? std::optional(sum / (double)count) : std::nullopt;
+    };
+    auto absolute = gatedMean(ABSOLUTE_GATE);
+    if (!absolute) {
+        return std::nullopt;
+    }
+    auto relative = gatedMean(toLoudness(*absolute) + RELATIVE_GATE);
+    BlockLevel peak{0, 0, mPeak};
+    return TrackLoudness{(float)toLoudness(relative.value_or(*absolute)), peak.getPeakDb()};
+}
+
+std::optional<TrackLoudness> analyzeLoudness(const QString& path, const std::atomic<bool>& cancelled) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    auto decoder = hip_decode_init();
+    if (!decoder) {
+        return std::nullopt;
+    }
+    std::unique_ptr<std::remove_pointer_t<hip_t>, decltype(&hip_decode_exit)> guard(decoder, hip_decode_exit);
+
+    std::optional<LoudnessMeter> meter;
+    std::vector<uchar>           input(READ_SIZE);
+    std::vector<short>           left(MAX_FRAMES), right(MAX_FRAMES), interleaved(MAX_FRAMES * 2);
+    mp3data_struct               info{};
+
+    // A cover in the tag may hold bytes that look like a frame header, the decoder would sync on them.
+    if (file.read((char*)input.data(), 10) == 10) {
+        file.seek((qint64)getId3v2Size(input.data()));
+    } else {
+        return std::nullopt;
+    }
+    for (auto decoding = true; decoding && !cancelled;) {
+        auto read = file.read((char*)input.data(), (qint64)input.size());
+        if (read <= 0) {
+            break;
+        }
+        // One frame per call, the rest of the input stays buffered in the decoder.
+        for (auto size = (size_t)read;; size = 0) {
+            auto frames = hip_decode1_headers(decoder, input.data(), size, left.data(), right.data(), &info);
+            if (frames <= 0) {
+                // A broken frame ends the track there, as it does for the player.
+                decoding = frames == 0;
+                break;
+            }
+            if (!meter) {
+                if (!info.header_parsed || info.samplerate <= 0 || info.stereo < 1 || info.stereo > 2) {
+                    return std::nullopt;
+                }
+                meter.emplace(info.samplerate, info.stereo);
+            }
+            if (info.stereo == 1) {
+                meter->add(left.data(), frames);
+                continue;
+            }
+            for (int i = 0; i < frames; i++) {
+                interleaved[i * 2]     = left[i];
+                interleaved[i * 2 + 1] = right[i];
+            }
+            meter->add(interleaved.data(), (size_t)frames * 2);
+        }
+    }
+    if (cancelled || !meter) {
+        return std::nullopt;
+    }
+    return meter->getResult();
+}
+
+float getNormalizationGain(const TrackLoudness& loudness) {
+    auto gain = std::min(REFERENCE_LOUDNESS - loudness.mLoudness, -loudness.mPeak);
+    return std::clamp(gain, MIN_GAIN, MAX_GAIN);
+}
+
+} // namespace mod::filemanager
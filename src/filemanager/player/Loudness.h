@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+class QDataStream;
+
+namespace mod::filemanager {
+
+// What ReplayGain 2.0 keeps of a track.
+struct TrackLoudness {
+    float mLoudness{}; // LUFS, integrated over the whole track.
+    float mPeak{};     // dBFS, sample peak.
+};
+
+QDataStream& operator<<(QDataStream& stream, const TrackLoudness& loudness);
+
+QDataStream& operator>>(QDataStream& stream, TrackLoudness& loudness);
+
+// Integrated loudness as in ITU-R BS.1770 (K-weighting, 400ms blocks overlapping by 75%, absolute gate at -70LUFS
+// and relative gate 10LU below), which ReplayGain 2.0 is based on.
+// Only the mean square of every 100ms step is kept, 40 bytes per second of audio.
+class LoudnessMeter {
+public:
+    LoudnessMeter(int sampleRate, int channels);
+
+    // Interleaved, `count` samples of all channels.
+    void add(const int16* samples, size_t count);
+
+    // nullopt if everything was below the absolute gate.
+    [[nodiscard]] std::optional<TrackLoudness> getResult() const;
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct ChannelState {
+        double z1{}, z2{}; // shelf
+        double w1{}, w2{}; // high-pass
+    };
+
+    Biquad                    mShelf;
+    Biquad                    mHighPass;
+    std::vector<ChannelState> mStates;
+    int                       mChannels;
+    size_t                    mStepFrames;
+
+    size_t              mFrames{}; // in the current step.
+    double              mEnergy{}; // of the current step, channels summed.
+    std::vector<double> mSteps;    // mean square of every completed step.
+    int                 mPeak{};
+};
+
+// Decodes the MP3 file and measures it, nullopt if it can't be decoded or `cancelled` was set.
+std::optional<TrackLoudness> analyzeLoudness(const QString& path, const std::atomic<bool>& cancelled);
+
+// dB to play the track at the reference level, lowered so that the peak stays below full scale.
+float getNormalizationGain(const TrackLoudness& loudness);
+
+} // namespace mod::filemanager
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/LoudnessStore.h"
+
+#include "common/util/System.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+
+namespace mod::filemanager {
+
+constexpr quint32 CACHE_MAGIC   = 0x504D4C4E; // "PMLN"
+constexpr quint32 CACHE_VERSION = 2;
+constexpr auto    CACHE_FILE    = "loudness.cache";
+
+LoudnessStore::LoudnessStore() : Logger("LoudnessStore") {
+    mWorker = std::thread(&LoudnessStore::_workerLoop, this);
+}
+
+LoudnessStore::~LoudnessStore() {
+    {
+        std::lock_guard lock(mMutex);
+        mExiting = true;
+        mRequests.clear();
+    }
+    mCondition.notify_one();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+}
+
+void LoudnessStore::request(const QString& path, int64 size, int64 mtime) {
+    {
+        std::lock_guard lock(mMutex);
+        if (std::any_of(mRequests.begin(), mRequests.end(), [&](auto& item) { return item.mPath == path; })) {
+            return;
+        }
+        mRequests.push_back({path, size, mtime});
+    }
+    mCondition.notify_one();
+}
+
+std::optional<TrackLoudness> LoudnessStore::get(const QString& path, int64 size, int64 mtime) const {
+    std::lock_guard lock(mMutex);
+    if (auto it = mCache.constFind(path); it != mCache.constEnd() && it->mSize == size && it->mMtime == mtime) {
+        return it->mLoudness;
+    }
+    return std::nullopt;
+}
+
+void LoudnessStore::_workerLoop() {
+    _load();
+    while (true) {
+        Request request;
+        {
+            std::unique_lock lock(mMutex);
+            if (mRequests.empty()) {
+                lock.unlock();
+                _save();
+                lock.lock();
+            }
+            mCondition.wait(lock, [this]() { return mExiting || !mRequests.empty(); });
+            if (mExiting) {
+                return;
+            }
+            request = std::move(mRequests.front());
+            mRequests.pop_front();
+            auto it = mCache.constFind(request.mPath);
+            if (it != mCache.constEnd() && it->mSize == request.mSize && it->mMtime == request.mMtime) {
+                request.mPath.clear(); // up to date.
+            }
+        }
+        if (request.mPath.isEmpty()) {
+            continue;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        auto loudness = analyzeLoudness(request.mPath, mExiting);
+        if (mExiting) {
+            return;
+        }
+        if (loudness) {
+            debug(
+                "Measured {} in {}ms: {:.1f}LUFS, peak {:.1f}dBFS.",
+                request.mPath.toStdString(),
+                timer.elapsed(),
+                loudness->mLoudness,
+                loudness->mPeak
+            );
+        } else {
+            warn("Unable to measure {}.", request.mPath.toStdString());
+        }
+        {
+            std::lock_guard lock(mMutex);
+            mCache.insert(request.mPath, {request.mSize, request.mMtime, loudness});
+            mDirty = true;
+        }
+    }
+}
+
+void LoudnessStore::_load() {
+    QFile in(util::getCachePath(CACHE_FILE));
+    if (!in.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&in);
+    quint32     magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        return;
+    }
+    QHash<QString, CachedTrack> cache;
+    cache.reserve((int)count);
+    for (uint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString path;
+        qint64  size, mtime;
+        stream >> path >> size >> mtime;
+        CachedTrack track{size, mtime, std::nullopt};
+        stream >> track.mLoudness.emplace();
+        cache.insert(path, std::move(track));
+    }
+    if (stream.status() != QDataStream::Ok) {
+        warn("Loudness cache is corrupted, dropped.");
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    mCache = std::move(cache);
+    info("Loaded {} measured tracks.", mCache.size());
+}
+
+void LoudnessStore::_save() {
+    QHash<QString, CachedTrack> cache;
+    {
+        std::lock_guard lock(mMutex);
+        if (!mDirty) {
+            return;
+        }
+        cache  = mCache;
+        mDirty = false;
+    }
+    // Deleted files would otherwise stay in the cache forever.
+    QStringList missing;
+    quint32     count = 0;
+    for (auto it = cache.constBegin(); it != cache.constEnd(); ++it) {
+        if (!QFile::exists(it.key())) {
+            missing.append(it.key());
+        } else if (it->mLoudness) {
+            count++;
+        }
+    }
+    if (!missing.isEmpty()) {
+        std::lock_guard lock(mMutex);
+        for (auto& path : missing) {
+            cache.remove(path);
+            mCache.remove(path);
+        }
+    }
+    QSaveFile out(util::getCachePath(CACHE_FILE));
+    if (!out.open(QIODevice::WriteOnly)) {
+        warn("Failed to save the loudness cache.");
+        return;
+    }
+    QDataStream stream(&out);
+    stream << CACHE_MAGIC << CACHE_VERSION << count;
+    for (auto it = cache.constBegin(); it != cache.constEnd(); ++it) {
+        // Failures are only kept for this session, the track may be readable after the next boot.
+        if (it->mLoudness) {
+            stream << it.key() << (qint64)it->mSize << (qint64)it->mMtime << *it->mLoudness;
+        }
+    }
+    if (stream.status() != QDataStream::Ok || !out.commit()) {
+        warn("Failed to save the loudness cache.");
+    }
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/player/Loudness.h"
+
+#include "common/service/Logger.h"
+
+#include <QHash>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace mod::filemanager {
+
+// Measures the loudness of tracks on a worker thread, one at a time since the whole track is decoded,
+// and keeps it in a persistent cache keyed by (path, size, mtime).
+class LoudnessStore : public QObject, public Singleton<LoudnessStore>, private Logger {
+    Q_OBJECT
+
+public:
+    ~LoudnessStore() override;
+
+    // Queue `path` (absolute), `size` and `mtime` (ms) are those of the file now, a stale entry is measured again.
+    // A track already queued is not queued twice.
+    void request(const QString& path, int64 size, int64 mtime);
+
+    // nullopt if not measured yet, stale, or the track couldn't be measured.
+    [[nodiscard]] std::optional<TrackLoudness> get(const QString& path, int64 size, int64 mtime) const;
+
+private:
+    friend Singleton<LoudnessStore>;
+    explicit LoudnessStore();
+
+    struct Request {
+        QString mPath;
+        int64   mSize;
+        int64   mMtime;
+    };
+
+    struct CachedTrack {
+        int64                        mSize;
+        int64                        mMtime;
+        std::optional<TrackLoudness> mLoudness; // nullopt if it couldn't be measured, not saved.
+    };
+
+    std::thread             mWorker;
+    mutable std::mutex      mMutex;
+    std::condition_variable mCondition;
+    std::deque<Request>     mRequests;
+    std::atomic<bool>       mExiting{false};
+
+    // Guarded by mMutex, only written by the worker.
+    QHash<QString, CachedTrack> mCache;
+    bool                        mDirty{false};
+
+    void _workerLoop();
+
+    void _load();
+
+    void _save();
+};
+
+} // namespace mod::filemanager
@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/Lyrics.h"
+
+#include "common/util/TextEncoding.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+namespace mod::filemanager {
+
+static QString decode(const QByteArray& data) {
+    // Lyrics downloaded by older Chinese tools are GB18030.
+    auto [encoding, bomSize] = util::detectEncoding(data.constData(), data.size());
+    return util::decodeText(data.constData() + bomSize, data.size() - bomSize, encoding);
+}
+
+// "mm:ss", "mm:ss.x", "mm:ss.xx", "mm:ss.xxx" or "mm:ss:xx", in ms. -1 if it isn't a timestamp.
+static int64 parseTimestamp(const QChar* it, const QChar* end) {
+    auto readNumber = [&](int maxDigits, int& digits) {
+        int64 value = 0;
+        digits      = 0;
+        while (it != end && it->isDigit() && digits < maxDigits) {
+            value = value * 10 + it->digitValue();
+            it++;
+            digits++;
+        }
+        return value;
+    };
+    int  digits;
+    auto minutes = readNumber(4, digits);
+    if (digits == 0 || it == end || *it != ':') {
+        return -1;
+    }
+    it++;
+    auto seconds = readNumber(2, digits);
+    if (digits == 0) {
+        return -1;
+    }
+    int64 ms = 0;
+    if (it != end && (*it == '.' || *it == ':')) {
+        it++;
+        ms = readNumber(3, digits);
+        ms *= digits == 1 ? 100 : (digits == 2 ? 10 : 1);
+    }
+    if (it != end) {
+        return -1;
+    }
+    return (minutes * 60 + seconds) * 1000 + ms;
+}
+
+Lyrics Lyrics::parse(const QByteArray& data) {
+    struct RawLine {
+        int64   mTime;
+        QString mText;
+    };
+    Lyrics               lyrics;
+    int64                offset = 0;
+    std::vector<RawLine> raw;
+    std::vector<int64>   times;
+    for (auto& line : decode(data).split('\n')) {
+        times.clear();
+        int pos = 0;
+        while (pos < line.size() && line[pos] == '[') {
+            auto close = line.indexOf(']', pos);
+            if (close < 0) {
+                break;
+            }
+            auto time = parseTimestamp(line.constData() + pos + 1, line.constData() + close);
+            if (time < 0) {
+                // An ID tag, only meaningful on a line of its own.
+                if (times.empty()) {
+                    auto tag   = line.mid(pos + 1, close - pos - 1);
+                    auto colon = tag.indexOf(':');
+                    auto key   = tag.left(colon).trimmed().toLower();
+                    auto value = tag.mid(colon + 1).trimmed();
+                    if (key == "ti") lyrics.mTitle = value;
+                    else if (key == "ar") lyrics.mArtist = value;
+                    else if (key == "al") lyrics.mAlbum = value;
+                    else if (key == "offset") offset = value.toLongLong();
+                }
+                break;
+            }
+            times.emplace_back(time);
+            pos = close + 1;
+        }
+        if (times.empty()) {
+            continue;
+        }
+        auto text = line.mid(pos).trimmed();
+        for (auto time : times) {
+            raw.push_back({time, text});
+        }
+    }
+    // Stable, so that the translation stays after the original sharing its timestamp.
+    std::stable_sort(raw.begin(), raw.end(), [](const RawLine& a, const RawLine& b) { return a.mTime < b.mTime; });
+
+    lyrics.mLines.reserve(raw.size());
+    for (size_t i = 0; i < raw.size();) {
+        auto      time = raw[i].mTime;
+        LyricLine line{std::max<int64>(0, time - offset), {}, {}}; // a positive offset shows lyrics sooner.
+        for (; i < raw.size() && raw[i].mTime == time; i++) {
+            auto& text = raw[i].mText;
+            if (text.isEmpty()) {
+                continue; // Blank lines clear the display, unless the timestamp has text anyway.
+            }
+            if (line.mText.isEmpty()) {
+                line.mText = text;
+            } else if (line.mTranslation.isEmpty()) {
+                line.mTranslation      = text;
+                lyrics.mHasTranslation = true;
+            }
+        }
+        lyrics.mLines.emplace_back(std::move(line));
+    }
+    return lyrics;
+}
+
+int Lyrics::indexAt(int64 position) const {
+    auto it = std::upper_bound(mLines.begin(), mLines.end(), position, [](int64 pos, const LyricLine& line) {
+        return pos < line.mTime;
+    });
+    return (int)(it - mLines.begin()) - 1;
+}
+
+QString Lyrics::getText(int idx, LrcState state) const {
+    if (idx < 0 || idx >= (int)mLines.size()) {
+        return {};
+    }
+    auto& line = mLines[idx];
+    switch (state) {
+    case LrcState::BILINGUAL:
+        return line.mTranslation.isEmpty() ? line.mText : line.mText + '\n' + line.mTranslation;
+    case LrcState::ORIGINAL:
+        return line.mText;
+    case LrcState::TRANS:
+        return line.mTranslation.isEmpty() ? line.mText : line.mTranslation;
+    case LrcState::HIDE:
+    default:
+        return {};
+    }
+}
+
+// LyricsCache
+
+LyricsCache::LyricsCache(int capacity) : mCapacity(std::max(capacity, 1)) {}
+
+std::shared_ptr<const Lyrics> LyricsCache::get(const QString& path) {
+    QFileInfo info(path);
+    auto      mtime = info.lastModified().toMSecsSinceEpoch();
+    auto      size  = info.size();
+    if (auto it = mEntries.constFind(path); it != mEntries.constEnd() && it->mMtime == mtime && it->mSize == size) {
+        mOrder.removeOne(path);
+        mOrder.append(path);
+        return it->mLyrics;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    auto lyrics = std::make_shared<const Lyrics>(Lyrics::parse(file.readAll()));
+    if (!mEntries.contains(path)) {
+        mOrder.append(path);
+    }
+    mEntries.insert(path, {mtime, size, lyrics});
+    while (mOrder.size() > mCapacity) {
+        mEntries.remove(mOrder.takeFirst());
+    }
+    return lyrics;
+}
+
+} // namespace mod::filemanager
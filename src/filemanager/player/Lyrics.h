@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <QHash>
+
+namespace mod::filemanager {
+
+// Lyrics display mode of the stock player.
+enum class LrcState {
+    BILINGUAL,
+    ORIGINAL,
+    TRANS,
+    HIDE,
+};
+
+struct LyricLine {
+    int64   mTime; // ms, offset applied.
+    QString mText;
+    QString mTranslation; // the second line sharing the timestamp, if any.
+};
+
+// A parsed .lrc file, lines sorted by time.
+class Lyrics {
+public:
+    // Lines with several timestamps are repeated, [offset:] is applied, [ti:]/[ar:]/[al:] are kept.
+    // UTF-8 (with or without BOM) is tried first, then GB18030.
+    static Lyrics parse(const QByteArray& data);
+
+    // Index of the line shown at `position` (ms), -1 before the first one. O(log n).
+    [[nodiscard]] int indexAt(int64 position) const;
+
+    // The line as shown in `state`, TRANS falls back to the original text when there is no translation.
+    [[nodiscard]] QString getText(int idx, LrcState state) const;
+
+    [[nodiscard]] std::vector<LyricLine> const& getLines() const { return mLines; }
+
+    [[nodiscard]] bool isEmpty() const { return mLines.empty(); }
+
+    [[nodiscard]] bool hasTranslation() const { return mHasTranslation; }
+
+    QString mTitle;
+    QString mArtist;
+    QString mAlbum;
+
+private:
+    std::vector<LyricLine> mLines;
+    bool                   mHasTranslation{};
+};
+
+// Recently parsed lyrics, keyed by path and validated by mtime and size.
+class LyricsCache {
+public:
+    explicit LyricsCache(int capacity = 8);
+
+    // Parsed on a miss, nullptr if the file can't be read.
+    std::shared_ptr<const Lyrics> get(const QString& path);
+
+private:
+    struct Entry {
+        int64                         mMtime;
+        int64                         mSize;
+        std::shared_ptr<const Lyrics> mLyrics;
+    };
+
+    int                   mCapacity;
+    QHash<QString, Entry> mEntries;
+    QStringList           mOrder; // most recent last.
+};
+
+} // namespace mod::filemanager
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/MetadataStore.h"
+
+#include "common/util/System.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+
+namespace mod::filemanager {
+
+constexpr quint32 CACHE_MAGIC   = 0x504D4D44; // "PMMD"
+constexpr quint32 CACHE_VERSION = 1;
+constexpr auto    CACHE_FILE    = "metadata.cache";
+constexpr int64   BATCH_PERIOD  = 200; // ms
+
+MetadataStore::MetadataStore() : Logger("MetadataStore") {
+    mWorker = std::thread(&MetadataStore::_workerLoop, this);
+}
+
+MetadataStore::~MetadataStore() {
+    {
+        std::lock_guard lock(mMutex);
+        mExiting = true;
+        mRequests.clear();
+    }
+    mCondition.notify_one();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+}
+
+void MetadataStore::request(const QString& path, int64 size, int64 mtime, const QObject* owner) {
+    {
+        std::lock_guard lock(mMutex);
+        mRequests.push_back({path, size, mtime, owner});
+    }
+    mCondition.notify_one();
+}
+
+void MetadataStore::cancel(const QObject* owner) {
+    std::lock_guard lock(mMutex);
+    std::erase_if(mRequests, [owner](const Request& request) { return request.mOwner == owner; });
+}
+
+std::optional<TrackMetadata> MetadataStore::get(const QString& path) const {
+    std::lock_guard lock(mMutex);
+    if (auto it = mCache.constFind(path); it != mCache.constEnd()) {
+        return it->mMeta;
+    }
+    return std::nullopt;
+}
+
+void MetadataStore::_workerLoop() {
+    _load();
+    QStringList   ready;
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+    auto flush = [&]() {
+        if (!ready.isEmpty()) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, paths = std::move(ready)]() { emit metadataReady(paths); },
+                Qt::QueuedConnection
+            );
+            ready.clear();
+        }
+        sinceFlush.restart();
+    };
+    while (true) {
+        Request request;
+        {
+            std::unique_lock lock(mMutex);
+            if (mRequests.empty()) {
+                lock.unlock();
+                flush();
+                // Written once the queue drains, never in the middle of a folder.
+                _save();
+                lock.lock();
+            }
+            mCondition.wait(lock, [this]() { return mExiting || !mRequests.empty(); });
+            if (mExiting) {
+                return;
+            }
+            request = std::move(mRequests.front());
+            mRequests.pop_front();
+            auto it = mCache.constFind(request.mPath);
+            if (it != mCache.constEnd() && it->mSize == request.mSize && it->mMtime == request.mMtime) {
+                ready.append(request.mPath);
+                request.mPath.clear(); // up to date.
+            }
+        }
+        if (!request.mPath.isEmpty()) {
+            auto meta = readTrackMetadata(request.mPath);
+            {
+                std::lock_guard lock(mMutex);
+                mCache.insert(request.mPath, {request.mSize, request.mMtime, std::move(meta)});
+                mDirty = true;
+            }
+            ready.append(request.mPath);
+        }
+        if (sinceFlush.elapsed() >= BATCH_PERIOD) {
+            flush();
+        }
+    }
+}
+
+void MetadataStore::_load() {
+    QFile in(util::getCachePath(CACHE_FILE));
+    if (!in.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&in);
+    quint32     magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        return;
+    }
+    QHash<QString, CachedTrack> cache;
+    cache.reserve((int)count);
+    for (uint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString path;
+        qint64  size, mtime;
+        bool    valid;
+        stream >> path >> size >> mtime >> valid;
+        CachedTrack track{size, mtime, std::nullopt};
+        if (valid) {
+            stream >> track.mMeta.emplace();
+        }
+        cache.insert(path, std::move(track));
+    }
+    if (stream.status() != QDataStream::Ok) {
+        warn("Metadata cache is corrupted, dropped.");
+        return;
+    }
+    std::lock_guard lock(mMutex);
+    mCache = std::move(cache);
+    info("Loaded {} cached tracks.", mCache.size());
+}
+
+void MetadataStore::_save() {
+    QHash<QString, CachedTrack> cache;
+    {
+        std::lock_guard lock(mMutex);
+        if (!mDirty) {
+            return;
+        }
+        cache  = mCache; // implicitly shared, detached below only if something is pruned.
+        mDirty = false;
+    }
+    // Deleted files would otherwise stay in the cache forever.
+    QStringList missing;
+    for (auto it = cache.constBegin(); it != cache.constEnd(); ++it) {
+        if (!QFile::exists(it.key())) {
+            missing.append(it.key());
+        }
+    }
+    if (!missing.isEmpty()) {
+        std::lock_guard lock(mMutex);
+        for (auto& path : missing) {
+            cache.remove(path);
+            mCache.remove(path);
+        }
+    }
+    QSaveFile out(util::getCachePath(CACHE_FILE));
+    if (!out.open(QIODevice::WriteOnly)) {
+        warn("Failed to save the metadata cache.");
+        return;
+    }
+    QDataStream stream(&out);
+    stream << CACHE_MAGIC << CACHE_VERSION << (quint32)cache.size();
+    for (auto it = cache.constBegin(); it != cache.constEnd(); ++it) {
+        stream << it.key() << (qint64)it->mSize << (qint64)it->mMtime << it->mMeta.has_value();
+        if (it->mMeta) {
+            stream << *it->mMeta;
+        }
+    }
+    if (stream.status() != QDataStream::Ok || !out.commit()) {
+        warn("Failed to save the metadata cache.");
+    }
+}
+
+} // namespace mod::filemanager
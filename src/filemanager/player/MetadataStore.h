@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/player/TrackMetadata.h"
+
+#include "common/service/Logger.h"
+
+#include <QHash>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace mod::filemanager {
+
+// Reads track metadata on a worker thread, and keeps it in a persistent cache keyed by (path, size, mtime).
+class MetadataStore : public QObject, public Singleton<MetadataStore>, private Logger {
+    Q_OBJECT
+
+public:
+    ~MetadataStore() override;
+
+    // Queue `path` (absolute), `size` and `mtime` (ms) are those of the file now, a stale entry is read again.
+    // Cached files are reported as ready too, so that callers don't have to look them up first.
+    // `owner` only tags the request for cancel().
+    void request(const QString& path, int64 size, int64 mtime, const QObject* owner = nullptr);
+
+    // Drop the queued requests of `owner`, e.g. when the file list leaves the directory.
+    void cancel(const QObject* owner);
+
+    // What was read for `path`, regardless of whether the file changed since.
+    [[nodiscard]] std::optional<TrackMetadata> get(const QString& path) const;
+
+signals:
+
+    // Batched, at most a few times per second.
+    void metadataReady(const QStringList& paths);
+
+private:
+    friend Singleton<MetadataStore>;
+    explicit MetadataStore();
+
+    struct Request {
+        QString        mPath;
+        int64          mSize;
+        int64          mMtime;
+        const QObject* mOwner;
+    };
+
+    struct CachedTrack {
+        int64                        mSize;
+        int64                        mMtime;
+        std::optional<TrackMetadata> mMeta; // nullopt if the file isn't readable MPEG audio.
+    };
+
+    std::thread             mWorker;
+    mutable std::mutex      mMutex;
+    std::condition_variable mCondition;
+    std::deque<Request>     mRequests;
+    bool                    mExiting{false};
+
+    // Guarded by mMutex, only written by the worker.
+    QHash<QString, CachedTrack> mCache;
+    bool                        mDirty{false};
+
+    void _workerLoop();
+
+    void _load();
+
+    void _save();
+};
+
+} // namespace mod::filemanager
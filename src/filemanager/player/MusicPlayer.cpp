@@ -5,34 +5,64 @@
  */
 
 #include "filemanager/player/MusicPlayer.h"
+#include "filemanager/FileManager.h"
+#include "filemanager/player/LoudnessStore.h"
+#include "filemanager/player/MetadataStore.h"
+#include "filemanager/player/TrackProbe.h"
 
 #include "base/YPointer.h"
 
 #include "common/Event.h"
 #include "common/Utils.h"
+#include "common/util/System.h"
 
+#include "system/sound/ASound.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QQmlContext>
-#include <QRandomGenerator>
 
 #define PLAYER_FAKE_COLUMN_ID ("fake_column_hsxjsbw")
 
 namespace mod::filemanager {
 
+constexpr int    PREPARE_DELAY     = 3000; // ms, leave the start of a track to the decoder.
+constexpr size_t MAX_PREPARE_TRIES = 8;
+constexpr size_t LOAD_CHUNK        = 256;
+constexpr int    LOAD_INTERVAL     = 20; // ms, between background chunks.
+
+// Positions, in ms.
+constexpr int   POSITION_INTERVAL = 5000;
+constexpr int   FLUSH_TICKS       = 12;        // written once a minute while playing.
+constexpr int64 MIN_DURATION      = 5 * 60000; // shorter tracks just start over.
+constexpr int64 MIN_POSITION      = 15000;     // not worth resuming.
+constexpr int64 END_MARGIN        = 15000;     // close enough to the end to count as finished.
+constexpr int   RESUME_DELAY      = 300;       // the decoder ignores seeks until it is running.
+
 bool MusicPlayer::mIsTakeOver{false};
 
-MusicPlayer::MusicPlayer() : Logger("MusicPlayer") {
+MusicPlayer::MusicPlayer() : Logger("MusicPlayer"), mPositions(util::getCachePath("positions")) {
+    mPositionTimer.setInterval(POSITION_INTERVAL);
+    connect(&mPositionTimer, &QTimer::timeout, [this]() {
+        _capturePosition();
+        if (++mPositionTicks % FLUSH_TICKS == 0) {
+            mPositions.flush();
+        }
+    });
+    mPrepareTimer.setSingleShot(true);
+    mPrepareTimer.setInterval(PREPARE_DELAY);
+    connect(&mPrepareTimer, &QTimer::timeout, [this]() { _prepareNext(); });
+    mLoadTimer.setInterval(LOAD_INTERVAL);
+    connect(&mLoadTimer, &QTimer::timeout, [this]() {
+        _loadUntil(mPlayList.size() + LOAD_CHUNK);
+        if (!mSource) mLoadTimer.stop();
+    });
+    connect(&MetadataStore::getInstance(), &MetadataStore::metadataReady, this, &MusicPlayer::onMetadataReady);
     connect(&Event::getInstance(), &Event::beforeUiInitialization, [this](QQuickView& view, QQmlContext* context) {
         context->setContextProperty("musicPlayer", this);
     });
 }
 
-enum class LrcState {
-    BILINGUAL,
-    ORIGINAL,
-    TRANS,
-    HIDE,
-};
-
 enum class DownloadState { NOT, SUCCEED, ING, FAILURE, CANCEL, PAUSE };
 
 struct YMediaEntity {
@@ -59,6 +89,8 @@ struct YColumnMediaEntity : public YMediaEntity {
 
 static_assert(sizeof(YColumnMediaEntity) == 0x68);
 
+MusicPlayer::~MusicPlayer() { mPositions.flush(); }
+
 void MusicPlayer::play(size_t idx) {
     if (idx > mPlayList.size() - 1) return;
     auto file = mPlayList.at(idx);
@@ -66,19 +98,113 @@ void MusicPlayer::play(size_t idx) {
         PEN_CALL(void*, "_ZN7YGlobal15showAudioPlayerEv", void*)(YPointer<YGlobal>::getInstance());
         return;
     }
+    _stopTracking(false);
     mCurrentPlaying.setPlaying(idx);
-    _play(file);
+    mShuffle.setCurrent(idx);
+    _play(file, _findLyrics(file), true);
+}
+
+void MusicPlayer::setPlayList(PlayList list) {
+    mSource.reset();
+    mLoadTimer.stop();
+    auto common = std::min(mPlayList.size(), list.size());
+    auto diff   = (size_t)0;
+    while (diff < common && mPlayList.getPath(diff) == list.getPath(diff)) {
+        diff++;
+    }
+    auto tailEqual = [&]() {
+        for (auto i = diff; i < list.size(); i++) {
+            if (mPlayList.getPath(i + 1) != list.getPath(i)) return false;
+        }
+        return true;
+    };
+    if (diff == common) {
+        // Appended or truncated.
+        mShuffle.resize(list.size());
+    } else if (mPlayList.size() == list.size() + 1 && tailEqual()) {
+        // One track removed.
+        mShuffle.remove(diff);
+    } else {
+        mShuffle.reset(list.size());
+    }
+    // Keep pointing at the same track, so that next/prev go on from it.
+    if (mCurrentPlaying.mIndex < mPlayList.size()) {
+        if (auto idx = list.indexOf(mPlayList.getPath(mCurrentPlaying.mIndex))) {
+            mCurrentPlaying.mIndex = *idx;
+            mShuffle.setCurrent(*idx);
+        }
+    }
+    mPlayList = std::move(list);
+    mPrepared.reset();
+    if (!mCurrentPlaying.mIsEnd) {
+        mPrepareTimer.start();
+    }
+}
+
+void MusicPlayer::playSource(std::unique_ptr<PlayListSource> source, const QString& startPath) {
+    mSource = std::move(source);
+    mLoadTimer.stop();
+    mPlayList = {};
+    mShuffle.reset(0);
+    mPrepared.reset();
+    // Load until the first track to play shows up, that's usually the first chunk.
+    std::optional<size_t> start;
+    while (mSource && !start) {
+        auto from = mPlayList.size();
+        _loadUntil(from + LOAD_CHUNK);
+        if (startPath.isEmpty()) {
+            start = mPlayList.empty() ? std::nullopt : std::optional<size_t>(0);
+        } else {
+            start = mPlayList.indexOf(startPath, from);
+        }
+    }
+    if (mPlayList.empty()) {
+        warn("Nothing to play in the play list.");
+        return;
+    }
+    mCurrentPlaying.mIsEnd = true; // a new list, even if the same file is playing.
+    play(start.value_or(0));
+    if (getCurrentAudioSequence() == AudioSequence::RANDOM) {
+        _loadInBackground();
+    }
 }
 
-void MusicPlayer::_play(const std::shared_ptr<QFileInfo>& file) {
+bool MusicPlayer::savePlayList(const QString& file) {
+    _loadUntil(SIZE_MAX);
+    return mPlayList.saveM3u(file);
+}
+
+void MusicPlayer::_loadUntil(size_t count) {
+    if (!mSource || mPlayList.size() >= count) {
+        return;
+    }
+    while (mPlayList.size() < count) {
+        if (!mSource->fill(mPlayList, std::min(count - mPlayList.size(), LOAD_CHUNK))) {
+            mSource.reset();
+            break;
+        }
+    }
+    mShuffle.resize(mPlayList.size());
+}
+
+void MusicPlayer::_loadInBackground() {
+    if (mSource && !mLoadTimer.isActive()) {
+        mLoadTimer.start();
+    }
+}
+
+void MusicPlayer::_play(const PlayFile& file, const QString& lrcFile, bool showPlayer) {
     mIsTakeOver = true;
+    _updateMetadata(file);
+    auto title = mMetadata.mArtist.isEmpty() ? mMetadata.mTitle : mMetadata.mArtist + " - " + mMetadata.mTitle;
     PEN_CALL(void, "_ZN19YMediaPlayerManager8wipeDataEv", void*)(YPointer<YMediaPlayerManager>::getInstance());
     PEN_CALL(bool, "_ZN7YGlobal23setAudioPlayingColomnIdERK7QString", void*, QString const&)
     (YPointer<YGlobal>::getInstance(), "myimport");
+    _applyLoudness(*file);
     auto memory = new char[sizeof(YColumnMediaEntity)];
     PEN_CALL(void, "_ZN18YColumnMediaEntityC2EP7QObject", void*, void*)(memory, nullptr);
     auto       entity  = reinterpret_cast<YColumnMediaEntity*>(memory);
-    bool       hasLrc  = false;
+    bool       hasLrc  = _loadLyrics(lrcFile);
     static int mediaId = 0;
     mediaId--;
     entity->mId            = mediaId;
@@ -88,18 +214,15 @@ void MusicPlayer::_play(const std::shared_ptr<QFileInfo>& file) {
     entity->mIsDir         = false;
     entity->mDownloadState = DownloadState::SUCCEED;
     entity->mLocalFile     = file->absoluteFilePath();
-    entity->mTitle         = file->fileName();
-    auto matchName         = file->completeBaseName();
-    for (const auto& i : file->absoluteDir().entryInfoList()) {
-        if (i.suffix().toLower() == "lrc" && i.completeBaseName() == matchName) {
-            entity->mLrcFile = i.absoluteFilePath();
-            hasLrc           = true;
-            break;
-        }
-    }
+    entity->mTitle         = title;
+    entity->mLrcFile       = hasLrc ? lrcFile : QString();
+    entity->mLrcState      = mLrcState;
     PEN_CALL(void*, "_ZN13YMediaManager9playAudioERK18YColumnMediaEntityb", void*, YColumnMediaEntity*, bool)
     (YPointer<YMediaManager>::getInstance(), entity, true);
-    PEN_CALL(void*, "_ZN7YGlobal15showAudioPlayerEv", void*)(YPointer<YGlobal>::getInstance());
+    // Already on screen when switching tracks by itself, showing it again flashes.
+    if (showPlayer) {
+        PEN_CALL(void*, "_ZN7YGlobal15showAudioPlayerEv", void*)(YPointer<YGlobal>::getInstance());
+    }
     delete entity;
     entity = nullptr; // entity is copied.
     if (*(PlayState*)((uintptr_t*)YPointer<YMediaPlayerManager>::getInstance() + 168) != PlayState::PLAYING) {
@@ -108,50 +231,331 @@ void MusicPlayer::_play(const std::shared_ptr<QFileInfo>& file) {
         PEN_CALL(void, "_ZN19YMediaPlayerManager9setHasLrcEb", void*, bool)
         (YPointer<YMediaPlayerManager>::getInstance(), hasLrc);
     }
+    mPrepared.reset();
+    mPrepareTimer.start();
+    _trackPosition(file);
+}
+
+QString MusicPlayer::getTitle() const { return mMetadata.mTitle; }
+
+QString MusicPlayer::getArtist() const { return mMetadata.mArtist; }
+
+QString MusicPlayer::getAlbum() const { return mMetadata.mAlbum; }
+
+qint64 MusicPlayer::getDuration() const { return mMetadata.mDuration; }
+
+void MusicPlayer::onMetadataReady(const QStringList& paths) {
+    if (mMetadataPath.isEmpty() || !paths.contains(mMetadataPath)) {
+        return;
+    }
+    if (auto meta = MetadataStore::getInstance().get(mMetadataPath)) {
+        auto title = mMetadata.mTitle;
+        mMetadata  = *meta;
+        if (mMetadata.mTitle.isEmpty()) {
+            mMetadata.mTitle = title;
+        }
+        emit metadataChanged();
+    }
+}
+
+void MusicPlayer::_updateMetadata(const PlayFile& file) {
+    mMetadataPath = file->absoluteFilePath();
+    mMetadata     = MetadataStore::getInstance().get(mMetadataPath).value_or(TrackMetadata{});
+    if (mMetadata.mTitle.isEmpty()) {
+        mMetadata.mTitle = file->completeBaseName();
+    }
+    // Cheap when cached and unchanged, it only reports back.
+    MetadataStore::getInstance().request(mMetadataPath, file->size(), file->lastModified().toMSecsSinceEpoch());
+    emit metadataChanged();
+}
+
+void MusicPlayer::onPlayStateChanged(PlayState state) {
+    if (!mIsTakeOver) {
+        return;
+    }
+    // The gain stage carries every sound of the system, prompts and pronunciations must not be boosted.
+    ASound::getInstance().setTrackGain(state == PlayState::PLAYING ? mTrackGain : 0);
+    if (state == PlayState::PLAYING) {
+        mPositionTimer.start();
+        return;
+    }
+    // Paused or stopped, a good moment to write.
+    mPositionTimer.stop();
+    _capturePosition();
+    mPositions.flush();
+}
+
+void MusicPlayer::updateTrackGain() {
+    if (mIsTakeOver && !mMetadataPath.isEmpty()) {
+        _applyLoudness(QFileInfo(mMetadataPath));
+    }
+}
+
+void MusicPlayer::_applyLoudness(const QFileInfo& file) {
+    std::optional<TrackLoudness> loudness;
+    if (FileManager::getInstance().getNormalizeLoudness()) {
+        auto path  = file.absoluteFilePath();
+        auto mtime = file.lastModified().toMSecsSinceEpoch();
+        loudness   = LoudnessStore::getInstance().get(path, file.size(), mtime);
+        if (!loudness) {
+            LoudnessStore::getInstance().request(path, file.size(), mtime);
+        }
+    }
+    mTrackGain = loudness ? getNormalizationGain(*loudness) : 0;
+    // Otherwise applied by onPlayStateChanged() once it plays.
+    auto state = PEN_CALL(PlayState, "_ZNK19YMediaPlayerManager9playStateEv", void*)(
+        YPointer<YMediaPlayerManager>::getInstance()
+    );
+    if (state == PlayState::PLAYING) {
+        ASound::getInstance().setTrackGain(mTrackGain);
+    }
+}
+
+void MusicPlayer::_trackPosition(const PlayFile& file) {
+    mTracked = {file->absoluteFilePath(), file->size()};
+    mPositionTimer.start();
+    auto position = mPositions.get(mTracked.mPath, mTracked.mSize);
+    if (!position) {
+        return;
+    }
+    QTimer::singleShot(RESUME_DELAY, this, [this, path = mTracked.mPath, position = *position]() {
+        if (mTracked.mPath != path) {
+            return; // Switched again in the meantime.
+        }
+        info("Resume {} from {}ms.", path.toStdString(), position);
+        PEN_CALL(void*, "_ZN19YMediaPlayerManager13setCurrentPosERKx", void*, int64 const&)
+        (YPointer<YMediaPlayerManager>::getInstance(), position);
+    });
+}
+
+void MusicPlayer::_capturePosition() {
+    if (mTracked.mPath.isEmpty()) {
+        return;
+    }
+    auto position = _getCurrentPosition();
+    if (!position) {
+        return;
+    }
+    auto duration = mMetadataPath == mTracked.mPath ? mMetadata.mDuration : 0;
+    if (duration > 0 && duration < MIN_DURATION) {
+        return;
+    }
+    if (*position < MIN_POSITION || (duration > 0 && *position > duration - END_MARGIN)) {
+        mPositions.remove(mTracked.mPath);
+        return;
+    }
+    mPositions.set(mTracked.mPath, mTracked.mSize, *position);
+}
+
+void MusicPlayer::_stopTracking(bool finished) {
+    if (mTracked.mPath.isEmpty()) {
+        return;
+    }
+    if (finished) {
+        mPositions.remove(mTracked.mPath);
+    } else {
+        _capturePosition();
+    }
+    mTracked = {};
+    mPositionTimer.stop();
+    mPositions.flush();
+}
+
+std::optional<int64> MusicPlayer::_getCurrentPosition() {
+    // Not called by the stock player itself, resolved lazily so that a missing symbol only disables resuming.
+    static auto* getter = PEN_SYM("_ZNK19YMediaPlayerManager10currentPosEv");
+    if (!getter) {
+        return std::nullopt;
+    }
+    return ((int64(*)(void*))getter)(YPointer<YMediaPlayerManager>::getInstance());
+}
+
+bool MusicPlayer::hasLyrics() const { return mCurrentLyrics && !mCurrentLyrics->isEmpty(); }
+
+bool MusicPlayer::hasTranslation() const { return mCurrentLyrics && mCurrentLyrics->hasTranslation(); }
+
+int MusicPlayer::getLrcState() const { return (int)mLrcState; }
+
+void MusicPlayer::setLrcState(int state) {
+    if ((int)mLrcState != state && state >= (int)LrcState::BILINGUAL && state <= (int)LrcState::HIDE) {
+        mLrcState = (LrcState)state;
+        emit lrcStateChanged();
+    }
+}
+
+int MusicPlayer::lyricIndexAt(qint64 position) const { return mCurrentLyrics ? mCurrentLyrics->indexAt(position) : -1; }
+
+QString MusicPlayer::lyricText(int idx) const {
+    return mCurrentLyrics ? mCurrentLyrics->getText(idx, mLrcState) : QString();
+}
+
+bool MusicPlayer::_loadLyrics(const QString& lrcFile) {
+    mCurrentLyrics = lrcFile.isEmpty() ? nullptr : mLyricsCache.get(lrcFile);
+    emit lyricsChanged();
+    // Files without a single timed line would show an empty lyrics page.
+    return hasLyrics();
+}
+
+QString MusicPlayer::_findLyrics(const PlayFile& file) {
+    if (file->absolutePath() != mLyricsDir) {
+        refreshLyrics(file->absolutePath());
+    }
+    return mLyrics.value(file->completeBaseName());
+}
+
+void MusicPlayer::_prepareNext() {
+    if (mCurrentPlaying.mIsEnd || mPlayList.empty()) {
+        return;
+    }
+    auto sequence = getCurrentAudioSequence();
+    auto current  = mCurrentPlaying.mIndex;
+    if (sequence == AudioSequence::ORDER) {
+        _loadUntil(current + MAX_PREPARE_TRIES + 1);
+    } else if (sequence == AudioSequence::RANDOM) {
+        _loadInBackground();
+    }
+    for (size_t tries = 0; tries < MAX_PREPARE_TRIES; tries++) {
+        std::optional<size_t> idx;
+        switch (sequence) {
+        case AudioSequence::ORDER:
+            idx = (current + tries + 1) % mPlayList.size();
+            break;
+        case AudioSequence::RANDOM:
+            // Peeked once, so that the shuffle doesn't change under the prepared track.
+            if (tries == 0) idx = mShuffle.peek();
+            break;
+        case AudioSequence::SINGLE:
+            if (tries == 0) idx = current;
+            break;
+        case AudioSequence::SINGLE_SHOT:
+            break;
+        }
+        if (!idx) {
+            return;
+        }
+        auto file = mPlayList[*idx];
+        // Also warms the page cache for the decoder.
+        if (!probeTrack(file->absoluteFilePath()).mValid) {
+            warn("Skipped undecodable track: {}", file->fileName().toStdString());
+            continue;
+        }
+        // Tags are read by the time the track starts, and its loudness likely measured.
+        MetadataStore::getInstance().request(
+            file->absoluteFilePath(),
+            file->size(),
+            file->lastModified().toMSecsSinceEpoch()
+        );
+        if (FileManager::getInstance().getNormalizeLoudness()) {
+            LoudnessStore::getInstance().request(
+                file->absoluteFilePath(),
+                file->size(),
+                file->lastModified().toMSecsSinceEpoch()
+            );
+        }
+        auto lrcFile = _findLyrics(file);
+        if (!lrcFile.isEmpty()) {
+            mLyricsCache.get(lrcFile); // parsed ahead, the switch only looks it up.
+        }
+        mPrepared = PreparedTrack{sequence, *idx, file, lrcFile};
+        return;
+    }
+}
+
+bool MusicPlayer::_playPrepared() {
+    if (!mPrepared) {
+        return false;
+    }
+    auto prepared = std::move(*mPrepared);
+    mPrepared.reset();
+    // Stale if the sequence or the play list changed in the meantime.
+    if (prepared.mSequence != getCurrentAudioSequence() || prepared.mIndex >= mPlayList.size()
+        || mPlayList.getPath(prepared.mIndex) != prepared.mFile->absoluteFilePath()) {
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (prepared.mSequence == AudioSequence::RANDOM) {
+        mShuffle.next(); // moves to the peeked track.
+    }
+    int64 pos = 0;
+    PEN_CALL(void*, "_ZN19YMediaPlayerManager13setCurrentPosERKx", void*, void*)
+    (YPointer<YMediaPlayerManager>::getInstance(), &pos);
+    PEN_CALL(void*, "_ZN19YMediaPlayerManager11closeRepeatEv", void*)(YPointer<YMediaPlayerManager>::getInstance());
+    mCurrentPlaying.setPlaying(prepared.mIndex);
+    mShuffle.setCurrent(prepared.mIndex);
+    _play(prepared.mFile, prepared.mLrcFile, false);
+    debug("Switched to the prepared track in {}us.", timer.nsecsElapsed() / 1000);
+    return true;
+}
+
+void MusicPlayer::refreshLyrics(const QString& dir) {
+    mLyricsDir = dir;
+    mLyrics.clear();
+    for (const auto& i : QDir(dir).entryInfoList({"*.lrc"}, QDir::Files)) {
+        if (i.suffix().toLower() == "lrc") {
+            mLyrics.insert(i.completeBaseName(), i.absoluteFilePath());
+        }
+    }
 }
 
 void MusicPlayer::clickNext() {
+    _stopTracking(false);
     int64 pos = 0;
     PEN_CALL(void*, "_ZN19YMediaPlayerManager13setCurrentPosERKx", void*, int64 const&)
     (YPointer<YMediaPlayerManager>::getInstance(), pos);
     PEN_CALL(void*, "_ZN19YMediaPlayerManager11closeRepeatEv", void*)(YPointer<YMediaPlayerManager>::getInstance());
     if (mPlayList.empty()) return;
+    _loadUntil(mCurrentPlaying.mIndex + 2);
     auto newIdx = mCurrentPlaying.mIndex + 1;
     if (newIdx > mPlayList.size() - 1) newIdx = 0;
     play(newIdx);
 }
 
 void MusicPlayer::clickPrev() {
+    _stopTracking(false);
     int64 pos = 0;
     PEN_CALL(void*, "_ZN19YMediaPlayerManager13setCurrentPosERKx", void*, void*)
     (YPointer<YMediaPlayerManager>::getInstance(), &pos);
     PEN_CALL(void*, "_ZN19YMediaPlayerManager11closeRepeatEv", void*)(YPointer<YMediaPlayerManager>::getInstance());
     if (mPlayList.empty()) return;
     auto newIdx = mCurrentPlaying.mIndex - 1;
-    if (newIdx > mPlayList.size() - 1) // overflow
+    if (newIdx > mPlayList.size() - 1) { // overflow
+        _loadUntil(SIZE_MAX);
         newIdx = mPlayList.size() - 1;
+    }
     play(newIdx); // back <- front
 }
 
 void MusicPlayer::clickRand() {
+    _stopTracking(false);
     int64 pos = 0;
     PEN_CALL(void*, "_ZN19YMediaPlayerManager13setCurrentPosERKx", void*, void*)
     (YPointer<YMediaPlayerManager>::getInstance(), &pos);
     PEN_CALL(void*, "_ZN19YMediaPlayerManager11closeRepeatEv", void*)(YPointer<YMediaPlayerManager>::getInstance());
     if (mPlayList.empty()) return;
-    std::optional<size_t> newIdx;
-    while (!newIdx) {
-        uint32 switched = QRandomGenerator::global()->bounded((int)mPlayList.size()); // safe, limited by fm.
-        if (mCurrentPlaying.mIndex != switched || mPlayList.size() == 1) {
-            newIdx = switched;
-            break;
-        }
-    }
-    play(*newIdx);
+    _loadInBackground();
+    if (auto newIdx = mShuffle.next()) play(*newIdx);
+}
+
+void MusicPlayer::clickRandPrev() {
+    _stopTracking(false);
+    int64 pos = 0;
+    PEN_CALL(void*, "_ZN19YMediaPlayerManager13setCurrentPosERKx", void*, void*)
+    (YPointer<YMediaPlayerManager>::getInstance(), &pos);
+    PEN_CALL(void*, "_ZN19YMediaPlayerManager11closeRepeatEv", void*)(YPointer<YMediaPlayerManager>::getInstance());
+    if (mPlayList.empty()) return;
+    // Nothing to go back to, continue the shuffle instead.
+    auto newIdx = mShuffle.prev();
+    if (!newIdx) newIdx = mShuffle.next();
+    if (newIdx) play(*newIdx);
 }
 
 void MusicPlayer::onSoundEnd() {
     mCurrentPlaying.mIsEnd = true;
+    _stopTracking(true);
+    if (_playPrepared()) {
+        return;
+    }
     switch (getCurrentAudioSequence()) {
     case AudioSequence::ORDER:
         clickNext();
@@ -184,12 +588,13 @@ using MusicPlayer = mod::filemanager::MusicPlayer;
 
 PEN_HOOK(void*, _ZN13YMediaManager10clickMediaEi, void* a1, void* a2) {
     MusicPlayer::mIsTakeOver = false;
+    mod::ASound::getInstance().setTrackGain(0);
     return origin(a1, a2);
 }
 
 PEN_HOOK(uint64, _ZN19YMediaPlayerManager13onClickedPrevEb, void* self, bool a2) {
     if (!MusicPlayer::mIsTakeOver) return origin(self, a2);
-    if (MusicPlayer::getCurrentAudioSequence() == AudioSequence::RANDOM) MusicPlayer::getInstance().clickRand();
+    if (MusicPlayer::getCurrentAudioSequence() == AudioSequence::RANDOM) MusicPlayer::getInstance().clickRandPrev();
     else MusicPlayer::getInstance().clickPrev();
     return 0;
 }
@@ -8,19 +8,37 @@
 
 #include "base/YEnum.h"
 
+#include "filemanager/player/Lyrics.h"
+#include "filemanager/player/PlayList.h"
+#include "filemanager/player/PositionStore.h"
+#include "filemanager/player/ShuffleQueue.h"
+#include "filemanager/player/TrackMetadata.h"
+
 #include "common/service/Logger.h"
 
 #include <QDir>
+#include <QHash>
+#include <QTimer>
 
 namespace mod::filemanager {
 
-using PlayFile = std::shared_ptr<QFileInfo>;
-using PlayList = std::vector<PlayFile>;
-
 class MusicPlayer : public QObject, public Singleton<MusicPlayer>, private Logger {
     Q_OBJECT
 
+    // Of the current track, the title falls back to the file name until tags are read.
+    Q_PROPERTY(QString title READ getTitle NOTIFY metadataChanged);
+    Q_PROPERTY(QString artist READ getArtist NOTIFY metadataChanged);
+    Q_PROPERTY(QString album READ getAlbum NOTIFY metadataChanged);
+    Q_PROPERTY(qint64 duration READ getDuration NOTIFY metadataChanged);
+
+    // Lyrics of the current track, parsed natively.
+    Q_PROPERTY(bool hasLyrics READ hasLyrics NOTIFY lyricsChanged);
+    Q_PROPERTY(bool hasTranslation READ hasTranslation NOTIFY lyricsChanged);
+    Q_PROPERTY(int lrcState READ getLrcState WRITE setLrcState NOTIFY lrcStateChanged);
+
 public:
+    ~MusicPlayer() override;
+
     void play(size_t idx);
 
     void clickNext();
@@ -29,19 +47,108 @@ public:
 
     void clickRand();
 
+    // "Previous" in random mode, walks back the shuffle history.
+    void clickRandPrev();
+
     void onSoundEnd();
 
-    PlayList& getPlayListRef() { return mPlayList; };
+    PlayList const& getPlayList() const { return mPlayList; };
+
+    // Replace the play list, the shuffle order and current track follow the edit.
+    void setPlayList(PlayList list);
+
+    // Play a list produced by `source`, from `startPath` if given.
+    // Only what playback needs is loaded, except in random mode where the rest is loaded in background.
+    void playSource(std::unique_ptr<PlayListSource> source, const QString& startPath = {});
+
+    // Loads the whole list first if it is still being produced.
+    bool savePlayList(const QString& file);
+
+    // Rebuild the lyrics table of `dir`, the directory being played.
+    void refreshLyrics(const QString& dir);
+
+    [[nodiscard]] QString getTitle() const;
+
+    [[nodiscard]] QString getArtist() const;
+
+    [[nodiscard]] QString getAlbum() const;
+
+    // ms, 0 if unknown.
+    [[nodiscard]] qint64 getDuration() const;
+
+    [[nodiscard]] bool hasLyrics() const;
+
+    [[nodiscard]] bool hasTranslation() const;
+
+    [[nodiscard]] int getLrcState() const;
+
+    void setLrcState(int state);
+
+    // Line shown at `position` (ms), -1 before the first one.
+    Q_INVOKABLE [[nodiscard]] int lyricIndexAt(qint64 position) const;
+
+    // The line as shown in the current lrcState.
+    Q_INVOKABLE [[nodiscard]] QString lyricText(int idx) const;
+
+    void onMetadataReady(const QStringList& paths);
+
+    void onPlayStateChanged(PlayState state);
+
+    // Again for the current track, after the normalization setting changed.
+    void updateTrackGain();
 
     static AudioSequence getCurrentAudioSequence();
 
     static bool mIsTakeOver;
 
+signals:
+
+    void metadataChanged();
+
+    void lyricsChanged();
+
+    void lrcStateChanged();
+
 private:
     friend Singleton<MusicPlayer>;
     explicit MusicPlayer();
 
-    PlayList mPlayList;
+    PlayList     mPlayList;
+    ShuffleQueue mShuffle;
+
+    std::unique_ptr<PlayListSource> mSource; // the rest of mPlayList, if not exhausted yet.
+    QTimer                          mLoadTimer;
+
+    // The track onSoundEnd() will switch to, resolved while the current one is playing.
+    struct PreparedTrack {
+        AudioSequence mSequence;
+        size_t        mIndex;
+        PlayFile      mFile;
+        QString       mLrcFile;
+    };
+    std::optional<PreparedTrack> mPrepared;
+    QTimer                       mPrepareTimer;
+
+    QString       mMetadataPath;
+    TrackMetadata mMetadata;
+    float         mTrackGain{}; // dB, applied while playing only.
+
+    // Where long tracks were left, resumed when they are played again.
+    PositionStore mPositions;
+    QTimer        mPositionTimer;
+    int           mPositionTicks{};
+    struct {
+        QString mPath; // empty when no track is tracked.
+        int64   mSize{};
+    } mTracked;
+
+    LyricsCache                   mLyricsCache;
+    std::shared_ptr<const Lyrics> mCurrentLyrics;
+    LrcState                      mLrcState{LrcState::BILINGUAL};
+
+    // completeBaseName -> absolute path of the .lrc, for mLyricsDir only.
+    QString                 mLyricsDir;
+    QHash<QString, QString> mLyrics;
 
     struct {
         PlayFile mFile;
@@ -55,6 +162,35 @@ private:
 
     } mCurrentPlaying;
 
-    void _play(const PlayFile& file);
+    void _play(const PlayFile& file, const QString& lrcFile, bool showPlayer);
+
+    QString _findLyrics(const PlayFile& file);
+
+    // Returns false if there is nothing to show.
+    bool _loadLyrics(const QString& lrcFile);
+
+    // Makes sure `count` tracks are loaded, or as many as the source has.
+    void _loadUntil(size_t count);
+
+    void _loadInBackground();
+
+    void _updateMetadata(const PlayFile& file);
+
+    // Set when the track starts, a track not measured yet plays as is and is measured for the next time,
+    // changing the level in the middle of it would be worse. Only applied while playing.
+    void _applyLoudness(const QFileInfo& file);
+
+    void _trackPosition(const PlayFile& file);
+
+    void _capturePosition();
+
+    // The tracked track is left, its position is kept unless it was played to the end.
+    void _stopTracking(bool finished);
+
+    static std::optional<int64> _getCurrentPosition();
+
+    void _prepareNext();
+
+    bool _playPrepared();
 };
 } // namespace mod::filemanager
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/PlayList.h"
+#include "filemanager/FileSorter.h"
+
+#include <QDir>
+#include <QSaveFile>
+
+namespace mod::filemanager {
+
+QString PlayList::getPath(size_t idx) const {
+    auto&   track = mTracks[idx];
+    QString path  = mDirs[track.mDir];
+    path.reserve(path.size() + 1 + (int)track.mNameLength);
+    return path.append('/').append(mNames.midRef((int)track.mNameOffset, (int)track.mNameLength));
+}
+
+QString PlayList::getName(size_t idx) const {
+    auto& track = mTracks[idx];
+    return mNames.mid((int)track.mNameOffset, (int)track.mNameLength);
+}
+
+PlayFile PlayList::at(size_t idx) const { return std::make_shared<QFileInfo>(getPath(idx)); }
+
+uint32 PlayList::addDir(const QString& dir) {
+    auto path = dir.endsWith('/') && dir.size() > 1 ? dir.chopped(1) : dir;
+    if (auto it = mDirIndex.constFind(path); it != mDirIndex.constEnd()) {
+        return *it;
+    }
+    auto idx = (uint32)mDirs.size();
+    mDirs.emplace_back(path);
+    mDirIndex.insert(path, idx);
+    return idx;
+}
+
+void PlayList::append(uint32 dir, const QString& name) {
+    mTracks.push_back({dir, (uint32)mNames.size(), (uint32)name.size()});
+    mNames.append(name);
+}
+
+void PlayList::append(const QString& path) {
+    auto slash = path.lastIndexOf('/');
+    append(addDir(path.left(slash)), path.mid(slash + 1));
+}
+
+std::optional<size_t> PlayList::indexOf(const QString& path, size_t from) const {
+    auto slash = path.lastIndexOf('/');
+    auto dir   = mDirIndex.constFind(path.left(slash));
+    if (dir == mDirIndex.constEnd()) {
+        return std::nullopt;
+    }
+    auto name = path.midRef(slash + 1);
+    for (auto i = from; i < mTracks.size(); i++) {
+        auto& track = mTracks[i];
+        if (track.mDir == *dir && mNames.midRef((int)track.mNameOffset, (int)track.mNameLength) == name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+bool PlayList::saveM3u(const QString& file) const {
+    QSaveFile output(file);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    auto base = QFileInfo(file).absoluteDir();
+    output.write("#EXTM3U\n");
+    for (size_t i = 0; i < mTracks.size(); i++) {
+        auto path = base.relativeFilePath(getPath(i));
+        // Only keep it relative while it stays below the list, moving both together keeps it valid.
+        if (path.startsWith("../")) {
+            path = getPath(i);
+        }
+        output.write(path.toUtf8());
+        output.write("\n");
+    }
+    return output.commit();
+}
+
+// DirectorySource
+
+DirectorySource::DirectorySource(const QString& root, bool recursive) : mRecursive(recursive) {
+    mPendingDirs.emplace_back(QDir(root).absolutePath());
+}
+
+static QStringList sortedNames(QStringList names) {
+    std::vector<std::pair<QByteArray, QString>> keyed;
+    keyed.reserve(names.size());
+    for (auto& name : names) {
+        keyed.emplace_back(makeSortKey(name), std::move(name));
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    names.clear();
+    for (auto& i : keyed) {
+        names.append(std::move(i.second));
+    }
+    return names;
+}
+
+bool DirectorySource::fill(PlayList& list, size_t max) {
+    size_t added = 0;
+    while (added < max) {
+        if (mNextFile < mFiles.size()) {
+            list.append(mDir, mFiles[mNextFile++]);
+            added++;
+            continue;
+        }
+        if (mPendingDirs.empty()) {
+            return false;
+        }
+        QDir dir(mPendingDirs.back());
+        mPendingDirs.pop_back();
+        mDir      = list.addDir(dir.absolutePath());
+        mFiles    = sortedNames(dir.entryList({"*.mp3"}, QDir::Files | QDir::NoSymLinks, QDir::Unsorted));
+        mNextFile = 0;
+        if (mRecursive) {
+            // Symbolic links are skipped, they could lead into a cycle.
+            auto subDirs =
+                sortedNames(dir.entryList(QDir::Dirs | QDir::NoSymLinks | QDir::NoDotAndDotDot, QDir::Unsorted));
+            for (auto it = subDirs.rbegin(); it != subDirs.rend(); it++) {
+                mPendingDirs.emplace_back(dir.absoluteFilePath(*it));
+            }
+        }
+    }
+    return mNextFile < mFiles.size() || !mPendingDirs.empty();
+}
+
+// M3uSource
+
+M3uSource::M3uSource(const QString& file) : mFile(file), mBaseDir(QFileInfo(file).absoluteDir()) {
+    mFile.open(QIODevice::ReadOnly | QIODevice::Text);
+}
+
+bool M3uSource::fill(PlayList& list, size_t max) {
+    if (!mFile.isOpen()) {
+        return false;
+    }
+    size_t added = 0;
+    while (added < max && !mFile.atEnd()) {
+        auto line = QString::fromUtf8(mFile.readLine()).trimmed();
+        // Comments and #EXTINF directives.
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        line.replace('\\', '/');
+        list.append(QDir::cleanPath(mBaseDir.absoluteFilePath(line)));
+        added++;
+    }
+    if (mFile.atEnd()) {
+        mFile.close();
+        return false;
+    }
+    return true;
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+namespace mod::filemanager {
+
+using PlayFile = std::shared_ptr<QFileInfo>;
+
+// Tracks to be played, in order.
+// Stored as (directory index, name) pairs over a shared directory table and name buffer,
+// a track costs about 12 bytes plus its name, whatever the depth of its path.
+class PlayList {
+public:
+    [[nodiscard]] size_t size() const { return mTracks.size(); }
+
+    [[nodiscard]] bool empty() const { return mTracks.empty(); }
+
+    // Absolute path of the track.
+    [[nodiscard]] QString getPath(size_t idx) const;
+
+    [[nodiscard]] QString getName(size_t idx) const;
+
+    // Built on demand, tracks only exist as indices otherwise.
+    [[nodiscard]] PlayFile at(size_t idx) const;
+
+    PlayFile operator[](size_t idx) const { return at(idx); }
+
+    // Returns the index of `dir` (absolute path) in the directory table, adding it if needed.
+    uint32 addDir(const QString& dir);
+
+    void append(uint32 dir, const QString& name);
+
+    void append(const QString& path);
+
+    // Linear, searches [from, size()).
+    [[nodiscard]] std::optional<size_t> indexOf(const QString& path, size_t from = 0) const;
+
+    // Extended M3U, paths relative to the directory of `file` when possible.
+    bool saveM3u(const QString& file) const;
+
+private:
+    struct Track {
+        uint32 mDir;
+        uint32 mNameOffset;
+        uint32 mNameLength;
+    };
+
+    std::vector<QString>   mDirs;
+    QHash<QString, uint32> mDirIndex;
+    std::vector<Track>     mTracks;
+    QString                mNames; // names of all tracks, back to back.
+};
+
+// Produces the tracks of a play list a chunk at a time, so that long ones start instantly.
+class PlayListSource {
+public:
+    virtual ~PlayListSource() = default;
+
+    // Appends up to `max` tracks, returns false once the source is exhausted.
+    virtual bool fill(PlayList& list, size_t max) = 0;
+};
+
+// .mp3 files of a directory in natural order, followed by those of its subdirectories depth-first.
+class DirectorySource : public PlayListSource {
+public:
+    explicit DirectorySource(const QString& root, bool recursive);
+
+    bool fill(PlayList& list, size_t max) override;
+
+private:
+    bool                 mRecursive;
+    std::vector<QString> mPendingDirs; // a stack, the next one at the back.
+    uint32               mDir{};
+    QStringList          mFiles;
+    int                  mNextFile{};
+};
+
+// Lines of a .m3u/.m3u8 file, read as far as needed.
+class M3uSource : public PlayListSource {
+public:
+    explicit M3uSource(const QString& file);
+
+    bool fill(PlayList& list, size_t max) override;
+
+private:
+    QFile mFile;
+    QDir  mBaseDir;
+};
+
+} // namespace mod::filemanager
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/PositionStore.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+namespace mod::filemanager {
+
+constexpr quint32 STORE_MAGIC   = 0x504D5053; // "PMPS"
+constexpr quint32 STORE_VERSION = 1;
+
+PositionStore::PositionStore(QString file, size_t capacity) : mFile(std::move(file)), mCapacity(capacity) {}
+
+std::optional<int64> PositionStore::get(const QString& path, int64 size) {
+    _load();
+    auto it = mEntries.find(path);
+    if (it == mEntries.end() || it->mSize != size) {
+        return std::nullopt;
+    }
+    it->mUsed = ++mClock;
+    return it->mPosition;
+}
+
+void PositionStore::set(const QString& path, int64 size, int64 position) {
+    _load();
+    auto& entry = mEntries[path];
+    if (entry.mSize == size && entry.mPosition == position) {
+        return;
+    }
+    entry  = {size, position, ++mClock};
+    mDirty = true;
+    if ((size_t)mEntries.size() > mCapacity) {
+        auto oldest = mEntries.begin();
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->mUsed < oldest->mUsed) oldest = it;
+        }
+        mEntries.erase(oldest);
+    }
+}
+
+void PositionStore::remove(const QString& path) {
+    _load();
+    if (mEntries.remove(path)) {
+        mDirty = true;
+    }
+}
+
+void PositionStore::flush() {
+    if (!mDirty) {
+        return;
+    }
+    QSaveFile out(mFile);
+    if (!out.open(QIODevice::WriteOnly)) {
+        spdlog::warn("Unable to write playback positions to {}.", mFile.toStdString());
+        return;
+    }
+    QDataStream stream(&out);
+    stream << STORE_MAGIC << STORE_VERSION << (quint32)mEntries.size();
+    for (auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it) {
+        stream << it.key() << (qint64)it->mSize << (qint64)it->mPosition << (qint64)it->mUsed;
+    }
+    if (stream.status() == QDataStream::Ok && out.commit()) {
+        mDirty = false;
+    }
+}
+
+void PositionStore::_load() {
+    if (mLoaded) {
+        return;
+    }
+    mLoaded = true;
+    QFile in(mFile);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&in);
+    quint32     magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != STORE_MAGIC || version != STORE_VERSION) {
+        return;
+    }
+    for (uint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString path;
+        qint64  size, position, used;
+        stream >> path >> size >> position >> used;
+        mEntries.insert(path, {size, position, used});
+        mClock = std::max<int64>(mClock, used);
+    }
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <QHash>
+
+namespace mod::filemanager {
+
+// Last playback position per file.
+// Updates stay in memory until flush(), the owner decides when writing is worth it.
+class PositionStore {
+public:
+    explicit PositionStore(QString file, size_t capacity = 1000);
+
+    // ms, nullopt if unknown or if the file changed (by size) since.
+    [[nodiscard]] std::optional<int64> get(const QString& path, int64 size);
+
+    void set(const QString& path, int64 size, int64 position);
+
+    void remove(const QString& path);
+
+    // Writes the store if anything changed since the last flush.
+    void flush();
+
+private:
+    struct Entry {
+        int64 mSize;
+        int64 mPosition;
+        int64 mUsed; // mClock at the last access, the least recent is evicted first.
+    };
+
+    QString               mFile;
+    size_t                mCapacity;
+    QHash<QString, Entry> mEntries;
+    int64                 mClock{};
+    bool                  mDirty{};
+    bool                  mLoaded{};
+
+    void _load();
+};
+
+} // namespace mod::filemanager
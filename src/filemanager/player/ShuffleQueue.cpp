@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/ShuffleQueue.h"
+
+#include <QRandomGenerator>
+
+namespace mod::filemanager {
+
+ShuffleQueue::ShuffleQueue(size_t historyLimit) : mHistoryLimit(std::max<size_t>(historyLimit, 2)) {}
+
+void ShuffleQueue::reset(size_t size) {
+    mOrder.clear();
+    mPosition.clear();
+    mDrawn = 0;
+    mHistory.clear();
+    mCursor = 0;
+    mPeeked.reset();
+    resize(size);
+}
+
+void ShuffleQueue::resize(size_t size) {
+    if (mOrder.size() > size) {
+        _truncate(size);
+    }
+    // New tracks join the part of the round which is not played yet.
+    for (auto idx = (uint32)mOrder.size(); idx < size; idx++) {
+        mPosition.emplace_back(mOrder.size());
+        mOrder.emplace_back(idx);
+    }
+}
+
+void ShuffleQueue::remove(size_t idx) {
+    if (idx >= mOrder.size()) {
+        return;
+    }
+    if (mPeeked == idx) {
+        mPeeked.reset();
+    } else if (mPeeked > idx) {
+        (*mPeeked)--;
+    }
+    auto pos = (size_t)mPosition[idx];
+    if (pos < mDrawn) {
+        _swap(pos, --mDrawn);
+        pos = mDrawn;
+    }
+    _swap(pos, mOrder.size() - 1);
+    mOrder.pop_back();
+    mPosition.erase(mPosition.begin() + (ptrdiff_t)idx);
+    for (auto& i : mOrder) {
+        if (i > idx) {
+            i--;
+        }
+    }
+    for (size_t i = 0; i < mOrder.size(); i++) {
+        mPosition[mOrder[i]] = i;
+    }
+    for (size_t i = 0; i < mHistory.size();) {
+        if (mHistory[i] == idx) {
+            mHistory.erase(mHistory.begin() + (ptrdiff_t)i);
+            if (mCursor > i || mCursor == mHistory.size()) {
+                mCursor = mCursor ? mCursor - 1 : 0;
+            }
+            continue;
+        }
+        if (mHistory[i] > idx) {
+            mHistory[i]--;
+        }
+        i++;
+    }
+}
+
+void ShuffleQueue::setCurrent(size_t idx) {
+    if (idx >= mOrder.size()) {
+        return;
+    }
+    if (!mHistory.empty() && mHistory[mCursor] == idx) {
+        return;
+    }
+    // After _pushHistory(), which returns a peeked track to the round.
+    _pushHistory(idx);
+    _markDrawn(idx);
+}
+
+std::optional<size_t> ShuffleQueue::next() {
+    if (mOrder.empty()) {
+        return std::nullopt;
+    }
+    // Went back before, replay what was played after it.
+    if (!mHistory.empty() && mCursor + 1 < mHistory.size()) {
+        if (++mCursor + 1 == mHistory.size()) {
+            mPeeked.reset();
+        }
+        return mHistory[mCursor];
+    }
+    auto idx = _draw();
+    _pushHistory(idx);
+    return idx;
+}
+
+std::optional<size_t> ShuffleQueue::peek() {
+    if (mOrder.empty() || mHistory.empty()) {
+        return std::nullopt;
+    }
+    // The draw is kept ahead of the cursor, so that next() replays it.
+    if (mCursor + 1 == mHistory.size()) {
+        mPeeked = _draw();
+        mHistory.emplace_back(*mPeeked);
+        if (mHistory.size() > mHistoryLimit) {
+            mHistory.pop_front();
+            mCursor--;
+        }
+    }
+    return mHistory[mCursor + 1];
+}
+
+std::optional<size_t> ShuffleQueue::prev() {
+    if (mHistory.empty() || mCursor == 0) {
+        return std::nullopt;
+    }
+    return mHistory[--mCursor];
+}
+
+size_t ShuffleQueue::size() const { return mOrder.size(); }
+
+void ShuffleQueue::_truncate(size_t size) {
+    // Kept tracks stay on their side of mDrawn, in the same order.
+    std::vector<uint32> order;
+    order.reserve(size);
+    size_t drawn = 0;
+    for (size_t pos = 0; pos < mOrder.size(); pos++) {
+        if (mOrder[pos] < size) {
+            order.emplace_back(mOrder[pos]);
+            drawn += pos < mDrawn ? 1 : 0;
+        }
+    }
+    mOrder.swap(order);
+    mDrawn = drawn;
+    mPosition.resize(size);
+    for (size_t pos = 0; pos < mOrder.size(); pos++) {
+        mPosition[mOrder[pos]] = pos;
+    }
+    // The cursor stays on its entry, or the closest one before it when that one is gone.
+    std::deque<uint32> history;
+    size_t             cursor = 0;
+    for (size_t i = 0; i < mHistory.size(); i++) {
+        if (mHistory[i] < size) {
+            history.emplace_back(mHistory[i]);
+        }
+        if (i == mCursor) {
+            cursor = history.empty() ? 0 : history.size() - 1;
+        }
+    }
+    mHistory.swap(history);
+    mCursor = cursor;
+    if (mPeeked >= size) {
+        mPeeked.reset();
+    }
+}
+
+void ShuffleQueue::_swap(size_t posA, size_t posB) {
+    std::swap(mOrder[posA], mOrder[posB]);
+    mPosition[mOrder[posA]] = posA;
+    mPosition[mOrder[posB]] = posB;
+}
+
+void ShuffleQueue::_markDrawn(uint32 idx) {
+    if (mDrawn == mOrder.size()) {
+        mDrawn = 0;
+    }
+    auto pos = (size_t)mPosition[idx];
+    if (pos >= mDrawn) {
+        _swap(pos, mDrawn++);
+    }
+}
+
+void ShuffleQueue::_unmarkDrawn(uint32 idx) {
+    auto pos = (size_t)mPosition[idx];
+    if (pos < mDrawn) {
+        _swap(pos, --mDrawn);
+    }
+}
+
+uint32 ShuffleQueue::_draw() {
+    if (mDrawn == mOrder.size()) {
+        mDrawn = 0; // New round.
+    }
+    auto left = mOrder.size() - mDrawn;
+    auto pos  = mDrawn + QRandomGenerator::global()->bounded((quint32)left);
+    // The first track of a round must not be the last one of the previous round.
+    if (!mHistory.empty() && mOrder[pos] == mHistory.back() && left > 1) {
+        pos = mDrawn + (pos - mDrawn + 1 + QRandomGenerator::global()->bounded((quint32)left - 1)) % left;
+    }
+    _swap(pos, mDrawn);
+    return mOrder[mDrawn++];
+}
+
+void ShuffleQueue::_pushHistory(uint32 idx) {
+    if (!mHistory.empty()) {
+        mHistory.erase(mHistory.begin() + (ptrdiff_t)mCursor + 1, mHistory.end());
+    }
+    // Drawn ahead but never played.
+    if (mPeeked) {
+        _unmarkDrawn(*mPeeked);
+        mPeeked.reset();
+    }
+    mHistory.emplace_back(idx);
+    while (mHistory.size() > mHistoryLimit) {
+        mHistory.pop_front();
+    }
+    mCursor = mHistory.size() - 1;
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <deque>
+#include <optional>
+
+namespace mod::filemanager {
+
+// Random play order over playlist indices.
+// A Fisher-Yates shuffle is drawn one step at a time, so every track is played once per round and
+// a step costs O(1) whatever the playlist size. Played tracks are kept in a bounded history,
+// which makes "previous" go back to what was actually played.
+class ShuffleQueue {
+public:
+    explicit ShuffleQueue(size_t historyLimit = 256);
+
+    // Forget everything and start a new round over `size` tracks.
+    void reset(size_t size);
+
+    // Tracks were appended (or removed from the end), the current round goes on.
+    void resize(size_t size);
+
+    // Track `idx` was removed from the playlist, following indices shift down by one.
+    void remove(size_t idx);
+
+    // A track was chosen by the user, it counts as played for this round.
+    void setCurrent(size_t idx);
+
+    std::optional<size_t> next();
+
+    // What next() will return, without moving to it. Nullopt while nothing has been played.
+    // The track is drawn already, but goes back to the round if another one is chosen instead.
+    std::optional<size_t> peek();
+
+    std::optional<size_t> prev();
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    // mOrder[0, mDrawn) have been played this round, mOrder[mDrawn, size) not yet.
+    std::vector<uint32> mOrder;
+    std::vector<uint32> mPosition; // inverse of mOrder.
+    size_t              mDrawn{};
+
+    std::deque<uint32>    mHistory;
+    size_t                mCursor{};
+    size_t                mHistoryLimit;
+    std::optional<uint32> mPeeked; // drawn by peek(), the last entry of mHistory until next() gets to it.
+
+    // Drops the tracks from `size` on, in one pass.
+    void _truncate(size_t size);
+
+    void _swap(size_t posA, size_t posB);
+
+    void _markDrawn(uint32 idx);
+
+    void _unmarkDrawn(uint32 idx);
+
+    uint32 _draw();
+
+    void _pushHistory(uint32 idx);
+};
+
+} // namespace mod::filemanager
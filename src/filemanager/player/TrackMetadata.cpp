@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/TrackMetadata.h"
+#include "filemanager/player/TrackProbe.h"
+
+#include <QDataStream>
+#include <QScopeGuard>
+#include <QTextCodec>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mod::filemanager {
+
+constexpr size_t ID3V1_SIZE     = 128;
+constexpr size_t SYNC_WINDOW    = 64 * 1024;  // searched for the first frame.
+constexpr int    CBR_CHECK_SIZE = 16;         // frames sampled before trusting a constant bitrate.
+constexpr size_t WINDOW_SIZE    = 128 * 1024; // read at once, the sync window and the frames sampled after it.
+
+QDataStream& operator<<(QDataStream& stream, const TrackMetadata& meta) {
+    return stream << meta.mTitle << meta.mArtist << meta.mAlbum << (qint64)meta.mDuration << (qint32)meta.mBitrate
+                  << (qint32)meta.mSampleRate << (qint32)meta.mChannels;
+}
+
+QDataStream& operator>>(QDataStream& stream, TrackMetadata& meta) {
+    qint64 duration;
+    qint32 bitrate, sampleRate, channels;
+    stream >> meta.mTitle >> meta.mArtist >> meta.mAlbum >> duration >> bitrate >> sampleRate >> channels;
+    meta.mDuration   = duration;
+    meta.mBitrate    = bitrate;
+    meta.mSampleRate = sampleRate;
+    meta.mChannels   = channels;
+    return stream;
+}
+
+QString formatDuration(int64 ms) {
+    auto seconds = ms / 1000;
+    if (seconds >= 3600) {
+        return QString("%1:%2:%3")
+            .arg(seconds / 3600)
+            .arg(seconds / 60 % 60, 2, 10, QChar('0'))
+            .arg(seconds % 60, 2, 10, QChar('0'));
+    }
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+static uint32 readBE32(const uint8* data) {
+    return (uint32)data[0] << 24 | (uint32)data[1] << 16 | (uint32)data[2] << 8 | data[3];
+}
+
+static uint32 readSyncSafe(const uint8* data) {
+    return (data[0] & 0x7F) << 21 | (data[1] & 0x7F) << 14 | (data[2] & 0x7F) << 7 | (data[3] & 0x7F);
+}
+
+// "ISO-8859-1" fields written by Chinese tools are GBK nearly every time.
+static QString decodeLegacy(const char* data, int size) {
+    auto end = std::find(data, data + size, '\0');
+    size     = (int)(end - data);
+    if (std::all_of(data, end, [](char c) { return (uint8)c < 0x80; })) {
+        return QString::fromLatin1(data, size).trimmed();
+    }
+    QTextCodec::ConverterState state;
+    auto                       text = QTextCodec::codecForName("UTF-8")->toUnicode(data, size, &state);
+    if (state.invalidChars == 0) {
+        return text.trimmed();
+    }
+    static auto* gb = QTextCodec::codecForName("GB18030");
+    if (gb) {
+        return gb->toUnicode(data, size).trimmed();
+    }
+    return QString::fromLatin1(data, size).trimmed();
+}
+
+static QString decodeUtf16(const uint8* data, size_t size, bool bigEndian) {
+    if (size >= 2 && ((data[0] == 0xFF && data[1] == 0xFE) || (data[0] == 0xFE && data[1] == 0xFF))) {
+        bigEndian = data[0] == 0xFE;
+        data += 2;
+        size -= 2;
+    }
+    QString text;
+    text.reserve((int)(size / 2));
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        auto unit = bigEndian ? (char16_t)(data[i] << 8 | data[i + 1]) : (char16_t)(data[i + 1] << 8 | data[i]);
+        if (unit == 0) {
+            break;
+        }
+        text.append(QChar(unit));
+    }
+    return text.trimmed();
+}
+
+static QString decodeTextFrame(const uint8* data, size_t size) {
+    if (size < 2) {
+        return {};
+    }
+    auto encoding = data[0];
+    data++;
+    size--;
+    switch (encoding) {
+    case 0:
+        return decodeLegacy((const char*)data, (int)size);
+    case 1:
+        return decodeUtf16(data, size, false);
+    case 2:
+        return decodeUtf16(data, size, true);
+    case 3:
+        return QString::fromUtf8((const char*)data, (int)strnlen((const char*)data, size)).trimmed();
+    default:
+        return {};
+    }
+}
+
+// Reads the file through a buffer refilled with pread(). A file truncated meanwhile only ends the read short,
+// where a mapping of it would raise SIGBUS.
+class FileWindow {
+public:
+    explicit FileWindow(int fd) : mFd(fd), mBuffer(WINDOW_SIZE) {}
+
+    // `size` bytes at `pos`, valid until the next call, nullptr if the file ends before.
+    // At most WINDOW_SIZE bytes at once.
+    const uint8* read(size_t pos, size_t size) {
+        if (size > mBuffer.size()) {
+            return nullptr;
+        }
+        if (pos < mBegin || pos + size > mBegin + mSize) {
+            auto read = ::pread(mFd, mBuffer.data(), mBuffer.size(), (off_t)pos);
+            mBegin    = pos;
+            mSize     = read > 0 ? (size_t)read : 0;
+            if (size > mSize) {
+                return nullptr;
+            }
+        }
+        return mBuffer.data() + (pos - mBegin);
+    }
+
+private:
+    int                mFd;
+    std::vector<uint8> mBuffer;
+    size_t             mBegin{};
+    size_t             mSize{};
+};
+
+// Frame by frame, the bodies of frames not looked at (covers mostly) are never read.
+static void readId3v2(FileWindow& file, size_t tagSize, TrackMetadata& meta, int64& declaredLength) {
+    auto* tag = file.read(0, 10);
+    if (!tag) {
+        return;
+    }
+    auto version = tag[3];
+    auto flags   = tag[5];
+    // Unsynchronised tags need a copy to be undone, they are too rare to be worth it.
+    if (version < 2 || version > 4 || (version < 4 && (flags & 0x80))) {
+        return;
+    }
+    size_t pos = 10;
+    if (version >= 3 && (flags & 0x40)) {
+        auto* extended = file.read(pos, 4);
+        if (!extended || pos + 4 > tagSize) {
+            return;
+        }
+        pos += version == 4 ? readSyncSafe(extended) : readBE32(extended) + 4;
+    }
+    size_t idSize     = version == 2 ? 3 : 4;
+    size_t headerSize = version == 2 ? 6 : 10;
+    while (pos + headerSize <= tagSize) {
+        auto* header = file.read(pos, headerSize);
+        if (!header || header[0] == 0) {
+            break;
+        }
+        size_t size;
+        if (version == 2) {
+            size = header[3] << 16 | header[4] << 8 | header[5];
+        } else {
+            size = version == 4 ? readSyncSafe(header + 4) : readBE32(header + 4);
+        }
+        // Compressed, encrypted or unsynchronised frames are skipped.
+        auto skipped = version == 3 ? (header[9] & 0xC0) != 0 : version == 4 && (header[9] & 0x0E) != 0;
+        auto id      = std::string((const char*)header, idSize);
+        pos += headerSize;
+        if (pos + size > tagSize) {
+            break;
+        }
+        QString* field = nullptr;
+        QString  length;
+        if (id == "TIT2" || id == "TT2") {
+            field = &meta.mTitle;
+        } else if (id == "TPE1" || id == "TP1") {
+            field = &meta.mArtist;
+        } else if (id == "TALB" || id == "TAL") {
+            field = &meta.mAlbum;
+        } else if (id == "TLEN" || id == "TLE") {
+            field = &length;
+        }
+        if (field && !skipped) {
+            // nullptr for text frames larger than the window too, those aren't worth reading.
+            if (auto* body = file.read(pos, size)) {
+                *field = decodeTextFrame(body, size);
+            }
+        }
+        if (!length.isEmpty()) {
+            declaredLength = length.toLongLong();
+        }
+        pos += size;
+    }
+}
+
+static void readId3v1(const uint8* tag, TrackMetadata& meta) {
+    // Only fills in what ID3v2 didn't have.
+    if (meta.mTitle.isEmpty()) {
+        meta.mTitle = decodeLegacy((const char*)tag + 3, 30);
+    }
+    if (meta.mArtist.isEmpty()) {
+        meta.mArtist = decodeLegacy((const char*)tag + 33, 30);
+    }
+    if (meta.mAlbum.isEmpty()) {
+        meta.mAlbum = decodeLegacy((const char*)tag + 63, 30);
+    }
+}
+
+// Frame count from a Xing/Info or VBRI header in the first frame, 0 if there is none.
+static uint32 readVbrFrameCount(const uint8* frame, const Mp3FrameHeader& header) {
+    if (header.mLayer != 3) {
+        return 0;
+    }
+    size_t sideInfo = header.mVersion == 1 ? (header.mChannels == 1 ? 17 : 32) : (header.mChannels == 1 ? 9 : 17);
+    auto   xing     = 4 + sideInfo;
+    if (xing + 12 <= (size_t)header.mFrameSize
+        && (memcmp(frame + xing, "Xing", 4) == 0 || memcmp(frame + xing, "Info", 4) == 0)) {
+        auto flags = readBE32(frame + xing + 4);
+        return (flags & 1) ? readBE32(frame + xing + 8) : 0;
+    }
+    constexpr size_t vbri = 4 + 32;
+    if (vbri + 18 <= (size_t)header.mFrameSize && memcmp(frame + vbri, "VBRI", 4) == 0) {
+        return readBE32(frame + vbri + 14);
+    }
+    return 0;
+}
+
+std::optional<TrackMetadata> readTrackMetadata(const QString& path) {
+    auto fd = ::open(path.toUtf8().constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    auto closer = qScopeGuard([fd]() { ::close(fd); });
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size < 10) {
+        return std::nullopt;
+    }
+    // Only a few spots are read, readahead would pull in audio we skip.
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+    auto       size = (size_t)st.st_size;
+    FileWindow file(fd);
+
+    TrackMetadata meta;
+    int64         declaredLength = 0;
+    auto*         head           = file.read(0, 10);
+    if (!head) {
+        return std::nullopt;
+    }
+    auto audioBegin = std::min(getId3v2Size(head), size);
+    auto audioEnd   = size;
+    if (audioBegin > 0) {
+        readId3v2(file, audioBegin, meta, declaredLength);
+    }
+    if (size >= audioBegin + ID3V1_SIZE) {
+        if (auto* tag = file.read(size - ID3V1_SIZE, ID3V1_SIZE); tag && memcmp(tag, "TAG", 3) == 0) {
+            audioEnd -= ID3V1_SIZE;
+            readId3v1(tag, meta);
+        }
+    }
+
+    Mp3FrameHeader first{};
+    auto           window = std::min(audioEnd - audioBegin, SYNC_WINDOW);
+    auto*          sync   = file.read(audioBegin, window);
+    if (!sync) {
+        return std::nullopt;
+    }
+    auto offset = findFirstFrame(sync, window, window == audioEnd - audioBegin, first);
+    if (!offset) {
+        return std::nullopt;
+    }
+    audioBegin += *offset;
+    meta.mSampleRate = first.mSampleRate;
+    meta.mChannels   = first.mChannels;
+
+    auto  audioBytes = (int64)(audioEnd - audioBegin);
+    auto* firstFrame = audioBegin + first.mFrameSize <= audioEnd ? file.read(audioBegin, first.mFrameSize) : nullptr;
+    if (auto frames = firstFrame ? readVbrFrameCount(firstFrame, first) : 0) {
+        meta.mDuration = (int64)frames * first.mSamplesPerFrame * 1000 / first.mSampleRate;
+    } else {
+        // Sample a few frames, a constant bitrate gives the duration from the size alone.
+        auto  pos      = audioBegin;
+        bool  constant = true;
+        int64 frames   = 0;
+        int64 samples  = 0;
+        while (pos + 4 <= audioEnd) {
+            auto* data   = file.read(pos, 4);
+            auto  header = data ? parseMp3FrameHeader(data) : std::nullopt;
+            if (!header) {
+                break;
+            }
+            constant = constant && header->mBitrate == first.mBitrate;
+            if (frames == CBR_CHECK_SIZE && constant) {
+                break;
+            }
+            frames++;
+            samples += header->mSamplesPerFrame;
+            pos += header->mFrameSize;
+        }
+        if (constant) {
+            meta.mDuration = audioBytes * 8 / first.mBitrate;
+        } else {
+            meta.mDuration = samples * 1000 / first.mSampleRate;
+        }
+    }
+    if (meta.mDuration <= 0 && declaredLength > 0) {
+        meta.mDuration = declaredLength;
+    }
+    meta.mBitrate = meta.mDuration > 0 ? (int)(audioBytes * 8 / meta.mDuration) : first.mBitrate;
+    return meta;
+}
+
+} // namespace mod::filemanager
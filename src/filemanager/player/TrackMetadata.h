@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+class QDataStream;
+
+namespace mod::filemanager {
+
+struct TrackMetadata {
+    QString mTitle;
+    QString mArtist;
+    QString mAlbum;
+    int64   mDuration{}; // ms, 0 if unknown.
+    int     mBitrate{};  // kbps, average for VBR.
+    int     mSampleRate{};
+    int     mChannels{};
+};
+
+QDataStream& operator<<(QDataStream& stream, const TrackMetadata& meta);
+
+QDataStream& operator>>(QDataStream& stream, TrackMetadata& meta);
+
+// Reads ID3v2/ID3v1 tags and the duration of an MP3 file.
+// The file is read with pread() through a 128KB window, only the tags, the first frames and (for VBR files without
+// a Xing/VBRI header) the frame headers are read. Returns nullopt if the file has no MPEG audio at all.
+std::optional<TrackMetadata> readTrackMetadata(const QString& path);
+
+// "3:05", "1:02:03".
+QString formatDuration(int64 ms);
+
+} // namespace mod::filemanager
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/player/TrackProbe.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace mod::filemanager {
+
+constexpr size_t PROBE_SIZE     = 64 * 1024;
+constexpr off_t  READ_AHEAD     = 512 * 1024;
+constexpr int    FRAMES_TO_SYNC = 3; // consecutive frames required, so that random bytes don't pass.
+
+// kbps, [version 1 / 2 & 2.5][layer - 1][index]
+static constexpr int BITRATES[2][3][16] = {
+    {{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0},
+     {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 0},
+     {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0}},
+    {{0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0},
+     {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0},
+     {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0}}
+};
+
+static constexpr int SAMPLE_RATES[3] = {44100, 48000, 32000}; // MPEG 1, halved for 2, quartered for 2.5.
+
+std::optional<Mp3FrameHeader> parseMp3FrameHeader(const uint8* data) {
+    if (data[0] != 0xFF || (data[1] & 0xE0) != 0xE0) {
+        return std::nullopt;
+    }
+    auto versionBits = (data[1] >> 3) & 3;
+    auto layerBits   = (data[1] >> 1) & 3;
+    auto bitrateIdx  = data[2] >> 4;
+    auto rateIdx     = (data[2] >> 2) & 3;
+    if (versionBits == 1 || layerBits == 0 || bitrateIdx == 0 || bitrateIdx == 15 || rateIdx == 3) {
+        return std::nullopt; // reserved, or free format which isn't worth supporting.
+    }
+    Mp3FrameHeader header{};
+    header.mVersion    = versionBits == 3 ? 1 : (versionBits == 2 ? 2 : 25);
+    header.mLayer      = 4 - layerBits;
+    header.mBitrate    = BITRATES[header.mVersion == 1 ? 0 : 1][header.mLayer - 1][bitrateIdx];
+    header.mSampleRate = SAMPLE_RATES[rateIdx] >> (header.mVersion == 1 ? 0 : (header.mVersion == 2 ? 1 : 2));
+    header.mChannels   = (data[3] >> 6) == 3 ? 1 : 2;
+    header.mPadding    = (data[2] >> 1) & 1;
+    if (header.mLayer == 1) {
+        header.mSamplesPerFrame = 384;
+        header.mFrameSize       = (12 * header.mBitrate * 1000 / header.mSampleRate + header.mPadding) * 4;
+    } else {
+        header.mSamplesPerFrame = header.mLayer == 3 && header.mVersion != 1 ? 576 : 1152;
+        header.mFrameSize =
+            header.mSamplesPerFrame / 8 * header.mBitrate * 1000 / header.mSampleRate + header.mPadding;
+    }
+    return header;
+}
+
+std::optional<size_t> findFirstFrame(const uint8* data, size_t size, bool complete, Mp3FrameHeader& header) {
+    for (size_t pos = 0; pos + 4 <= size; pos++) {
+        auto first = parseMp3FrameHeader(data + pos);
+        if (!first) {
+            continue;
+        }
+        auto next   = pos + first->mFrameSize;
+        int  frames = 1;
+        while (frames < FRAMES_TO_SYNC && next + 4 <= size) {
+            auto following = parseMp3FrameHeader(data + next);
+            if (!following || following->mSampleRate != first->mSampleRate || following->mLayer != first->mLayer) {
+                break;
+            }
+            next += following->mFrameSize;
+            frames++;
+        }
+        // Short files may end before enough frames are seen, the end of a partial read proves nothing.
+        if (frames == FRAMES_TO_SYNC || (complete && next + 4 > size)) {
+            header = *first;
+            return pos;
+        }
+    }
+    return std::nullopt;
+}
+
+size_t getId3v2Size(const uint8* data) {
+    if (data[0] != 'I' || data[1] != 'D' || data[2] != '3') {
+        return 0;
+    }
+    // Synchsafe integer, 7 bits per byte.
+    size_t size = (data[6] & 0x7F) << 21 | (data[7] & 0x7F) << 14 | (data[8] & 0x7F) << 7 | (data[9] & 0x7F);
+    return 10 + size + ((data[5] & 0x10) ? 10 : 0); // footer.
+}
+
+TrackProbe probeTrack(const QString& path) {
+    TrackProbe probe;
+    auto       fd = ::open(path.toUtf8().constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return probe;
+    }
+    std::vector<uint8> buffer(PROBE_SIZE);
+    auto               read = ::pread(fd, buffer.data(), buffer.size(), 0);
+    if (read >= 10) {
+        auto offset   = (off_t)getId3v2Size(buffer.data());
+        auto complete = read < (ssize_t)buffer.size();
+        if (offset > 0 && offset + 4 > read) {
+            // Tags with embedded covers easily exceed the first read.
+            read     = ::pread(fd, buffer.data(), buffer.size(), offset);
+            complete = read < (ssize_t)buffer.size();
+        } else {
+            buffer.erase(buffer.begin(), buffer.begin() + offset);
+            read -= offset;
+        }
+        if (read > 0) {
+            if (auto pos = findFirstFrame(buffer.data(), read, complete, probe.mFirstFrame)) {
+                probe.mValid       = true;
+                probe.mAudioOffset = offset + (int64)*pos;
+            }
+        }
+        if (probe.mValid) {
+            ::posix_fadvise(fd, 0, probe.mAudioOffset + READ_AHEAD, POSIX_FADV_WILLNEED);
+        }
+    }
+    ::close(fd);
+    return probe;
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+namespace mod::filemanager {
+
+// MPEG audio frame header.
+struct Mp3FrameHeader {
+    int  mVersion;    // 1, 2, or 25 for MPEG 2.5.
+    int  mLayer;      // 1..3
+    int  mBitrate;    // kbps
+    int  mSampleRate; // Hz
+    int  mChannels;
+    int  mFrameSize; // bytes, including the header.
+    int  mSamplesPerFrame;
+    bool mPadding;
+};
+
+// Parses the 4 bytes at `data`, nullopt if they aren't a valid frame header.
+std::optional<Mp3FrameHeader> parseMp3FrameHeader(const uint8* data);
+
+// Offset of the first frame in `data`, followed by enough valid frames to not be random bytes.
+// `complete` tells that `data` runs to the end of the file, only then fewer frames are accepted.
+std::optional<size_t> findFirstFrame(const uint8* data, size_t size, bool complete, Mp3FrameHeader& header);
+
+// Size of the ID3v2 tag at the beginning of a file (0 if there is none), `data` holds at least 10 bytes.
+size_t getId3v2Size(const uint8* data);
+
+// Result of probing the head of an audio file before it is handed to the decoder.
+struct TrackProbe {
+    bool           mValid{};
+    int64          mAudioOffset{}; // the first frame, right after the ID3v2 tag.
+    Mp3FrameHeader mFirstFrame{};
+};
+
+// Checks that the file starts with decodable MPEG audio, and asks the kernel to read ahead its head,
+// so that the decoder doesn't wait for the disk when it is opened.
+TrackProbe probeTrack(const QString& path);
+
+} // namespace mod::filemanager
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/IndexCache.h"
+
+namespace mod::filemanager {
+
+IndexCache::IndexCache(int capacity) : mCapacity(std::max(capacity, 1)) {}
+
+std::shared_ptr<const DocumentIndex> IndexCache::get(const QString& path, int64 size, int64 modifiedTime) {
+    auto it = mEntries.constFind(path);
+    if (it == mEntries.constEnd()) {
+        return nullptr;
+    }
+    if ((*it)->mSize != size || (*it)->mModifiedTime != modifiedTime) {
+        mEntries.remove(path);
+        mOrder.removeOne(path);
+        return nullptr;
+    }
+    mOrder.removeOne(path);
+    mOrder.append(path);
+    return *it;
+}
+
+void IndexCache::put(const QString& path, std::shared_ptr<const DocumentIndex> index) {
+    if (!mEntries.contains(path)) {
+        mOrder.append(path);
+    }
+    mEntries.insert(path, std::move(index));
+    while (mOrder.size() > mCapacity) {
+        mEntries.remove(mOrder.takeFirst());
+    }
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/reader/MarkdownBlocks.h"
+
+namespace mod::filemanager {
+
+// What scanning a document found, enough to open it again without a scan.
+struct DocumentIndex {
+    int64                      mSize{};
+    int64                      mModifiedTime{};
+    util::DetectedEncoding     mEncoding;
+    std::vector<uint32>        mPageEnds; // plain text.
+    std::vector<MarkdownBlock> mBlocks;   // Markdown.
+};
+
+// Indices of the last few documents opened, a few KB each even for a whole novel.
+class IndexCache {
+public:
+    explicit IndexCache(int capacity = 4);
+
+    // nullptr on a miss or if the file changed since.
+    std::shared_ptr<const DocumentIndex> get(const QString& path, int64 size, int64 modifiedTime);
+
+    void put(const QString& path, std::shared_ptr<const DocumentIndex> index);
+
+private:
+    int                                                  mCapacity;
+    QHash<QString, std::shared_ptr<const DocumentIndex>> mEntries;
+    QStringList                                          mOrder; // most recent last.
+};
+
+} // namespace mod::filemanager
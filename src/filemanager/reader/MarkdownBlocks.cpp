@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/MarkdownBlocks.h"
+
+namespace mod::filemanager {
+
+using Type = MarkdownBlock::Type;
+
+constexpr size_t FIRST_BATCH = 32; // about two screens, shown before the rest is split.
+constexpr size_t BATCH       = 1024;
+
+enum class LineKind : uint8 { Blank, Text, Indented, Heading, Setext, Rule, Fence, Item, Quote, Row };
+
+static bool isRule(const QString& trimmed, QChar mark) {
+    int count = 0;
+    for (auto ch : trimmed) {
+        if (ch == mark) {
+            count++;
+        } else if (ch != ' ' && ch != '\t') {
+            return false;
+        }
+    }
+    return count >= 3;
+}
+
+static bool isListItem(const QString& trimmed) {
+    if (trimmed.size() >= 2 && (trimmed[0] == '-' || trimmed[0] == '*' || trimmed[0] == '+')) {
+        return trimmed[1] == ' ' || trimmed[1] == '\t';
+    }
+    int digits = 0;
+    while (digits < trimmed.size() && digits < 10 && trimmed[digits].isDigit()) {
+        digits++;
+    }
+    return digits > 0 && digits + 1 < trimmed.size() && (trimmed[digits] == '.' || trimmed[digits] == ')')
+        && trimmed[digits + 1] == ' ';
+}
+
+static LineKind classify(const QString& line, const QString& trimmed) {
+    if (trimmed.isEmpty()) {
+        return LineKind::Blank;
+    }
+    if (trimmed.startsWith("```") || trimmed.startsWith("~~~")) {
+        return LineKind::Fence;
+    }
+    if (trimmed[0] == '#') {
+        int level = 1;
+        while (level < trimmed.size() && trimmed[level] == '#') {
+            level++;
+        }
+        if (level <= 6 && (level == trimmed.size() || trimmed[level] == ' ')) {
+            return LineKind::Heading;
+        }
+    }
+    if (isRule(trimmed, '-')) {
+        return trimmed.contains(' ') ? LineKind::Rule : LineKind::Setext;
+    }
+    if (isRule(trimmed, '*') || isRule(trimmed, '_')) {
+        return LineKind::Rule;
+    }
+    if (std::all_of(trimmed.begin(), trimmed.end(), [](QChar ch) { return ch == '='; })) {
+        return LineKind::Setext;
+    }
+    if (trimmed[0] == '>') {
+        return LineKind::Quote;
+    }
+    if (isListItem(trimmed)) {
+        return LineKind::Item;
+    }
+    if (trimmed[0] == '|') {
+        return LineKind::Row;
+    }
+    return line[0] == ' ' || line[0] == '\t' ? LineKind::Indented : LineKind::Text;
+}
+
+// Type of a block whose first line is `kind`.
+static Type startedBy(LineKind kind) {
+    switch (kind) {
+    case LineKind::Item:
+        return Type::List;
+    case LineKind::Quote:
+        return Type::Quote;
+    case LineKind::Row:
+        return Type::Table;
+    default:
+        return Type::Paragraph;
+    }
+}
+
+bool splitMarkdown(
+    const TextDocument&                                    document,
+    const std::atomic<bool>&                               cancelled,
+    const std::function<void(std::vector<MarkdownBlock>)>& onBlocks
+) {
+    std::vector<MarkdownBlock>   batch;
+    std::optional<MarkdownBlock> current;
+    QString                      fence;
+    size_t                       published = 0;
+
+    auto flush = [&]() {
+        if (!current) {
+            return;
+        }
+        batch.emplace_back(*current);
+        current.reset();
+        if (batch.size() >= (published ? BATCH : FIRST_BATCH)) {
+            published += batch.size();
+            onBlocks(std::move(batch));
+            batch.clear();
+        }
+    };
+    auto start = [&](size_t begin, size_t end, Type type) {
+        flush();
+        current = MarkdownBlock{(uint32)begin, (uint32)end, type};
+    };
+
+    auto size = document.getSize();
+    for (auto pos = document.getTextBegin(), end = pos; pos < size; pos = end) {
+        if (cancelled) {
+            return false;
+        }
+        end          = document.findLineEnd(pos, size);
+        end          = end ? end : size;
+        auto line    = document.decode(pos, end);
+        auto trimmed = line.trimmed();
+
+        if (current && current->mType == Type::Code) {
+            current->mEnd = (uint32)end;
+            if (trimmed.startsWith(fence)) {
+                flush();
+            }
+            continue;
+        }
+        auto kind = classify(line, trimmed);
+        // Plain lines are picked up by the block above, like Markdown's lazy continuation.
+        auto continues = [&]() {
+            if (!current) {
+                return false;
+            }
+            switch (kind) {
+            case LineKind::Text:
+            case LineKind::Indented:
+                return true;
+            case LineKind::Item:
+                return current->mType == Type::List;
+            case LineKind::Quote:
+                return current->mType == Type::Quote;
+            case LineKind::Row:
+                return current->mType == Type::Table;
+            default:
+                return false;
+            }
+        };
+
+        switch (kind) {
+        case LineKind::Blank:
+            flush();
+            break;
+        case LineKind::Fence:
+            start(pos, end, Type::Code);
+            fence = trimmed.left(3);
+            break;
+        case LineKind::Setext:
+            if (current && current->mType == Type::Paragraph) {
+                current->mEnd  = (uint32)end;
+                current->mType = Type::Heading;
+                flush();
+            } else {
+                start(pos, end, trimmed[0] == '-' ? Type::Rule : Type::Paragraph);
+            }
+            break;
+        case LineKind::Heading:
+        case LineKind::Rule:
+            start(pos, end, kind == LineKind::Heading ? Type::Heading : Type::Rule);
+            flush();
+            break;
+        default:
+            if (continues()) {
+                current->mEnd = (uint32)end;
+            } else {
+                start(pos, end, startedBy(kind));
+            }
+            break;
+        }
+    }
+    flush();
+    onBlocks(std::move(batch));
+    return true;
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/reader/TextDocument.h"
+
+namespace mod::filemanager {
+
+// A top-level Markdown block, as a byte range of the document.
+struct MarkdownBlock {
+    enum class Type : uint8 { Paragraph, Heading, List, Quote, Code, Table, Rule };
+
+    uint32 mBegin{};
+    uint32 mEnd{};
+    Type   mType{};
+};
+
+// Splits a document into blocks in one pass over its lines, `onBlocks` gets them a batch at a time.
+// Only what is needed to find block boundaries is recognized, the content is left to the renderer.
+// Returns false if cancelled.
+bool splitMarkdown(
+    const TextDocument&                                    document,
+    const std::atomic<bool>&                               cancelled,
+    const std::function<void(std::vector<MarkdownBlock>)>& onBlocks
+);
+
+} // namespace mod::filemanager
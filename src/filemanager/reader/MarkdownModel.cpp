@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/MarkdownModel.h"
+
+#include <QTextDocument>
+
+namespace mod::filemanager {
+
+constexpr int CACHED_BLOCKS = 64;
+
+static QString const& typeName(MarkdownBlock::Type type) {
+    static const QString names[] = {"paragraph", "heading", "list", "quote", "code", "table", "rule"};
+    return names[(uint8)type];
+}
+
+MarkdownModel::MarkdownModel(QObject* parent) : QAbstractListModel(parent), mHtml(CACHED_BLOCKS) {}
+
+int MarkdownModel::rowCount(const QModelIndex& parent) const { return parent.isValid() ? 0 : (int)mBlocks.size(); }
+
+QVariant MarkdownModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || !mDocument || index.row() >= (int)mBlocks.size()) {
+        return {};
+    }
+    auto row = index.row();
+    switch ((UserRoles)role) {
+    case UserRoles::Type:
+        return typeName(mBlocks[row].mType);
+    case UserRoles::Markdown:
+        return _getMarkdown(row);
+    case UserRoles::Html: {
+        if (auto* html = mHtml.object(row)) {
+            return *html;
+        }
+        QTextDocument converter;
+        converter.setMarkdown(_getMarkdown(row), QTextDocument::MarkdownDialectGitHub);
+        auto html = converter.toHtml();
+        mHtml.insert(row, new QString(html));
+        return html;
+    }
+    case UserRoles::Offset:
+        return (qint64)mBlocks[row].mBegin;
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> MarkdownModel::roleNames() const {
+    return QHash<int, QByteArray>{
+        {(int)UserRoles::Type,     "type"    },
+        {(int)UserRoles::Markdown, "markdown"},
+        {(int)UserRoles::Html,     "html"    },
+        {(int)UserRoles::Offset,   "offset"  }
+    };
+}
+
+void MarkdownModel::setDocument(std::shared_ptr<TextDocument> document) {
+    beginResetModel();
+    mDocument = std::move(document);
+    mBlocks.clear();
+    mHtml.clear();
+    endResetModel();
+}
+
+void MarkdownModel::append(std::vector<MarkdownBlock> blocks) {
+    if (blocks.empty()) {
+        return;
+    }
+    beginInsertRows({}, (int)mBlocks.size(), (int)(mBlocks.size() + blocks.size()) - 1);
+    mBlocks.insert(mBlocks.end(), blocks.begin(), blocks.end());
+    endInsertRows();
+}
+
+int MarkdownModel::blockAt(qint64 offset) const {
+    auto it = std::upper_bound(mBlocks.begin(), mBlocks.end(), offset, [](qint64 offset, const MarkdownBlock& block) {
+        return offset < (qint64)block.mBegin;
+    });
+    return it == mBlocks.begin() ? 0 : (int)(it - mBlocks.begin()) - 1;
+}
+
+QString MarkdownModel::_getMarkdown(int row) const {
+    auto& block = mBlocks[row];
+    return mDocument->decode(block.mBegin, block.mEnd);
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/reader/MarkdownBlocks.h"
+
+#include <QAbstractListModel>
+#include <QCache>
+
+namespace mod::filemanager {
+
+// Blocks of a Markdown document, one delegate each.
+// A block is converted to rich text the first time a delegate shows it, and the last few conversions are kept,
+// so jumping around a long note only lays out what is on screen.
+class MarkdownModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit MarkdownModel(QObject* parent = nullptr);
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent) const override;
+
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role) const override;
+
+    [[nodiscard]] QHash<int, QByteArray> roleNames() const override;
+
+    void setDocument(std::shared_ptr<TextDocument> document);
+
+    void append(std::vector<MarkdownBlock> blocks);
+
+    [[nodiscard]] std::vector<MarkdownBlock> const& getBlocks() const { return mBlocks; }
+
+    // Row containing the byte offset.
+    Q_INVOKABLE int blockAt(qint64 offset) const;
+
+private:
+    enum class UserRoles { Type = Qt::UserRole + 1, Markdown, Html, Offset };
+
+    std::shared_ptr<TextDocument> mDocument;
+    std::vector<MarkdownBlock>    mBlocks;
+
+    mutable QCache<int, QString> mHtml;
+
+    [[nodiscard]] QString _getMarkdown(int row) const;
+};
+
+} // namespace mod::filemanager
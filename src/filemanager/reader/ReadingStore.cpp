@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/ReadingStore.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+namespace mod::filemanager {
+
+constexpr quint32 STORE_MAGIC   = 0x504D5253; // "PMRS"
+constexpr quint32 STORE_VERSION = 2;
+
+ReadingStore::ReadingStore(QString file, size_t capacity) : mFile(std::move(file)), mCapacity(capacity) {}
+
+std::optional<int64> ReadingStore::getPosition(const QString& path, int64 size, int64 modifiedTime) {
+    _load();
+    auto it = mEntries.find(path);
+    if (it == mEntries.end() || it->mSize != size || it->mModifiedTime != modifiedTime) {
+        return std::nullopt;
+    }
+    it->mUsed = ++mClock;
+    return it->mPosition;
+}
+
+void ReadingStore::setPosition(const QString& path, int64 size, int64 modifiedTime, int64 position) {
+    auto& entry = _touch(path, size, modifiedTime);
+    if (entry.mPosition != position) {
+        entry.mPosition = position;
+        mDirty          = true;
+    }
+}
+
+QList<qint64> ReadingStore::getBookmarks(const QString& path, int64 size, int64 modifiedTime) {
+    _load();
+    auto it = mEntries.find(path);
+    if (it == mEntries.end() || it->mSize != size || it->mModifiedTime != modifiedTime) {
+        return {};
+    }
+    it->mUsed = ++mClock;
+    return it->mBookmarks;
+}
+
+void ReadingStore::setBookmarks(const QString& path, int64 size, int64 modifiedTime, QList<qint64> bookmarks) {
+    std::sort(bookmarks.begin(), bookmarks.end());
+    auto& entry = _touch(path, size, modifiedTime);
+    if (entry.mBookmarks != bookmarks) {
+        entry.mBookmarks = std::move(bookmarks);
+        mDirty           = true;
+    }
+}
+
+void ReadingStore::flush() {
+    if (!mDirty) {
+        return;
+    }
+    QSaveFile out(mFile);
+    if (!out.open(QIODevice::WriteOnly)) {
+        spdlog::warn("Unable to write reading positions to {}.", mFile.toStdString());
+        return;
+    }
+    QDataStream stream(&out);
+    stream << STORE_MAGIC << STORE_VERSION << (quint32)mEntries.size();
+    for (auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it) {
+        stream << it.key() << (qint64)it->mSize << (qint64)it->mModifiedTime << (qint64)it->mPosition << it->mBookmarks
+               << (qint64)it->mUsed;
+    }
+    if (stream.status() == QDataStream::Ok && out.commit()) {
+        mDirty = false;
+    }
+}
+
+ReadingStore::Entry& ReadingStore::_touch(const QString& path, int64 size, int64 modifiedTime) {
+    _load();
+    auto it = mEntries.find(path);
+    if (it == mEntries.end()) {
+        if ((size_t)mEntries.size() >= mCapacity) {
+            auto oldest = mEntries.begin();
+            for (auto entry = mEntries.begin(); entry != mEntries.end(); ++entry) {
+                if (entry->mUsed < oldest->mUsed) {
+                    oldest = entry;
+                }
+            }
+            mEntries.erase(oldest);
+        }
+        it = mEntries.insert(path, {});
+    }
+    if (it->mSize != size || it->mModifiedTime != modifiedTime) {
+        *it    = {size, modifiedTime};
+        mDirty = true;
+    }
+    it->mUsed = ++mClock;
+    return *it;
+}
+
+void ReadingStore::_load() {
+    if (mLoaded) {
+        return;
+    }
+    mLoaded = true;
+    QFile in(mFile);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&in);
+    quint32     magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != STORE_MAGIC || version != STORE_VERSION) {
+        return;
+    }
+    for (uint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        QString       path;
+        qint64        size, modifiedTime, position, used;
+        QList<qint64> bookmarks;
+        stream >> path >> size >> modifiedTime >> position >> bookmarks >> used;
+        mEntries.insert(path, {size, modifiedTime, position, std::move(bookmarks), used});
+        mClock = std::max<int64>(mClock, used);
+    }
+}
+
+} // namespace mod::filemanager
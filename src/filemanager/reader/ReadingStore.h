@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <QHash>
+
+namespace mod::filemanager {
+
+// Reading position and bookmarks per document, all as byte offsets.
+// Updates stay in memory until flush(), like PositionStore.
+class ReadingStore {
+public:
+    explicit ReadingStore(QString file, size_t capacity = 200);
+
+    // nullopt if unknown or if the file changed (by size or modified time) since.
+    [[nodiscard]] std::optional<int64> getPosition(const QString& path, int64 size, int64 modifiedTime);
+
+    void setPosition(const QString& path, int64 size, int64 modifiedTime, int64 position);
+
+    // Sorted, empty if the file changed since.
+    [[nodiscard]] QList<qint64> getBookmarks(const QString& path, int64 size, int64 modifiedTime);
+
+    void setBookmarks(const QString& path, int64 size, int64 modifiedTime, QList<qint64> bookmarks);
+
+    // Writes the store if anything changed since the last flush.
+    void flush();
+
+private:
+    struct Entry {
+        int64         mSize{};
+        int64         mModifiedTime{};
+        int64         mPosition{};
+        QList<qint64> mBookmarks;
+        int64         mUsed{}; // mClock at the last access, the least recent is evicted first.
+    };
+
+    QString               mFile;
+    size_t                mCapacity;
+    QHash<QString, Entry> mEntries;
+    int64                 mClock{};
+    bool                  mDirty{};
+    bool                  mLoaded{};
+
+    // The entry of `path`, reset if the file changed.
+    Entry& _touch(const QString& path, int64 size, int64 modifiedTime);
+
+    void _load();
+};
+
+} // namespace mod::filemanager
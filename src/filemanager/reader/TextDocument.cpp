@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/TextDocument.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mod::filemanager {
+
+constexpr int    PAGE_LINES       = 32;
+constexpr size_t PAGE_BYTES       = 4096; // a single long paragraph is cut into several pages.
+constexpr size_t PROGRESS_PAGES   = 2048;
+constexpr size_t MAX_INDEXED_SIZE = UINT32_MAX;
+
+TextDocument::TextDocument(const QString& path, std::optional<util::DetectedEncoding> encoding) {
+    auto fd = ::open(path.toUtf8().constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || (uint64)st.st_size > MAX_INDEXED_SIZE) {
+        ::close(fd);
+        return;
+    }
+    mSize         = (size_t)st.st_size;
+    mModifiedTime = (int64)st.st_mtim.tv_sec * 1000 + st.st_mtim.tv_nsec / 1000000;
+    mOpened       = true;
+    if (mSize > 0) {
+        auto map = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            mSize   = 0;
+            mOpened = false;
+        } else {
+            mData         = (const char*)map;
+            auto detected = encoding ? *encoding : util::detectEncoding(mData, mSize);
+            mEncoding     = detected.mEncoding;
+            mTextBegin    = detected.mBomSize;
+        }
+    }
+    ::close(fd);
+}
+
+TextDocument::~TextDocument() {
+    if (mData) {
+        ::munmap((void*)mData, mSize);
+    }
+}
+
+bool TextDocument::buildIndex(const std::atomic<bool>& cancelled, const std::function<void(size_t)>& onProgress) {
+    if (mData) {
+        ::madvise((void*)mData, mSize, MADV_SEQUENTIAL);
+    }
+    size_t pos   = mTextBegin;
+    size_t pages = 0;
+    while (pos < mSize) {
+        if (cancelled) {
+            return false;
+        }
+        pos = _findPageEnd(pos);
+        {
+            std::lock_guard lock(mMutex);
+            mPageEnds.emplace_back((uint32)pos);
+        }
+        if (++pages % PROGRESS_PAGES == 0) {
+            onProgress(pages);
+        }
+    }
+    if (mData) {
+        // From now on, pages are read where the user scrolls to.
+        ::madvise((void*)mData, mSize, MADV_RANDOM);
+    }
+    mIndexed = true;
+    onProgress(pages);
+    return true;
+}
+
+std::vector<uint32> TextDocument::getPageEnds() const {
+    std::lock_guard lock(mMutex);
+    return mPageEnds;
+}
+
+void TextDocument::restoreIndex(std::vector<uint32> pageEnds) {
+    {
+        std::lock_guard lock(mMutex);
+        mPageEnds = std::move(pageEnds);
+    }
+    if (mData) {
+        ::madvise((void*)mData, mSize, MADV_RANDOM);
+    }
+    mIndexed = true;
+}
+
+size_t TextDocument::getPageCount() const {
+    std::lock_guard lock(mMutex);
+    return mPageEnds.size();
+}
+
+std::pair<size_t, size_t> TextDocument::getPageRange(size_t idx) const {
+    std::lock_guard lock(mMutex);
+    if (idx >= mPageEnds.size()) {
+        return {mSize, mSize};
+    }
+    return {idx ? mPageEnds[idx - 1] : mTextBegin, mPageEnds[idx]};
+}
+
+size_t TextDocument::getPageAt(size_t offset) const {
+    std::lock_guard lock(mMutex);
+    auto            it = std::upper_bound(mPageEnds.begin(), mPageEnds.end(), (uint32)offset);
+    return std::min((size_t)(it - mPageEnds.begin()), mPageEnds.empty() ? 0 : mPageEnds.size() - 1);
+}
+
+QString TextDocument::getPage(size_t idx) const {
+    auto [begin, end] = getPageRange(idx);
+    auto text         = decode(begin, end);
+    if (text.endsWith('\n')) {
+        text.chop(1); // the delegate separates pages by itself.
+    }
+    return text;
+}
+
+QString TextDocument::decode(size_t begin, size_t end) const {
+    if (!mData || begin >= end || end > mSize) {
+        return {};
+    }
+    return util::decodeText(mData + begin, end - begin, mEncoding).remove('\r');
+}
+
+size_t TextDocument::_findPageEnd(size_t begin) const {
+    auto limit = std::min(mSize, begin + PAGE_BYTES);
+    auto pos   = begin;
+    int  lines = 0;
+    while (pos < limit) {
+        auto end = findLineEnd(pos, limit);
+        if (!end) {
+            break;
+        }
+        pos = end;
+        if (++lines == PAGE_LINES) {
+            return pos;
+        }
+    }
+    if (limit == mSize) {
+        return mSize;
+    }
+    if (pos > begin) {
+        return pos; // ends with the last complete line.
+    }
+    // A line longer than a page, cut between two characters.
+    auto end = begin + util::findCharBoundary(mData + begin, mSize - begin, limit - begin, mEncoding);
+    return end > begin ? end : limit;
+}
+
+size_t TextDocument::findLineEnd(size_t pos, size_t limit) const {
+    if (mEncoding != util::TextEncoding::Utf16LE && mEncoding != util::TextEncoding::Utf16BE) {
+        // 0x0A is never part of a multibyte character in UTF-8 or GB18030.
+        auto* newline = (const char*)memchr(mData + pos, '\n', limit - pos);
+        return newline ? newline - mData + 1 : 0;
+    }
+    // In UTF-16 it is, so the hit must be the right half of an aligned unit whose other half is zero.
+    size_t half = mEncoding == util::TextEncoding::Utf16LE ? 0 : 1;
+    for (auto from = pos + half; from < limit;) {
+        auto* newline = (const char*)memchr(mData + from, '\n', limit - from);
+        if (!newline) {
+            break;
+        }
+        auto at   = (size_t)(newline - mData);
+        auto unit = at - half;
+        if (unit % 2 == 0 && unit + 2 <= limit && mData[unit + 1 - half] == 0) {
+            return unit + 2;
+        }
+        from = at + 1;
+    }
+    return 0;
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "common/util/TextEncoding.h"
+
+#include <mutex>
+
+namespace mod::filemanager {
+
+// A text file mapped in memory and split into pages of a few lines.
+// Only page boundaries are kept (4 bytes per page), text is decoded when a page is asked for,
+// so memory stays flat whatever the size of the file.
+// The index is built once on any thread, pages already indexed can be read from others meanwhile.
+class TextDocument {
+public:
+    // `encoding` skips detection, for a file whose index was kept.
+    explicit TextDocument(const QString& path, std::optional<util::DetectedEncoding> encoding = std::nullopt);
+
+    ~TextDocument();
+
+    TextDocument(const TextDocument&) = delete;
+
+    TextDocument& operator=(const TextDocument&) = delete;
+
+    [[nodiscard]] bool isOpen() const { return mOpened; }
+
+    [[nodiscard]] size_t getSize() const { return mSize; }
+
+    // ms since epoch, to tell whether a kept index is still valid.
+    [[nodiscard]] int64 getModifiedTime() const { return mModifiedTime; }
+
+    [[nodiscard]] const char* getData() const { return mData; }
+
+    // Detected from a BOM or the first 64KB, pages are decoded with it.
+    [[nodiscard]] util::TextEncoding getEncoding() const { return mEncoding; }
+
+    // Where the text starts, after the BOM.
+    [[nodiscard]] size_t getTextBegin() const { return mTextBegin; }
+
+    [[nodiscard]] util::DetectedEncoding getDetectedEncoding() const { return {mEncoding, mTextBegin}; }
+
+    // Offset after the next line feed in [pos, limit), 0 if there is none.
+    [[nodiscard]] size_t findLineEnd(size_t pos, size_t limit) const;
+
+    // Splits the whole file, `onProgress` gets the page count every few thousand pages.
+    // Returns false if cancelled.
+    bool buildIndex(const std::atomic<bool>& cancelled, const std::function<void(size_t)>& onProgress);
+
+    [[nodiscard]] bool isIndexed() const { return mIndexed; }
+
+    // A copy of the finished index, to be restored when the same file is opened again.
+    [[nodiscard]] std::vector<uint32> getPageEnds() const;
+
+    // Instead of buildIndex().
+    void restoreIndex(std::vector<uint32> pageEnds);
+
+    [[nodiscard]] size_t getPageCount() const;
+
+    // Byte range [first, second) of a page.
+    [[nodiscard]] std::pair<size_t, size_t> getPageRange(size_t idx) const;
+
+    // The page containing `offset`, in the indexed part.
+    [[nodiscard]] size_t getPageAt(size_t offset) const;
+
+    [[nodiscard]] QString getPage(size_t idx) const;
+
+    [[nodiscard]] QString decode(size_t begin, size_t end) const;
+
+private:
+    const char* mData{};
+    size_t      mSize{};
+    int64       mModifiedTime{};
+    bool        mOpened{};
+
+    util::TextEncoding mEncoding{util::TextEncoding::Utf8};
+    size_t             mTextBegin{};
+
+    mutable std::mutex  mMutex;
+    std::vector<uint32> mPageEnds;
+    std::atomic<bool>   mIndexed{false};
+
+    [[nodiscard]] size_t _findPageEnd(size_t begin) const;
+};
+
+} // namespace mod::filemanager
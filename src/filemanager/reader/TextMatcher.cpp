@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/TextMatcher.h"
+
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mod::filemanager {
+
+TextMatcher::TextMatcher(const QString& pattern, util::TextEncoding encoding) : mEncoding(encoding) {
+    // Encoded character by character, so that only bytes standing for an ASCII letter are folded,
+    // never a GB18030 trail byte or the zero half of a UTF-16 unit.
+    for (int i = 0; i < pattern.size(); i++) {
+        auto length = pattern[i].isHighSurrogate() && i + 1 < pattern.size() ? 2 : 1;
+        auto ch     = pattern.mid(i, length);
+        auto letter = length == 1 && ch[0].unicode() < 0x80 && ch[0].isLetter();
+        for (auto byte : util::encodeText(ch, encoding)) {
+            auto fold  = letter && byte != 0;
+            mPattern  += fold ? (char)(byte | 0x20) : byte;
+            mFoldMask += fold ? (char)0x20 : (char)0;
+            mFolded   |= fold;
+        }
+        i += length - 1;
+    }
+}
+
+bool TextMatcher::findAll(
+    const char* data, size_t begin, size_t end, const std::function<bool(size_t)>& onMatch
+) const {
+    auto*  bytes    = (const uint8*)data;
+    auto   boundary = begin;
+    size_t pos      = begin;
+    while ((pos = _find(bytes, pos, end)) < end) {
+        // UTF-8 is self-synchronizing, the others can match across two characters.
+        if (mEncoding == util::TextEncoding::Gb18030) {
+            boundary += util::findCharBoundary(data + boundary, end - boundary, pos - boundary, mEncoding);
+            if (boundary != pos) {
+                pos++;
+                continue;
+            }
+        } else if (mEncoding != util::TextEncoding::Utf8 && (pos - begin) % 2) {
+            pos++;
+            continue;
+        }
+        if (!onMatch(pos)) {
+            return false;
+        }
+        pos += mPattern.size();
+    }
+    return true;
+}
+
+size_t TextMatcher::_find(const uint8* data, size_t from, size_t end) const {
+    auto  length  = (size_t)mPattern.size();
+    auto* pattern = (const uint8*)mPattern.constData();
+    auto* fold    = (const uint8*)mFoldMask.constData();
+    if (length == 0 || end - from < length) {
+        return end;
+    }
+    if (!mFolded) {
+        auto* hit = (const uint8*)memmem(data + from, end - from, pattern, length);
+        return hit ? hit - data : end;
+    }
+    // Candidates are positions where the first and the last byte match, 16 positions at a time.
+    auto last = end - length;
+    auto i    = from;
+#if defined(__ARM_NEON)
+    auto first     = vdupq_n_u8(pattern[0]);
+    auto firstFold = vdupq_n_u8(fold[0]);
+    auto tail      = vdupq_n_u8(pattern[length - 1]);
+    auto tailFold  = vdupq_n_u8(fold[length - 1]);
+    for (; i + 15 <= last; i += 16) {
+        auto head = vceqq_u8(vorrq_u8(vld1q_u8(data + i), firstFold), first);
+        auto back = vceqq_u8(vorrq_u8(vld1q_u8(data + i + length - 1), tailFold), tail);
+        // 4 bits per lane as NEON has no movemask, one of them is kept.
+        auto both = vreinterpretq_u16_u8(vandq_u8(head, back));
+        auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(both, 4)), 0) & 0x8888888888888888ull;
+        for (; mask; mask &= mask - 1) {
+            auto offset = i + __builtin_ctzll(mask) / 4;
+            if (_matches(data + offset)) {
+                return offset;
+            }
+        }
+    }
+#elif defined(__SSE2__)
+    auto first     = _mm_set1_epi8((char)pattern[0]);
+    auto firstFold = _mm_set1_epi8((char)fold[0]);
+    auto tail      = _mm_set1_epi8((char)pattern[length - 1]);
+    auto tailFold  = _mm_set1_epi8((char)fold[length - 1]);
+    for (; i + 15 <= last; i += 16) {
+        auto head = _mm_cmpeq_epi8(_mm_or_si128(_mm_loadu_si128((const __m128i*)(data + i)), firstFold), first);
+        auto back = _mm_cmpeq_epi8(
+            _mm_or_si128(_mm_loadu_si128((const __m128i*)(data + i + length - 1)), tailFold),
+            tail
+        );
+        for (auto mask = (uint32)_mm_movemask_epi8(_mm_and_si128(head, back)); mask; mask &= mask - 1) {
+            auto offset = i + __builtin_ctz(mask);
+            if (_matches(data + offset)) {
+                return offset;
+            }
+        }
+    }
+#endif
+    for (; i <= last; i++) {
+        if (_matches(data + i)) {
+            return i;
+        }
+    }
+    return end;
+}
+
+bool TextMatcher::_matches(const uint8* data) const {
+    auto* pattern = (const uint8*)mPattern.constData();
+    auto* fold    = (const uint8*)mFoldMask.constData();
+    for (int i = 0; i < mPattern.size(); i++) {
+        if ((data[i] | fold[i]) != pattern[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace mod::filemanager
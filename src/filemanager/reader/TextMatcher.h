@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "common/util/TextEncoding.h"
+
+namespace mod::filemanager {
+
+// Finds a pattern in encoded text without decoding it.
+// The pattern is encoded once, ASCII letters match either case, everything else (CJK) matches exactly.
+class TextMatcher {
+public:
+    TextMatcher(const QString& pattern, util::TextEncoding encoding);
+
+    [[nodiscard]] bool isEmpty() const { return mPattern.isEmpty(); }
+
+    // Encoded length of the pattern.
+    [[nodiscard]] size_t getLength() const { return mPattern.size(); }
+
+    // Calls `onMatch(offset)` for each non-overlapping match in [begin, end) until it returns false.
+    // `begin` must be a character boundary. Returns false if stopped.
+    bool findAll(const char* data, size_t begin, size_t end, const std::function<bool(size_t)>& onMatch) const;
+
+private:
+    QByteArray         mPattern;  // ASCII letters lower-cased.
+    QByteArray         mFoldMask; // 0x20 on ASCII letters.
+    bool               mFolded{};
+    util::TextEncoding mEncoding;
+
+    // First candidate in [from, end) matching byte by byte, `end` if none.
+    [[nodiscard]] size_t _find(const uint8* data, size_t from, size_t end) const;
+
+    [[nodiscard]] bool _matches(const uint8* data) const;
+};
+
+} // namespace mod::filemanager
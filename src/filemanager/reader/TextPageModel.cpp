@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/reader/TextPageModel.h"
+
+namespace mod::filemanager {
+
+constexpr int CACHED_PAGES = 16; // a screen shows two or three pages.
+
+TextPageModel::TextPageModel(QObject* parent) : QAbstractListModel(parent), mCache(CACHED_PAGES) {}
+
+int TextPageModel::rowCount(const QModelIndex& parent) const { return parent.isValid() ? 0 : mCount; }
+
+QVariant TextPageModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || !mDocument || index.row() >= mCount) {
+        return {};
+    }
+    auto row = index.row();
+    switch ((UserRoles)role) {
+    case UserRoles::Text: {
+        if (auto* text = mCache.object(row)) {
+            return *text;
+        }
+        auto text = mDocument->getPage(row);
+        mCache.insert(row, new QString(text));
+        return text;
+    }
+    case UserRoles::Offset:
+        return (qint64)mDocument->getPageRange(row).first;
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> TextPageModel::roleNames() const {
+    return QHash<int, QByteArray>{
+        {(int)UserRoles::Text,   "text"  },
+        {(int)UserRoles::Offset, "offset"}
+    };
+}
+
+void TextPageModel::setDocument(std::shared_ptr<TextDocument> document) {
+    beginResetModel();
+    mDocument = std::move(document);
+    mCount    = 0;
+    mCache.clear();
+    endResetModel();
+}
+
+void TextPageModel::setPageCount(size_t count) {
+    if ((int)count <= mCount) {
+        return;
+    }
+    beginInsertRows({}, mCount, (int)count - 1);
+    mCount = (int)count;
+    endInsertRows();
+}
+
+int TextPageModel::pageAt(qint64 offset) const {
+    if (!mDocument || offset < 0) {
+        return 0;
+    }
+    return std::min((int)mDocument->getPageAt((size_t)offset), std::max(mCount - 1, 0));
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/reader/TextDocument.h"
+
+#include <QAbstractListModel>
+#include <QCache>
+
+namespace mod::filemanager {
+
+// Pages of a TextDocument, for a ListView to virtualize.
+// Only rows the view asks for are decoded, and only the last few of them are kept.
+class TextPageModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit TextPageModel(QObject* parent = nullptr);
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent) const override;
+
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role) const override;
+
+    [[nodiscard]] QHash<int, QByteArray> roleNames() const override;
+
+    void setDocument(std::shared_ptr<TextDocument> document);
+
+    // Appends rows indexed since last time.
+    void setPageCount(size_t count);
+
+    // Row containing the byte offset.
+    Q_INVOKABLE int pageAt(qint64 offset) const;
+
+private:
+    enum class UserRoles { Text = Qt::UserRole + 1, Offset };
+
+    std::shared_ptr<TextDocument> mDocument;
+    int                           mCount{};
+
+    mutable QCache<int, QString> mCache;
+};
+
+} // namespace mod::filemanager
@@ -5,34 +5,332 @@
  */
 
 #include "filemanager/reader/TextReader.h"
+#include "filemanager/reader/TextMatcher.h"
 #include "filemanager/FileManager.h"
 
 #include "common/Event.h"
+#include "common/util/System.h"
 
-#include <QFile>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QQmlContext>
 
 namespace mod::filemanager {
 
-TextReader::TextReader() {
+// Below these, the document is still handed to QML in one piece.
+constexpr size_t MAX_CONTENT_SIZE  = 256 * 1024;
+constexpr size_t MAX_MARKDOWN_SIZE = 16 * 1024; // laying out rich text is far slower than plain text.
+
+constexpr size_t MAX_HITS      = 10000;
+constexpr size_t HITS_BATCH    = 256;
+constexpr int    HITS_INTERVAL = 100; // ms
+
+constexpr int    SAVE_DELAY   = 10 * 1000;
+constexpr size_t SNIPPET_SIZE = 120; // bytes
+
+TextReader::TextReader() : Logger("TextReader"), mReading(util::getCachePath("reading")) {
+    mSaveTimer.setSingleShot(true);
+    mSaveTimer.setInterval(SAVE_DELAY);
+    connect(&mSaveTimer, &QTimer::timeout, [this]() { mReading.flush(); });
     connect(&Event::getInstance(), &Event::beforeUiInitialization, [this](QQuickView& view, QQmlContext* context) {
         context->setContextProperty("textReader", this);
     });
-} // namespace mod::filemanager
+}
 
-void TextReader::open(QString dir) { mOpeningFileName = std::move(dir); }
+TextReader::~TextReader() {
+    _stopSearching();
+    _stopIndexing();
+    mReading.flush();
+}
+
+void TextReader::open(QString dir) {
+    search({});
+    _stopIndexing();
+    mSaveTimer.stop();
+    mReading.flush();
+    mOpeningFileName = std::move(dir);
+    mOpeningPath     = FileManager::getInstance().getCurrentPath().filePath(mOpeningFileName);
 
-bool TextReader::getIsMarkdown() { return mOpeningFileName.endsWith(".md", Qt::CaseInsensitive); }
+    QFileInfo info(mOpeningPath);
+    auto      kept = mIndices.get(mOpeningPath, info.size(), info.lastModified().toMSecsSinceEpoch());
+
+    mDocument = std::make_shared<TextDocument>(mOpeningPath, kept ? std::optional(kept->mEncoding) : std::nullopt);
+    mPages.setDocument(mDocument);
+    mBlocks.setDocument(mDocument);
+    auto size     = (int64)mDocument->getSize();
+    auto modified = mDocument->getModifiedTime();
+    mPosition     = mReading.getPosition(mOpeningPath, size, modified).value_or(0);
+    mBookmarks    = mReading.getBookmarks(mOpeningPath, size, modified);
+    emit positionChanged();
+    emit bookmarksChanged();
+    if (!mDocument->isOpen()) {
+        error("Unable to open {}.", mOpeningPath.toStdString());
+        return;
+    }
+    if (kept && kept->mSize == size && kept->mModifiedTime == modified) {
+        if (getIsMarkdown()) {
+            mBlocks.append(kept->mBlocks);
+        } else {
+            mDocument->restoreIndex(kept->mPageEnds);
+            mPages.setPageCount(kept->mPageEnds.size());
+        }
+        return;
+    }
+
+    mIndexing  = true;
+    mCancelled = false;
+    emit indexingChanged();
+    mIndexer = std::thread([this, document = mDocument, markdown = getIsMarkdown()]() {
+        QElapsedTimer timer;
+        timer.start();
+        if (markdown) {
+            auto publish = [this, document](std::vector<MarkdownBlock> blocks) {
+                QMetaObject::invokeMethod(
+                    this,
+                    [this, document, blocks = std::move(blocks)]() mutable {
+                        if (mDocument == document) {
+                            mBlocks.append(std::move(blocks));
+                        }
+                    },
+                    Qt::QueuedConnection
+                );
+            };
+            if (!splitMarkdown(*document, mCancelled, publish)) {
+                return;
+            }
+            debug("Split into blocks in {}ms.", timer.elapsed());
+            _onIndexed(document);
+            return;
+        }
+        auto publish = [this, document](size_t pages) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, document, pages]() {
+                    if (mDocument == document) {
+                        mPages.setPageCount(pages);
+                    }
+                },
+                Qt::QueuedConnection
+            );
+        };
+        if (!document->buildIndex(mCancelled, publish)) {
+            return;
+        }
+        debug("Indexed {} pages in {}ms.", document->getPageCount(), timer.elapsed());
+        _onIndexed(document);
+    });
+}
+
+bool TextReader::getIsMarkdown() const { return mOpeningFileName.endsWith(".md", Qt::CaseInsensitive); }
 
 QString TextReader::getContent() {
-    QFile file(FileManager::getInstance().getCurrentPath().filePath(mOpeningFileName));
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!mDocument || !mDocument->isOpen()) {
         return "打开文件失败...";
     }
-    std::string ret = file.readAll().toStdString();
-    file.close();
-    return QString::fromStdString(ret);
+    if (isPaged()) {
+        return {};
+    }
+    return mDocument->decode(mDocument->getTextBegin(), mDocument->getSize());
 }
 
 QString TextReader::getTitle() { return mOpeningFileName; }
+
+bool TextReader::isPaged() {
+    return mDocument && mDocument->getSize() > (getIsMarkdown() ? MAX_MARKDOWN_SIZE : MAX_CONTENT_SIZE);
+}
+
+QObject* TextReader::getPages() { return &mPages; }
+
+QObject* TextReader::getBlocks() { return &mBlocks; }
+
+bool TextReader::isIndexing() const { return mIndexing; }
+
+void TextReader::search(const QString& query) {
+    _stopSearching();
+    mSearchId++;
+    if (!mHits.empty()) {
+        mHits.clear();
+        emit hitsChanged();
+    }
+    if (query.isEmpty() || !mDocument || !mDocument->getData()) {
+        return;
+    }
+
+    mSearching       = true;
+    mSearchCancelled = false;
+    emit searchingChanged();
+    mSearcher = std::thread([this, id = mSearchId, document = mDocument, query]() {
+        QElapsedTimer timer;
+        timer.start();
+        TextMatcher         matcher(query, document->getEncoding());
+        std::vector<qint64> batch;
+        size_t              found     = 0;
+        qint64              published = 0;
+
+        auto publish = [this, id, &batch]() {
+            QMetaObject::invokeMethod(
+                this,
+                [this, id, hits = std::move(batch)]() {
+                    if (mSearchId == id) {
+                        mHits.insert(mHits.end(), hits.begin(), hits.end());
+                        emit hitsChanged();
+                    }
+                },
+                Qt::QueuedConnection
+            );
+            batch.clear();
+        };
+        auto begin    = document->getTextBegin();
+        auto finished = matcher.findAll(document->getData(), begin, document->getSize(), [&](size_t offset) {
+            if (mSearchCancelled) {
+                return false;
+            }
+            batch.emplace_back((qint64)offset);
+            // The first hits are shown at once, the rest every now and then.
+            if (found++ == 0 || batch.size() >= HITS_BATCH || timer.elapsed() - published >= HITS_INTERVAL) {
+                publish();
+                published = timer.elapsed();
+            }
+            return found < MAX_HITS;
+        });
+        if (mSearchCancelled) {
+            return;
+        }
+        publish();
+        debug("Found {} hits{} in {}ms.", found, finished ? "" : " (truncated)", timer.elapsed());
+        QMetaObject::invokeMethod(
+            this,
+            [this, id]() {
+                if (mSearchId == id) {
+                    mSearching = false;
+                    emit searchingChanged();
+                }
+            },
+            Qt::QueuedConnection
+        );
+    });
+}
+
+bool TextReader::isSearching() const { return mSearching; }
+
+int TextReader::getHitCount() const { return (int)mHits.size(); }
+
+qint64 TextReader::getHitOffset(int idx) const { return idx >= 0 && idx < (int)mHits.size() ? mHits[idx] : -1; }
+
+int TextReader::getHitPage(int idx) const {
+    auto offset = getHitOffset(idx);
+    if (offset < 0) {
+        return -1;
+    }
+    return getRowAt(offset);
+}
+
+int TextReader::getRowAt(qint64 offset) const {
+    return getIsMarkdown() ? mBlocks.blockAt(offset) : mPages.pageAt(offset);
+}
+
+qint64 TextReader::getPosition() const { return mPosition; }
+
+void TextReader::setPosition(qint64 position) {
+    if (!mDocument || !mDocument->isOpen() || mPosition == position) {
+        return;
+    }
+    mPosition = position;
+    mReading.setPosition(mOpeningPath, (int64)mDocument->getSize(), mDocument->getModifiedTime(), position);
+    mSaveTimer.start();
+    emit positionChanged();
+}
+
+QVariantList TextReader::getBookmarks() const {
+    QVariantList ret;
+    for (auto offset : mBookmarks) {
+        ret.append(offset);
+    }
+    return ret;
+}
+
+void TextReader::addBookmark(qint64 offset) {
+    if (!mDocument || !mDocument->isOpen() || mBookmarks.contains(offset)) {
+        return;
+    }
+    mBookmarks.append(offset);
+    mReading.setBookmarks(mOpeningPath, (int64)mDocument->getSize(), mDocument->getModifiedTime(), mBookmarks);
+    mBookmarks = mReading.getBookmarks(mOpeningPath, (int64)mDocument->getSize(), mDocument->getModifiedTime());
+    mReading.flush();
+    emit bookmarksChanged();
+}
+
+void TextReader::removeBookmark(qint64 offset) {
+    if (!mDocument || !mBookmarks.removeOne(offset)) {
+        return;
+    }
+    mReading.setBookmarks(mOpeningPath, (int64)mDocument->getSize(), mDocument->getModifiedTime(), mBookmarks);
+    mReading.flush();
+    emit bookmarksChanged();
+}
+
+QString TextReader::getSnippet(qint64 offset) const {
+    if (!mDocument || offset < (qint64)mDocument->getTextBegin() || offset >= (qint64)mDocument->getSize()) {
+        return {};
+    }
+    auto size  = mDocument->getSize();
+    auto begin = (size_t)offset;
+    auto limit = std::min(size, begin + SNIPPET_SIZE);
+    auto end   = mDocument->findLineEnd(begin, limit);
+    if (!end) {
+        auto* data = mDocument->getData() + begin;
+        end        = begin + util::findCharBoundary(data, size - begin, limit - begin, mDocument->getEncoding());
+    }
+    return mDocument->decode(begin, end).trimmed();
+}
+
+void TextReader::_stopSearching() {
+    if (mSearcher.joinable()) {
+        mSearchCancelled = true;
+        mSearcher.join();
+    }
+    if (mSearching) {
+        mSearching = false;
+        emit searchingChanged();
+    }
+}
+
+void TextReader::_onIndexed(const std::shared_ptr<TextDocument>& document) {
+    QMetaObject::invokeMethod(
+        this,
+        [this, document]() {
+            if (mDocument == document) {
+                mIndexing = false;
+                _keepIndex();
+                emit indexingChanged();
+            }
+        },
+        Qt::QueuedConnection
+    );
+}
+
+void TextReader::_keepIndex() {
+    auto index           = std::make_shared<DocumentIndex>();
+    index->mSize         = (int64)mDocument->getSize();
+    index->mModifiedTime = mDocument->getModifiedTime();
+    index->mEncoding     = mDocument->getDetectedEncoding();
+    if (getIsMarkdown()) {
+        index->mBlocks = mBlocks.getBlocks();
+    } else {
+        index->mPageEnds = mDocument->getPageEnds();
+    }
+    mIndices.put(mOpeningPath, std::move(index));
+}
+
+void TextReader::_stopIndexing() {
+    if (mIndexer.joinable()) {
+        mCancelled = true;
+        mIndexer.join();
+    }
+    if (mIndexing) {
+        mIndexing = false;
+        emit indexingChanged();
+    }
+}
+
 } // namespace mod::filemanager
@@ -6,29 +6,137 @@
 
 #pragma once
 
+#include "filemanager/reader/IndexCache.h"
+#include "filemanager/reader/MarkdownModel.h"
+#include "filemanager/reader/ReadingStore.h"
+#include "filemanager/reader/TextPageModel.h"
+
+#include "common/service/Logger.h"
+
+#include <QTimer>
+
+#include <thread>
+
 namespace mod::filemanager {
 
-class TextReader : public QObject, public Singleton<TextReader> {
+class TextReader : public QObject, public Singleton<TextReader>, private Logger {
     Q_OBJECT
 
     Q_PROPERTY(bool isMarkdown READ getIsMarkdown);
     Q_PROPERTY(QString content READ getContent);
     Q_PROPERTY(QString title READ getTitle)
 
+    // Large documents are only available through `pages` (plain text) or `blocks` (Markdown),
+    // `content` is empty then.
+    Q_PROPERTY(bool paged READ isPaged);
+    Q_PROPERTY(QObject* pages READ getPages CONSTANT);
+    Q_PROPERTY(QObject* blocks READ getBlocks CONSTANT);
+    Q_PROPERTY(bool indexing READ isIndexing NOTIFY indexingChanged);
+
+    Q_PROPERTY(bool searching READ isSearching NOTIFY searchingChanged);
+    Q_PROPERTY(int hitCount READ getHitCount NOTIFY hitsChanged);
+
+    // Byte offsets, see getRowAt().
+    Q_PROPERTY(qint64 position READ getPosition WRITE setPosition NOTIFY positionChanged);
+    Q_PROPERTY(QVariantList bookmarks READ getBookmarks NOTIFY bookmarksChanged);
+
 public:
+    ~TextReader() override;
+
     Q_INVOKABLE void open(QString dir);
 
-    bool getIsMarkdown();
+    bool getIsMarkdown() const;
 
     QString getContent();
 
     QString getTitle();
 
+    bool isPaged();
+
+    QObject* getPages();
+
+    QObject* getBlocks();
+
+    bool isIndexing() const;
+
+    // Hits are appended while the document is scanned, an empty query clears them.
+    Q_INVOKABLE void search(const QString& query);
+
+    bool isSearching() const;
+
+    int getHitCount() const;
+
+    Q_INVOKABLE qint64 getHitOffset(int idx) const;
+
+    // Row of `pages` or `blocks` to jump to.
+    Q_INVOKABLE int getHitPage(int idx) const;
+
+    // Row of `pages` or `blocks` containing a byte offset.
+    // Immediate for a recently opened document, otherwise only rows indexed so far are found.
+    Q_INVOKABLE int getRowAt(qint64 offset) const;
+
+    // Where reading was left last time the document was opened.
+    qint64 getPosition() const;
+
+    // The `offset` of the top row on screen, written to disk a while after scrolling stops.
+    void setPosition(qint64 position);
+
+    QVariantList getBookmarks() const;
+
+    Q_INVOKABLE void addBookmark(qint64 offset);
+
+    Q_INVOKABLE void removeBookmark(qint64 offset);
+
+    // The beginning of the line at `offset`, to label a bookmark.
+    Q_INVOKABLE QString getSnippet(qint64 offset) const;
+
+signals:
+
+    void indexingChanged();
+
+    void searchingChanged();
+
+    void hitsChanged();
+
+    void positionChanged();
+
+    void bookmarksChanged();
+
 private:
     friend Singleton<TextReader>;
     explicit TextReader();
 
     QString mOpeningFileName;
-    QString mContent;
-}; // namespace mod::filemanager
+    QString mOpeningPath;
+
+    std::shared_ptr<TextDocument> mDocument;
+    TextPageModel                 mPages;
+    MarkdownModel                 mBlocks;
+
+    std::thread       mIndexer;
+    std::atomic<bool> mCancelled{false};
+    bool              mIndexing{};
+
+    std::thread         mSearcher;
+    std::atomic<bool>   mSearchCancelled{false};
+    bool                mSearching{};
+    uint32              mSearchId{}; // results of an older search are dropped.
+    std::vector<qint64> mHits;
+
+    ReadingStore  mReading;
+    QTimer        mSaveTimer;
+    qint64        mPosition{};
+    QList<qint64> mBookmarks;
+    IndexCache    mIndices;
+
+    // Called from the indexing thread.
+    void _onIndexed(const std::shared_ptr<TextDocument>& document);
+
+    void _keepIndex();
+
+    void _stopIndexing();
+
+    void _stopSearching();
+};
+
 } // namespace mod::filemanager
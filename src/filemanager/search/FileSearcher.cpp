@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/search/FileSearcher.h"
+#include "filemanager/FileEntity.h"
+#include "filemanager/FileManager.h"
+
+#include "common/Event.h"
+#include "common/util/System.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QQmlContext>
+#include <QSet>
+
+namespace mod::filemanager {
+
+constexpr size_t MAX_RESULTS = 200;
+constexpr int    SAVE_DELAY  = 30 * 1000;
+constexpr int    BUILD_DELAY = 10 * 1000;
+constexpr auto   INDEX_FILE  = "search.idx";
+
+FileSearcher::FileSearcher() : QAbstractListModel(), Logger("FileSearcher") {
+    mSaveTimer.setSingleShot(true);
+    mSaveTimer.setInterval(SAVE_DELAY);
+    connect(&mSaveTimer, &QTimer::timeout, [this]() { _save(); });
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged, this, &FileSearcher::onDirectoryChanged);
+    connect(&Event::getInstance(), &Event::uiCompleted, [this]() {
+        // Don't compete with the boot animation.
+        QTimer::singleShot(BUILD_DELAY, this, [this]() { _startBuild(true); });
+    });
+    connect(&Event::getInstance(), &Event::beforeUiInitialization, [this](QQuickView& view, QQmlContext* context) {
+        context->setContextProperty("fileSearcher", this);
+    });
+}
+
+FileSearcher::~FileSearcher() {
+    if (mBuilder.joinable()) {
+        mBuilder.join();
+    }
+    if (mSaver.joinable()) {
+        mSaver.join();
+    }
+}
+
+int FileSearcher::rowCount(const QModelIndex& parent) const { return (int)mResults.size(); }
+
+QVariant FileSearcher::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || !mIndex || index.row() >= (int)mResults.size()) {
+        return {};
+    }
+    auto  id    = mResults[index.row()];
+    auto& entry = mIndex->getEntry(id);
+    switch ((UserRoles)role) {
+    case UserRoles::FileName:
+        return entry.mName;
+    case UserRoles::IsDirectory:
+        return entry.mIsDir;
+    case UserRoles::DirPath: {
+        auto path = mIndex->getDirPath(id).mid(FileManager::getInstance().getRoot().size());
+        return path.isEmpty() ? QString("/") : path;
+    }
+    case UserRoles::ExtensionIcon: {
+        auto ext = entry.mName.contains('.') ? entry.mName.section('.', -1).toLower() : QString();
+        return getExtIcon(ext, entry.mIsDir);
+    }
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> FileSearcher::roleNames() const {
+    return QHash<int, QByteArray>{
+        {(int)UserRoles::FileName,      "fileName"},
+        {(int)UserRoles::IsDirectory,   "isDir"   },
+        {(int)UserRoles::DirPath,       "dirPath" },
+        {(int)UserRoles::ExtensionIcon, "extIcon" }
+    };
+}
+
+QString FileSearcher::getQuery() const { return mQuery; }
+
+void FileSearcher::setQuery(const QString& query) {
+    if (mQuery != query) {
+        mQuery = query;
+        _search();
+        emit queryChanged();
+    }
+}
+
+bool FileSearcher::isReady() const { return mReady; }
+
+int FileSearcher::getIndexedCount() const { return mReady ? (int)mIndex->size() : 0; }
+
+bool FileSearcher::locate(int row) {
+    if (row < 0 || row >= (int)mResults.size()) {
+        return false;
+    }
+    return FileManager::getInstance().changeDir(mIndex->getDirPath(mResults[row]));
+}
+
+void FileSearcher::rebuild() {
+    if (mSaver.joinable()) {
+        mSaver.join();
+    }
+    QFile::remove(util::getCachePath(INDEX_FILE));
+    _startBuild(false);
+}
+
+void FileSearcher::onDirectoryChanged(const QString& path) {
+    if (!mReady) {
+        return;
+    }
+    if (!mIndex->update(path)) {
+        return;
+    }
+    _syncWatcher();
+    _search();
+    mSaveTimer.start();
+    emit readyChanged();
+}
+
+void FileSearcher::_startBuild(bool useCache) {
+    if (mBuilder.joinable()) {
+        if (!mReady) {
+            return; // Still building.
+        }
+        mBuilder.join();
+    }
+    beginResetModel();
+    mResults.clear();
+    mIndex.reset();
+    mReady = false;
+    endResetModel();
+    emit readyChanged();
+
+    auto root = FileManager::getInstance().getRoot();
+    mBuilder  = std::thread([this, root, useCache]() {
+        QElapsedTimer timer;
+        timer.start();
+        auto* index = new SearchIndex(root);
+        if (useCache && index->load(util::getCachePath(INDEX_FILE))) {
+            index->refresh();
+            info("Search index loaded, {} entries, took {}ms.", index->size(), timer.elapsed());
+        } else {
+            index->build();
+            info("Search index built, {} entries, took {}ms.", index->size(), timer.elapsed());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, index]() { _onBuilt(std::unique_ptr<SearchIndex>(index)); },
+            Qt::QueuedConnection
+        );
+    });
+}
+
+void FileSearcher::_onBuilt(std::unique_ptr<SearchIndex> index) {
+    mIndex = std::move(index);
+    mReady = true;
+    _syncWatcher();
+    _search();
+    mSaveTimer.start();
+    emit readyChanged();
+}
+
+void FileSearcher::_save() {
+    if (!mIndex) {
+        return;
+    }
+    if (mSaver.joinable()) {
+        mSaver.join();
+    }
+    // The copy is cheap, names are implicitly shared and so is the posting table until the index changes.
+    mSaver = std::thread([this, snapshot = std::make_shared<const SearchIndex>(*mIndex)]() {
+        QElapsedTimer timer;
+        timer.start();
+        if (snapshot->save(util::getCachePath(INDEX_FILE))) {
+            debug("Search index saved in {}ms.", timer.elapsed());
+        } else {
+            warn("Failed to save the search index.");
+        }
+    });
+}
+
+void FileSearcher::_syncWatcher() {
+    auto dirs    = mIndex->getDirPaths();
+    auto watched = mWatcher.directories();
+    auto added   = QSet<QString>(dirs.begin(), dirs.end());
+    auto removed = QSet<QString>(watched.begin(), watched.end());
+    removed.subtract(added);
+    added.subtract(QSet<QString>(watched.begin(), watched.end()));
+    if (!removed.isEmpty()) {
+        mWatcher.removePaths(removed.values());
+    }
+    // Fails past the inotify limit, those directories are caught up by refresh() on next boot.
+    if (!added.isEmpty()) {
+        if (auto failed = mWatcher.addPaths(added.values()); !failed.isEmpty()) {
+            warn("Unable to watch {} directories.", failed.size());
+        }
+    }
+}
+
+void FileSearcher::_search() {
+    beginResetModel();
+    mResults.clear();
+    // Hidden files must not be found either.
+    if (mReady && !FileManager::getInstance().shouldHiddenAll()) {
+        QElapsedTimer timer;
+        timer.start();
+        mResults = mIndex->query(mQuery, MAX_RESULTS);
+        debug(
+            "Query '{}' -> {} results, took {}us.",
+            mQuery.toStdString(),
+            mResults.size(),
+            timer.nsecsElapsed() / 1000
+        );
+    }
+    endResetModel();
+}
+
+} // namespace mod::filemanager
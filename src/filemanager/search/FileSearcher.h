@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "filemanager/search/SearchIndex.h"
+
+#include "common/service/Logger.h"
+
+#include <QAbstractListModel>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include <thread>
+
+namespace mod::filemanager {
+
+// Searches file names across the whole file manager root.
+class FileSearcher : public QAbstractListModel, public Singleton<FileSearcher>, private Logger {
+    Q_OBJECT
+
+    Q_PROPERTY(QString query READ getQuery WRITE setQuery NOTIFY queryChanged);
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged);
+    Q_PROPERTY(int indexedCount READ getIndexedCount NOTIFY readyChanged);
+
+public:
+    ~FileSearcher() override;
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent) const override;
+
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role) const override;
+
+    [[nodiscard]] QHash<int, QByteArray> roleNames() const override;
+
+    [[nodiscard]] QString getQuery() const;
+
+    void setQuery(const QString&);
+
+    [[nodiscard]] bool isReady() const;
+
+    [[nodiscard]] int getIndexedCount() const;
+
+    // Change the file manager to the directory containing the result.
+    Q_INVOKABLE bool locate(int row);
+
+    // Drop the persisted index and walk the whole tree again.
+    Q_INVOKABLE void rebuild();
+
+    void onDirectoryChanged(const QString& path);
+
+signals:
+
+    void queryChanged();
+
+    void readyChanged();
+
+private:
+    friend Singleton<FileSearcher>;
+    explicit FileSearcher();
+
+    enum class UserRoles { FileName = Qt::UserRole + 1, IsDirectory, DirPath, ExtensionIcon };
+
+    // Owned by mBuilder until the build is done, then by the GUI thread.
+    std::unique_ptr<SearchIndex> mIndex;
+    std::thread                  mBuilder;
+    bool                         mReady{};
+
+    QFileSystemWatcher mWatcher;
+    QTimer             mSaveTimer;
+    std::thread        mSaver; // writes a copy of mIndex.
+
+    QString                           mQuery;
+    std::vector<SearchIndex::EntryId> mResults;
+
+    void _startBuild(bool useCache);
+
+    void _onBuilt(std::unique_ptr<SearchIndex> index);
+
+    void _save();
+
+    void _syncWatcher();
+
+    void _search();
+};
+
+} // namespace mod::filemanager
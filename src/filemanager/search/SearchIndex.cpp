@@ -0,0 +1,427 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "filemanager/search/SearchIndex.h"
+
+#include "common/util/Pinyin.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mod::filemanager {
+
+constexpr uint32 INDEX_MAGIC   = 0x49534D50; // "PMSI"
+constexpr uint32 INDEX_VERSION = 1;
+
+static uint64 makeTrigram(const QChar* str) {
+    return (uint64)str[0].unicode() << 32 | (uint64)str[1].unicode() << 16 | str[2].unicode();
+}
+
+SearchIndex::SearchIndex(QString root) : mRoot(std::move(root)) {}
+
+void SearchIndex::build() {
+    mDirs.clear();
+    mDirIndex.clear();
+    mEntries.clear();
+    mPostings.clear();
+    mRemovedCount = 0;
+    _scanDir(_addDir(""));
+}
+
+void SearchIndex::refresh() {
+    // Directories found while refreshing are scanned right away, no need to visit them twice.
+    auto count = mDirs.size();
+    for (size_t i = 0; i < count; i++) {
+        if (mDirs[i].mRemoved) {
+            continue;
+        }
+        struct stat st {};
+        if (stat(_absolutePath(mDirs[i].mPath).toUtf8().constData(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            _removeDir(i);
+            continue;
+        }
+        if (st.st_mtime != mDirs[i].mMtime) {
+            _scanDir(i);
+        }
+    }
+    _compactIfNeeded();
+}
+
+bool SearchIndex::update(const QString& path) {
+    auto relative = path.mid(mRoot.size());
+    while (relative.startsWith('/')) {
+        relative.remove(0, 1);
+    }
+    while (relative.endsWith('/')) {
+        relative.chop(1);
+    }
+    auto it = mDirIndex.constFind(relative);
+    if (it == mDirIndex.constEnd()) {
+        return false;
+    }
+    _scanDir(*it);
+    _compactIfNeeded();
+    return true;
+}
+
+std::vector<SearchIndex::EntryId> SearchIndex::query(const QString& text, size_t limit) const {
+    std::vector<EntryId> ret;
+    auto                 key = text.trimmed().toLower();
+    if (key.isEmpty() || !limit) {
+        return ret;
+    }
+    if (key.size() < 3) {
+        // Too short for a trigram, the list is small enough to be scanned.
+        for (EntryId id = 0; id < mEntries.size() && ret.size() < limit; id++) {
+            if (!mEntries[id].mRemoved && _match(mEntries[id], key)) {
+                ret.emplace_back(id);
+            }
+        }
+        return ret;
+    }
+    std::vector<std::vector<EntryId> const*> lists;
+    for (int i = 0; i + 3 <= key.size(); i++) {
+        auto it = mPostings.constFind(makeTrigram(key.constData() + i));
+        if (it == mPostings.constEnd()) {
+            return ret;
+        }
+        lists.emplace_back(&*it);
+    }
+    std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+    auto                 candidates = *lists.front();
+    std::vector<EntryId> tmp;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); i++) {
+        tmp.clear();
+        std::set_intersection(
+            candidates.begin(),
+            candidates.end(),
+            lists[i]->begin(),
+            lists[i]->end(),
+            std::back_inserter(tmp)
+        );
+        candidates.swap(tmp);
+    }
+    // Trigrams only narrow down the candidates, "abcd" contains "abc" and "bcd" but "abcbcd" does too.
+    for (auto id : candidates) {
+        if (!mEntries[id].mRemoved && _match(mEntries[id], key)) {
+            ret.emplace_back(id);
+            if (ret.size() >= limit) break;
+        }
+    }
+    return ret;
+}
+
+SearchIndex::Entry const& SearchIndex::getEntry(EntryId id) const { return mEntries.at(id); }
+
+QString SearchIndex::getDirPath(EntryId id) const { return _absolutePath(mDirs.at(mEntries.at(id).mDir).mPath); }
+
+QStringList SearchIndex::getDirPaths() const {
+    QStringList ret;
+    for (auto& dir : mDirs) {
+        if (!dir.mRemoved) {
+            ret.append(_absolutePath(dir.mPath));
+        }
+    }
+    return ret;
+}
+
+size_t SearchIndex::size() const { return mEntries.size() - mRemovedCount; }
+
+bool SearchIndex::save(const QString& file) const {
+    // Removed entries are left out and the others renumbered on the way, the index itself is untouched
+    // so that ids held by the caller stay valid.
+    std::vector<EntryId> remap(mEntries.size(), UINT32_MAX);
+    EntryId              count = 0;
+    for (EntryId id = 0; id < mEntries.size(); id++) {
+        if (!mEntries[id].mRemoved) {
+            remap[id] = count++;
+        }
+    }
+    QSaveFile out(file);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&out);
+    stream << INDEX_MAGIC << INDEX_VERSION << mRoot;
+    stream << (quint32)mDirs.size();
+    for (auto& dir : mDirs) {
+        stream << dir.mPath << (qint64)dir.mMtime << dir.mRemoved;
+    }
+    stream << (quint32)count;
+    for (auto& entry : mEntries) {
+        if (!entry.mRemoved) {
+            stream << entry.mDir << entry.mName << entry.mKey << entry.mInitials << entry.mIsDir;
+        }
+    }
+    quint32 lists = 0;
+    for (auto& list : mPostings) {
+        if (std::any_of(list.begin(), list.end(), [&](EntryId id) { return remap[id] != UINT32_MAX; })) {
+            lists++;
+        }
+    }
+    stream << lists;
+    std::vector<EntryId> list;
+    for (auto it = mPostings.constBegin(); it != mPostings.constEnd(); ++it) {
+        list.clear();
+        for (auto id : *it) {
+            if (remap[id] != UINT32_MAX) {
+                list.emplace_back(remap[id]); // remapping keeps the order, the list stays sorted.
+            }
+        }
+        if (list.empty()) {
+            continue;
+        }
+        stream << (quint64)it.key() << (quint32)list.size();
+        stream.writeRawData(reinterpret_cast<const char*>(list.data()), (int)(list.size() * sizeof(EntryId)));
+    }
+    return stream.status() == QDataStream::Ok && out.commit();
+}
+
+bool SearchIndex::load(const QString& file) {
+    QFile in(file);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&in);
+    quint32     magic, version;
+    QString     root;
+    stream >> magic >> version >> root;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION || root != mRoot) {
+        return false;
+    }
+    quint32 count;
+    stream >> count;
+    mDirs.assign(count, {});
+    mDirIndex.clear();
+    for (uint32 i = 0; i < count; i++) {
+        qint64 mtime;
+        stream >> mDirs[i].mPath >> mtime >> mDirs[i].mRemoved;
+        mDirs[i].mMtime = mtime;
+        if (!mDirs[i].mRemoved) {
+            mDirIndex.insert(mDirs[i].mPath, i);
+        }
+    }
+    stream >> count;
+    mEntries.assign(count, {});
+    for (EntryId id = 0; id < count; id++) {
+        auto& entry = mEntries[id];
+        stream >> entry.mDir >> entry.mName >> entry.mKey >> entry.mInitials >> entry.mIsDir;
+        entry.mRemoved = false;
+        if (entry.mDir >= mDirs.size()) {
+            return false;
+        }
+        mDirs[entry.mDir].mEntries.emplace_back(id);
+    }
+    stream >> count;
+    mPostings.clear();
+    mPostings.reserve((int)count);
+    for (uint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+        quint64 trigram;
+        quint32 size;
+        stream >> trigram >> size;
+        std::vector<EntryId> list(size);
+        stream.readRawData(reinterpret_cast<char*>(list.data()), (int)(size * sizeof(EntryId)));
+        mPostings.insert(trigram, std::move(list));
+    }
+    mRemovedCount = 0;
+    return stream.status() == QDataStream::Ok;
+}
+
+uint32 SearchIndex::_addDir(const QString& path) {
+    if (auto it = mDirIndex.constFind(path); it != mDirIndex.constEnd()) {
+        return *it;
+    }
+    uint32 idx = mDirs.size();
+    mDirs.push_back({path, 0, false, {}});
+    mDirIndex.insert(path, idx);
+    return idx;
+}
+
+void SearchIndex::_scanDir(uint32 dirIdx) {
+    auto path = _absolutePath(mDirs[dirIdx].mPath);
+    auto fd   = open(path.toUtf8().constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        _removeDir(dirIdx);
+        return;
+    }
+    struct stat st {};
+    fstat(fd, &st);
+    mDirs[dirIdx].mMtime = st.st_mtime;
+    auto* dir            = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return;
+    }
+
+    QHash<QString, EntryId> existing;
+    for (auto id : mDirs[dirIdx].mEntries) {
+        if (!mEntries[id].mRemoved) {
+            existing.insert(mEntries[id].mName, id);
+        }
+    }
+
+    QStringList newSubDirs;
+    while (auto* entry = readdir(dir)) {
+        // Same as the file list: no hidden files, no symlinks.
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        bool isDir;
+        switch (entry->d_type) {
+        case DT_DIR:
+            isDir = true;
+            break;
+        case DT_REG:
+            isDir = false;
+            break;
+        case DT_UNKNOWN: {
+            struct stat child {};
+            if (fstatat(fd, entry->d_name, &child, AT_SYMLINK_NOFOLLOW) != 0
+                || !(S_ISDIR(child.st_mode) || S_ISREG(child.st_mode))) {
+                continue;
+            }
+            isDir = S_ISDIR(child.st_mode);
+            break;
+        }
+        default:
+            continue;
+        }
+        auto name = QFile::decodeName(entry->d_name);
+        if (auto it = existing.find(name); it != existing.end() && mEntries[*it].mIsDir == isDir) {
+            existing.erase(it);
+            continue;
+        }
+        _addEntry(dirIdx, name, isDir);
+        if (isDir) {
+            newSubDirs.append(name);
+        }
+    }
+    closedir(dir);
+
+    // Whatever is left has been deleted.
+    auto prefix = mDirs[dirIdx].mPath.isEmpty() ? QString() : mDirs[dirIdx].mPath + "/";
+    for (auto id : existing) {
+        if (mEntries[id].mIsDir) {
+            if (auto it = mDirIndex.constFind(prefix + mEntries[id].mName); it != mDirIndex.constEnd()) {
+                _removeDir(*it);
+            }
+        }
+        _removeEntry(id);
+    }
+    auto& children = mDirs[dirIdx].mEntries;
+    children.erase(
+        std::remove_if(children.begin(), children.end(), [this](EntryId id) { return mEntries[id].mRemoved; }),
+        children.end()
+    );
+
+    for (auto& name : newSubDirs) {
+        _scanDir(_addDir(prefix + name));
+    }
+}
+
+void SearchIndex::_removeDir(uint32 dirIdx) {
+    auto base   = mDirs[dirIdx].mPath;
+    auto prefix = base + "/";
+    for (uint32 i = 0; i < mDirs.size(); i++) {
+        auto& dir = mDirs[i];
+        if (dir.mRemoved || !(i == dirIdx || base.isEmpty() || dir.mPath.startsWith(prefix))) {
+            continue;
+        }
+        dir.mRemoved = true;
+        for (auto id : dir.mEntries) {
+            if (!mEntries[id].mRemoved) {
+                _removeEntry(id);
+            }
+        }
+        dir.mEntries.clear();
+        mDirIndex.remove(dir.mPath);
+    }
+}
+
+void SearchIndex::_addEntry(uint32 dir, const QString& name, bool isDir) {
+    EntryId id  = mEntries.size();
+    auto    key = name.toLower();
+    mEntries.push_back({dir, name, key, util::toPinyinInitials(key), isDir, false});
+    mDirs[dir].mEntries.emplace_back(id);
+    _indexEntry(id);
+}
+
+void SearchIndex::_removeEntry(EntryId id) {
+    auto& entry    = mEntries[id];
+    entry.mRemoved = true;
+    entry.mName.clear();
+    entry.mKey.clear();
+    entry.mInitials.clear();
+    // Posting lists keep the id until compaction, query() skips removed entries.
+    mRemovedCount++;
+}
+
+void SearchIndex::_indexEntry(EntryId id) {
+    auto add = [&](const QString& str) {
+        for (int i = 0; i + 3 <= str.size(); i++) {
+            auto& list = mPostings[makeTrigram(str.constData() + i)];
+            if (list.empty() || list.back() != id) {
+                list.emplace_back(id);
+            }
+        }
+    };
+    auto& entry = mEntries[id];
+    add(entry.mKey);
+    if (entry.mInitials != entry.mKey) {
+        add(entry.mInitials);
+    }
+}
+
+void SearchIndex::_compactIfNeeded() {
+    if (mRemovedCount > 1024 && mRemovedCount * 2 > mEntries.size()) {
+        _compact();
+    }
+}
+
+void SearchIndex::_compact() {
+    std::vector<EntryId> remap(mEntries.size(), UINT32_MAX);
+    std::vector<Entry>   entries;
+    entries.reserve(mEntries.size() - mRemovedCount);
+    for (EntryId id = 0; id < mEntries.size(); id++) {
+        if (!mEntries[id].mRemoved) {
+            remap[id] = entries.size();
+            entries.emplace_back(std::move(mEntries[id]));
+        }
+    }
+    mEntries.swap(entries);
+    mRemovedCount = 0;
+    for (auto& dir : mDirs) {
+        for (auto& id : dir.mEntries) {
+            id = remap[id];
+        }
+        dir.mEntries.erase(std::remove(dir.mEntries.begin(), dir.mEntries.end(), UINT32_MAX), dir.mEntries.end());
+    }
+    // Remapping keeps the order, so the lists stay sorted.
+    for (auto it = mPostings.begin(); it != mPostings.end();) {
+        auto& list = *it;
+        for (auto& id : list) {
+            id = remap[id];
+        }
+        list.erase(std::remove(list.begin(), list.end(), UINT32_MAX), list.end());
+        it = list.empty() ? mPostings.erase(it) : std::next(it);
+    }
+}
+
+QString SearchIndex::_absolutePath(const QString& relative) const {
+    return relative.isEmpty() ? mRoot : mRoot + "/" + relative;
+}
+
+bool SearchIndex::_match(const Entry& entry, const QString& text) {
+    return entry.mKey.contains(text) || entry.mInitials.contains(text);
+}
+
+} // namespace mod::filemanager
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <QHash>
+
+namespace mod::filemanager {
+
+// Trigram index of every file name under a root directory.
+// Names are matched by substring, either directly or by their pinyin initials.
+// Not thread-safe, the owner decides which thread uses it.
+class SearchIndex {
+public:
+    using EntryId = uint32;
+
+    struct Entry {
+        uint32  mDir;
+        QString mName;
+        QString mKey;      // lower case.
+        QString mInitials; // pinyin initials of mKey.
+        bool    mIsDir;
+        bool    mRemoved;
+    };
+
+    explicit SearchIndex(QString root);
+
+    // Walk the whole tree.
+    void build();
+
+    // Rescan directories whose mtime changed since they were indexed, used after load().
+    void refresh();
+
+    // Rescan a single directory (absolute path), new subdirectories are indexed recursively.
+    // Returns false if the directory isn't part of the index.
+    bool update(const QString& path);
+
+    [[nodiscard]] std::vector<EntryId> query(const QString& text, size_t limit) const;
+
+    [[nodiscard]] Entry const& getEntry(EntryId id) const;
+
+    // Absolute path of the directory containing the entry.
+    [[nodiscard]] QString getDirPath(EntryId id) const;
+
+    // Absolute paths of every indexed directory.
+    [[nodiscard]] QStringList getDirPaths() const;
+
+    [[nodiscard]] size_t size() const;
+
+    // Written compacted, without touching the index.
+    // Const, so a copy can be written on another thread while the original is in use.
+    bool save(const QString& file) const;
+
+    bool load(const QString& file);
+
+private:
+    struct Dir {
+        QString              mPath; // relative to root, root itself is "".
+        int64                mMtime;
+        bool                 mRemoved;
+        std::vector<EntryId> mEntries;
+    };
+
+    using Trigram = uint64;
+
+    QString mRoot;
+
+    std::vector<Dir>                     mDirs;
+    QHash<QString, uint32>               mDirIndex;
+    std::vector<Entry>                   mEntries;
+    QHash<Trigram, std::vector<EntryId>> mPostings;
+    size_t                               mRemovedCount{};
+
+    uint32 _addDir(const QString& path);
+
+    void _scanDir(uint32 dir);
+
+    void _removeDir(uint32 dir);
+
+    void _addEntry(uint32 dir, const QString& name, bool isDir);
+
+    void _removeEntry(EntryId id);
+
+    void _indexEntry(EntryId id);
+
+    void _compactIfNeeded();
+
+    void _compact();
+
+    [[nodiscard]] QString _absolutePath(const QString& relative) const;
+
+    static bool _match(const Entry& entry, const QString& text);
+};
+
+} // namespace mod::filemanager
@@ -34,10 +34,11 @@ AntiEmbs::AntiEmbs() {
     mLowVoiceMode   = mCfg["low_voice"];
     mFastMute       = mCfg["fast_mute"];
 
-    connect(this, &AntiEmbs::lowVoiceModeChanged, [&]() {
+    auto applyVoiceDb = [this]() {
         mLowVoiceMode ? ASound::getInstance().setDb({-80.0, -20.0}) : ASound::getInstance().setDb({-50.0, 0.0});
-        exec("killall SoundPlayer");
-    });
+    };
+    applyVoiceDb(); // kept until the UI is up.
+    connect(this, &AntiEmbs::lowVoiceModeChanged, applyVoiceDb);
 
     connect(this, &AntiEmbs::autoPronLockChanged, [&]() {
         if (mAutoPronLocked) {
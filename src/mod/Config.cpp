@@ -86,7 +86,8 @@ Config::Config() : Logger("Config") {
                 {"basic", 0},
                 {"reversed", false}
             }},
-            {"hide_paired_lyrics", false}
+            {"hide_paired_lyrics", false},
+            {"normalize_loudness", true}
         }},
         {"ai", {
             {"speech_assistant", false},
@@ -95,6 +96,10 @@ Config::Config() : Logger("Config") {
                 {"request_address", ""},
                 {"chathub_address", ""}
             }}
+        }},
+        {"recorder", {
+            {"profile", 0},
+            {"auto_pause", false}
         }}
     };
 
@@ -201,10 +206,17 @@ bool Config::_load() {
         warn("Configuration error, being repaired...");
         return _save() ? _load() : false;
     }
+    auto changed = false;
     if (tmp["version"] != VERSION_CONFIG) {
         if (!_update(tmp)) {
             return false;
         }
+        changed = true;
+    }
+    // Items introduced without a version bump are taken from the defaults.
+    // After updating, which may replace whole sections.
+    changed = _complete(tmp, mData) || changed;
+    if (changed) {
         info("Saving configuration...");
         mData = tmp;
         _save();
@@ -214,6 +226,19 @@ bool Config::_load() {
     return true;
 }
 
+bool Config::_complete(json& data, const json& defaults) {
+    auto completed = false;
+    for (auto& [name, value] : defaults.items()) {
+        if (!data.contains(name)) {
+            data[name] = value;
+            completed  = true;
+        } else if (value.is_object() && data[name].is_object()) {
+            completed = _complete(data[name], value) || completed;
+        }
+    }
+    return completed;
+}
+
 bool Config::_save() {
     std::ofstream ofile;
     ofile.open(get_config_path());
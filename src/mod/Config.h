@@ -31,6 +31,9 @@ private:
     bool _load();
 
     bool _update(json&);
+
+    // Adds what `defaults` has and `data` lacks, returns whether anything was added.
+    static bool _complete(json& data, const json& defaults);
 };
 
 } // namespace mod
@@ -123,10 +123,15 @@ PEN_HOOK(bool, license_verify) { return true; }
 #include "common/Event.h"
 #include "common/Resource.h"
 
+#include "filemanager/DiskUsage.h"
 #include "filemanager/FileManager.h"
+#include "filemanager/FileOperator.h"
+#include "filemanager/player/LoudnessStore.h"
+#include "filemanager/player/MetadataStore.h"
 #include "filemanager/player/MusicPlayer.h"
 #include "filemanager/player/VideoPlayer.h"
 #include "filemanager/reader/TextReader.h"
+#include "filemanager/search/FileSearcher.h"
 
 #include "helper/AntiEmbs.h"
 #include "helper/DeveloperSettings.h"
@@ -140,6 +145,7 @@ PEN_HOOK(bool, license_verify) { return true; }
 #include "mod/Updater.h"
 
 #include "recorder/AudioRecorder.h"
+#include "recorder/RecordingLibrary.h"
 
 #include "system/battery/BatteryInfo.h"
 #include "system/input/InputDaemon.h"
@@ -187,10 +193,15 @@ __attribute__((constructor)) static void BeforeMain() {
     INSTANCE(Resource);
 
     // filemanager
+    INSTANCE(filemanager::MetadataStore);
+    INSTANCE(filemanager::LoudnessStore);
     INSTANCE(filemanager::MusicPlayer);
     INSTANCE(filemanager::VideoPlayer);
     INSTANCE(filemanager::TextReader);
+    INSTANCE(filemanager::DiskUsage);
+    INSTANCE(filemanager::FileOperator);
     INSTANCE(filemanager::FileManager);
+    INSTANCE(filemanager::FileSearcher);
 
     // helper
     INSTANCE(AntiEmbs);
@@ -202,6 +213,7 @@ __attribute__((constructor)) static void BeforeMain() {
     INSTANCE(Locker);
 
     // recorder
+    INSTANCE(RecordingLibrary);
     INSTANCE(AudioRecorder);
 
     // system
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/AudioEncoder.h"
+
+#include <lame/lame.h>
+
+namespace mod {
+
+class Mp3Encoder : public AudioEncoder {
+public:
+    Mp3Encoder(const RecordingProfile& profile, int sampleRate, int channels) : mChannels(channels) {
+        mLame = lame_init();
+        lame_set_num_channels(mLame, channels);
+        lame_set_in_samplerate(mLame, sampleRate);
+        // LAME downmixes by itself when asked for mono.
+        lame_set_mode(mLame, channels >= 2 && !profile.mMono ? JOINT_STEREO : MONO);
+        if (profile.mVbrQuality >= 0) {
+            lame_set_VBR(mLame, vbr_mtrh);
+            lame_set_VBR_quality(mLame, (float)profile.mVbrQuality);
+        } else {
+            lame_set_brate(mLame, profile.mBitrate);
+        }
+        lame_set_quality(mLame, profile.mQuality);
+        lame_init_params(mLame);
+    }
+
+    ~Mp3Encoder() override { lame_close(mLame); }
+
+    void encode(const int16* pcm, size_t frames, std::vector<uint8>& out) override {
+        auto* buffer = _reserve(out, frames);
+        int   bytes;
+        if (mChannels >= 2) {
+            bytes = lame_encode_buffer_interleaved(mLame, (short*)pcm, (int)frames, buffer, _capacity(frames));
+        } else {
+            bytes = lame_encode_buffer(mLame, pcm, nullptr, (int)frames, buffer, _capacity(frames));
+        }
+        out.resize(out.size() - _capacity(frames) + std::max(bytes, 0));
+    }
+
+    void flush(std::vector<uint8>& out) override {
+        auto* buffer = _reserve(out, 0);
+        auto  bytes  = lame_encode_flush(mLame, buffer, _capacity(0));
+        out.resize(out.size() - _capacity(0) + std::max(bytes, 0));
+    }
+
+    // The Xing/Info frame at the beginning was written with placeholders, the real one carries the frame count,
+    // without it VBR files report a wrong duration.
+    std::vector<uint8> getFinalHeader(int64 size) override {
+        std::vector<uint8> tag(lame_get_lametag_frame(mLame, nullptr, 0));
+        tag.resize(lame_get_lametag_frame(mLame, tag.data(), tag.size()));
+        return tag;
+    }
+
+private:
+    lame_global_flags* mLame;
+    int                mChannels;
+
+    // Worst case, as documented by LAME.
+    static int _capacity(size_t frames) { return (int)(frames * 5 / 4 + 7200); }
+
+    static uint8* _reserve(std::vector<uint8>& out, size_t frames) {
+        out.resize(out.size() + _capacity(frames));
+        return out.data() + out.size() - _capacity(frames);
+    }
+};
+
+class WavEncoder : public AudioEncoder {
+public:
+    WavEncoder(int sampleRate, int channels) : mSampleRate(sampleRate), mChannels(channels) {}
+
+    // Sizes are unknown until the end, "as large as possible" lets players stream a file still being written.
+    void begin(std::vector<uint8>& out) override {
+        auto header = _makeHeader(UINT32_MAX);
+        out.insert(out.end(), header.begin(), header.end());
+    }
+
+    void encode(const int16* pcm, size_t frames, std::vector<uint8>& out) override {
+        auto* bytes = (const uint8*)pcm;
+        out.insert(out.end(), bytes, bytes + frames * mChannels * sizeof(int16));
+    }
+
+    std::vector<uint8> getFinalHeader(int64 size) override {
+        return _makeHeader((uint32)std::min<int64>(size - HEADER_SIZE, UINT32_MAX - HEADER_SIZE));
+    }
+
+private:
+    static constexpr uint32 HEADER_SIZE = 44;
+
+    int mSampleRate;
+    int mChannels;
+
+    [[nodiscard]] std::vector<uint8> _makeHeader(uint32 dataSize) const {
+        std::vector<uint8> header;
+        header.reserve(HEADER_SIZE);
+        auto tag = [&](const char* text) { header.insert(header.end(), text, text + 4); };
+        auto u32 = [&](uint32 value) {
+            for (int i = 0; i < 4; i++) header.emplace_back(value >> (8 * i));
+        };
+        auto u16 = [&](uint16 value) {
+            header.emplace_back(value);
+            header.emplace_back(value >> 8);
+        };
+        tag("RIFF");
+        u32(dataSize == UINT32_MAX ? UINT32_MAX : dataSize + HEADER_SIZE - 8);
+        tag("WAVE");
+        tag("fmt ");
+        u32(16);
+        u16(1); // PCM
+        u16(mChannels);
+        u32(mSampleRate);
+        u32(mSampleRate * mChannels * 2);
+        u16(mChannels * 2);
+        u16(16);
+        tag("data");
+        u32(dataSize);
+        return header;
+    }
+};
+
+// At 16kHz LAME caps CBR at 160kbps, VBR spends bits where the signal needs them instead.
+static const RecordingProfile PRESETS[] = {
+    {RecordingProfile::Format::Mp3, true, 7, 0, 7, "speech"}, // ~24kbps, a fraction of the CPU of quality 2.
+    {RecordingProfile::Format::Mp3, false, 2, 0, 2, "music"}, // ~100kbps.
+    {RecordingProfile::Format::Wav, false, -1, 0, 0, "lossless"},
+};
+
+std::span<const RecordingProfile> RecordingProfile::getPresets() { return PRESETS; }
+
+std::unique_ptr<AudioEncoder> AudioEncoder::create(const RecordingProfile& profile, int sampleRate, int channels) {
+    if (profile.mFormat == RecordingProfile::Format::Wav) {
+        return std::make_unique<WavEncoder>(sampleRate, channels);
+    }
+    return std::make_unique<Mp3Encoder>(profile, sampleRate, channels);
+}
+
+} // namespace mod
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include <span>
+
+namespace mod {
+
+struct RecordingProfile {
+    enum class Format : uint8 { Mp3, Wav };
+
+    Format      mFormat{Format::Mp3};
+    bool        mMono{};       // downmix a stereo input.
+    int         mVbrQuality{}; // 0 (best) ~ 9, -1 for CBR.
+    int         mBitrate{};    // kbps, CBR only.
+    int         mQuality{};    // LAME algorithm, 0 (best, slowest) ~ 9.
+    const char* mName{};
+
+    [[nodiscard]] QString getSuffix() const { return mFormat == Format::Wav ? ".wav" : ".mp3"; }
+
+    // The ones AudioRecorder offers, indexed by AudioRecorder::Profile.
+    static std::span<const RecordingProfile> getPresets();
+};
+
+// Turns interleaved 16-bit PCM into the bytes of a file.
+class AudioEncoder {
+public:
+    virtual ~AudioEncoder() = default;
+
+    // Written before anything else.
+    virtual void begin(std::vector<uint8>& out) {}
+
+    // Appends what `frames` input frames encode to.
+    virtual void encode(const int16* pcm, size_t frames, std::vector<uint8>& out) = 0;
+
+    // Appends what the encoder still holds.
+    virtual void flush(std::vector<uint8>& out) {}
+
+    // To write over the beginning of the file once `size` bytes were written in total, empty if nothing.
+    [[nodiscard]] virtual std::vector<uint8> getFinalHeader(int64 size) { return {}; }
+
+    static std::unique_ptr<AudioEncoder> create(const RecordingProfile& profile, int sampleRate, int channels);
+};
+
+} // namespace mod
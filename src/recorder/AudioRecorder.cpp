@@ -5,31 +5,54 @@
  */
 
 #include "recorder/AudioRecorder.h"
+#include "recorder/RecordingJournal.h"
+#include "recorder/RecordingLibrary.h"
 
 #include "base/YPointer.h"
 
 #include "common/Event.h"
 #include "common/Utils.h"
 
+#include "mod/Config.h"
+
 #include "system/input/InputDaemon.h"
 
 #include "Version.h"
 
 #include <QAudio>
 #include <QAudioDeviceInfo>
-#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QQmlContext>
 #include <QQuickView>
 #include <QUrl>
 
-#include <lame/lame.h>
-
 namespace mod {
 
-constexpr auto SAVE_PATH = "/userdisk/Music/录音文件/";
-constexpr auto LENGTH    = 1024 * 1024;
+constexpr auto LENGTH       = 1024 * 1024;
+constexpr auto CAPTURE_SIZE = 16 * 1024; // read from the device at once.
+
+constexpr int64 LEVEL_INTERVAL = 50;  // ms
+constexpr float METER_RANGE    = 60;  // dB
+constexpr int   PRE_ROLL       = 300; // ms
 
 AudioRecorder::AudioRecorder() : Logger("AudioRecorder") {
+    mCfg       = Config::getInstance().read(mClassName);
+    mProfile   = std::clamp<int>(mCfg["profile"], SpeechProfile, LosslessProfile);
+    mAutoPause = mCfg["auto_pause"];
+
+    // The last recording was never stopped.
+    if (auto journal = RecordingJournal::load()) {
+        if (!journal->repair()) {
+            warn("Unable to repair unfinished recording {}.", journal->mPath.toStdString());
+        } else if (QFile::exists(journal->mPath)) {
+            info("Repaired unfinished recording {}.", journal->mPath.toStdString());
+        } else {
+            info("Removed unfinished recording {}, nothing was written yet.", journal->mPath.toStdString());
+        }
+        RecordingJournal::remove();
+    }
+
     connect(&Event::getInstance(), &Event::beforeUiInitialization, [this](QQuickView& view, QQmlContext* context) {
         context->setContextProperty("audioRecorder", this);
         qmlRegisterUncreatableType<AudioRecorder>(
@@ -53,14 +76,49 @@ void AudioRecorder::setState(QAudio::State state) {
 
 QString AudioRecorder::getFileName() { return QFileInfo(mSavePath).fileName(); }
 
+int AudioRecorder::getProfile() const { return mProfile; }
+
+void AudioRecorder::setProfile(int profile) {
+    if (profile < SpeechProfile || profile > LosslessProfile) {
+        return;
+    }
+    if (mProfile != profile) {
+        mProfile        = profile;
+        mCfg["profile"] = profile;
+        WRITE_CFG;
+        emit profileChanged();
+    }
+}
+
+qreal AudioRecorder::getLevel() const { return mLevel; }
+
+qreal AudioRecorder::getPeak() const { return mPeak; }
+
+bool AudioRecorder::isVoiceActive() const { return mVoiceActive; }
+
+bool AudioRecorder::isAutoPause() const { return mAutoPause; }
+
+void AudioRecorder::setAutoPause(bool enabled) {
+    if (mAutoPause != enabled) {
+        mAutoPause         = enabled;
+        mCfg["auto_pause"] = enabled;
+        WRITE_CFG;
+        emit autoPauseChanged();
+    }
+}
+
+const RecordingProfile& AudioRecorder::_getRecordingProfile() const {
+    return RecordingProfile::getPresets()[mProfile];
+}
+
 AudioRecorder::SetPathResult AudioRecorder::setFileName(QString name) {
     if (!judgeIsLegalFileName(name)) {
         return SetPathResult::IllegalSymbolDetected;
     }
-    if (!name.endsWith(".mp3")) {
-        name += ".mp3";
+    if (auto suffix = _getRecordingProfile().getSuffix(); !name.endsWith(suffix)) {
+        name += suffix;
     }
-    mSavePath = SAVE_PATH + name;
+    mSavePath = RecordingLibrary::getDirectory() + name;
     emit fileNameChanged();
     return SetPathResult::Ok;
 }
@@ -71,9 +129,8 @@ bool AudioRecorder::start() {
     }
 
     // Init saving path.
-    mSavePath = _getSavePath();
-    mOutputFile.setFileName(mSavePath);
-    mOutputFile.open(QIODevice::ReadWrite | QIODevice::Truncate);
+    mSavePath      = RecordingLibrary::getInstance().takeNextPath(_getRecordingProfile().getSuffix());
+    mRecordingPath = mSavePath;
 
     // Init audio format.
     QAudioFormat format;
@@ -86,6 +143,27 @@ bool AudioRecorder::start() {
     format.setByteOrder(QAudioFormat::LittleEndian);
     format.setCodec("audio/pcm");
 
+    // Create encoding pipeline.
+    auto encoder = AudioEncoder::create(_getRecordingProfile(), format.sampleRate(), format.channelCount());
+    mPipeline    = std::make_unique<RecordingPipeline>(std::move(encoder), format.sampleRate(), format.channelCount());
+    if (!mPipeline->start(mSavePath)) {
+        error("Unable to open {}.", mSavePath.toStdString());
+        mPipeline.reset();
+        RecordingLibrary::getInstance().onRecordingFinished(mRecordingPath, mRecordingPath, 0);
+        showToast("创建录音文件失败", "#E9900C");
+        return false;
+    }
+    RecordingJournal journal{mSavePath, _getRecordingProfile().mFormat, format.sampleRate(), format.channelCount()};
+    if (!journal.save()) {
+        warn("Unable to write the recording journal, this recording can't be repaired after a crash.");
+    }
+    mCaptureBuffer.resize(CAPTURE_SIZE);
+    mReportedDrops = 0;
+    mSkipped       = 0;
+    mDetector.reset();
+    mPreRoll.clear();
+    mMeterTimer.start();
+
     // Init input device.
     PEN_CALL(void*, "_ZN12YSoundCenter9forceStopEv", void*)(YPointer<YSoundCenter>::getInstance());
     exec("amixer cset numid=2 1");
@@ -104,35 +182,22 @@ bool AudioRecorder::start() {
     // Start recording.
     mInputDevice = mInputAudio->start();
 
-    // Create lame instance.
-    mLame = lame_init();
-    lame_set_num_channels(mLame, format.channelCount());
-    lame_set_in_samplerate(mLame, format.sampleRate());
-    lame_set_brate(mLame, 320);
-    lame_set_mode(mLame, format.channelCount() >= 2 ? STEREO : MONO);
-    lame_set_quality(mLame, 2);
-    lame_init_params(mLame);
-    mMp3Data = new char[LENGTH];
-
     // Connect to signals.
+    // Only a copy into the pipeline's ring here, encoding and writing happen on its own thread.
     connect(mInputDevice, &QIODevice::readyRead, [&]() {
-        auto bytes   = mInputDevice->readAll();
-        int  samples = bytes.size() >> 1;
-        if (lame_get_num_channels(mLame) > 1) {
-            samples >>= 1;
-        }
-        int out_bytes = 0;
-        if (lame_get_num_channels(mLame) >= 2) {
-            out_bytes = lame_encode_buffer_interleaved(mLame, (short*)bytes.data(), samples, (uchar*)mMp3Data, LENGTH);
-        } else {
-            out_bytes = lame_encode_buffer(mLame, (short*)bytes.data(), nullptr, samples, (uchar*)mMp3Data, LENGTH);
-        }
-        if (out_bytes) {
-            mOutputFile.write(mMp3Data, out_bytes);
+        qint64 bytes;
+        while ((bytes = mInputDevice->read(mCaptureBuffer.data(), mCaptureBuffer.size())) > 0) {
+            _onCaptured((const int16*)mCaptureBuffer.constData(), (size_t)bytes / sizeof(int16));
         }
     });
 
-    connect(mInputAudio, &QAudioInput::notify, [&]() { emit notify(); });
+    connect(mInputAudio, &QAudioInput::notify, [&]() {
+        if (auto dropped = mPipeline->getStats().mDropped; dropped != mReportedDrops) {
+            warn("{} samples dropped, the encoder can't keep up.", dropped - mReportedDrops);
+            mReportedDrops = dropped;
+        }
+        emit notify();
+    });
 
     connect(mInputAudio, &QAudioInput::stateChanged, [&](QAudio::State state) { setState(state); });
 
@@ -156,16 +221,44 @@ bool AudioRecorder::stop() {
     exec("amixer cset numid=2 0");
     InputDaemon::getInstance().reset();
     mInputAudio->stop();
-    lame_close(mLame);
-    mOutputFile.rename(mSavePath);
-    mOutputFile.close();
+    auto saved = mPipeline->stop();
+    RecordingJournal::remove();
+    // Named by the user while recording, the pipeline kept writing to the path it was started with.
+    if (mSavePath != mRecordingPath && !QFile::rename(mRecordingPath, mSavePath)) {
+        warn("Unable to rename {} to {}.", mRecordingPath.toStdString(), mSavePath.toStdString());
+        mSavePath = mRecordingPath;
+        emit fileNameChanged();
+    }
+    auto stats    = mPipeline->getStats();
+    auto rate     = (double)mInputAudio->format().channelCount() * mInputAudio->format().sampleRate();
+    auto duration = (double)stats.mCaptured / rate;
+    info(
+        "Recorded {:.1f}s into {} bytes ({:.0f}KB/min) with profile {}, {:.1f}s of silence skipped, "
+        "{} samples dropped, encoder real-time factor {:.3f}.",
+        duration,
+        stats.mBytes,
+        duration > 0 ? (double)stats.mBytes / 1024 / duration * 60 : 0,
+        mProfile,
+        (double)mSkipped / rate,
+        stats.mDropped,
+        mPipeline->getRealTimeFactor()
+    );
+    RecordingLibrary::getInstance().onRecordingFinished(mRecordingPath, mSavePath, (int64)(duration * 1000));
 
     // Free vars.
     delete mInputAudio;
-    delete[] mMp3Data;
-    mLame       = nullptr;
+    mPipeline.reset();
     mInputAudio = nullptr;
-
+    mCaptureBuffer.clear();
+    mCaptureBuffer.squeeze();
+    mPreRoll.clear();
+    mPreRoll.shrink_to_fit();
+    _resetLevel();
+
+    if (!saved) {
+        showToast("写入录音文件时出现错误", "#E9900C");
+        return false;
+    }
     switch (error) {
     case QAudio::OpenError:
         showToast("打开输入设备时出现错误", "#E9900C");
@@ -187,22 +280,55 @@ bool AudioRecorder::stop() {
     }
 }
 
-QString AudioRecorder::_getSavePath() {
-    auto savedir = QDir(SAVE_PATH);
-    if (!savedir.exists()) {
-        savedir.mkpath(".");
+bool AudioRecorder::isWorking() { return mInputAudio != nullptr; }
+
+void AudioRecorder::_onCaptured(const int16* samples, size_t count) {
+    auto format = mInputAudio->format();
+    auto level  = measureLevel(samples, count);
+    auto ms     = (double)count * 1000 / format.channelCount() / format.sampleRate();
+
+    mMeter.merge(level);
+    if (mMeterTimer.elapsed() >= LEVEL_INTERVAL) {
+        mLevel = std::clamp((mMeter.getRmsDb() + METER_RANGE) / METER_RANGE, 0.0f, 1.0f);
+        mPeak  = std::clamp((mMeter.getPeakDb() + METER_RANGE) / METER_RANGE, 0.0f, 1.0f);
+        mMeter = {};
+        mMeterTimer.restart();
+        emit levelChanged();
+    }
+
+    auto voice = mDetector.update(level.getRmsDb(), ms);
+    if (mVoiceActive != voice) {
+        mVoiceActive = voice;
+        emit voiceActiveChanged();
     }
-    int index = 0;
-    while (true) {
-        index++;
-        auto file = QString("新录音%1.mp3").arg(index, 2, 10, QLatin1Char('0'));
-        if (!savedir.exists(file)) {
-            return SAVE_PATH + file;
+    if (!mAutoPause || voice) {
+        if (!mPreRoll.empty()) {
+            mPipeline->push(mPreRoll.data(), mPreRoll.size());
+            mPreRoll.clear();
         }
+        mPipeline->push(samples, count);
+        return;
+    }
+    // Paused, only the latest silence is kept.
+    mPreRoll.insert(mPreRoll.end(), samples, samples + count);
+    auto keep = (size_t)format.sampleRate() * PRE_ROLL / 1000 * format.channelCount();
+    if (mPreRoll.size() > keep) {
+        auto excess  = mPreRoll.size() - keep;
+        mSkipped    += excess;
+        mPreRoll.erase(mPreRoll.begin(), mPreRoll.begin() + (ptrdiff_t)excess);
     }
 }
 
-bool AudioRecorder::isWorking() { return mInputAudio != nullptr; }
+void AudioRecorder::_resetLevel() {
+    mMeter = {};
+    mLevel = 0;
+    mPeak  = 0;
+    emit levelChanged();
+    if (mVoiceActive) {
+        mVoiceActive = false;
+        emit voiceActiveChanged();
+    }
+}
 
 } // namespace mod
 
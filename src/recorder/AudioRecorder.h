@@ -6,13 +6,13 @@
 
 #pragma once
 
+#include "recorder/LevelMeter.h"
+#include "recorder/RecordingPipeline.h"
+
 #include "common/service/Logger.h"
 
 #include <QAudioInput>
-#include <QFile>
-
-struct lame_global_struct;
-typedef struct lame_global_struct lame_global_flags;
+#include <QElapsedTimer>
 
 namespace mod {
 
@@ -21,6 +21,11 @@ class AudioRecorder : public QObject, public Singleton<AudioRecorder>, private L
 
     Q_PROPERTY(int state READ getState NOTIFY stateChanged);
     Q_PROPERTY(QString fileName READ getFileName NOTIFY fileNameChanged);
+    Q_PROPERTY(int profile READ getProfile WRITE setProfile NOTIFY profileChanged);
+    Q_PROPERTY(qreal level READ getLevel NOTIFY levelChanged);
+    Q_PROPERTY(qreal peak READ getPeak NOTIFY levelChanged);
+    Q_PROPERTY(bool voiceActive READ isVoiceActive NOTIFY voiceActiveChanged);
+    Q_PROPERTY(bool autoPause READ isAutoPause WRITE setAutoPause NOTIFY autoPauseChanged);
 
 public:
     enum Error { NoError, OpenError, IOError, UnderrunError, FatalError };
@@ -32,6 +37,10 @@ public:
     enum SetPathResult { Ok, IllegalSymbolDetected };
     Q_ENUM(SetPathResult)
 
+    // Speech: mono VBR, small files. Music: stereo VBR at high quality. Lossless: plain WAV.
+    enum Profile { SpeechProfile, MusicProfile, LosslessProfile };
+    Q_ENUM(Profile)
+
     int getState() const;
 
     void setState(QAudio::State state);
@@ -46,6 +55,23 @@ public:
 
     QString getFileName();
 
+    int getProfile() const;
+
+    // Takes effect from the next recording.
+    void setProfile(int profile);
+
+    // Meter positions 0 ~ 1 over the last few blocks, -60dBFS to full scale.
+    qreal getLevel() const;
+
+    qreal getPeak() const;
+
+    bool isVoiceActive() const;
+
+    // Silence is not encoded, the recording only holds what was said.
+    bool isAutoPause() const;
+
+    void setAutoPause(bool enabled);
+
     bool suspend();
 
     bool resume();
@@ -60,24 +86,51 @@ signals:
 
     void fileNameChanged();
 
+    void profileChanged();
+
+    // At most every 50ms while recording.
+    void levelChanged();
+
+    void voiceActiveChanged();
+
+    void autoPauseChanged();
+
 private:
     friend Singleton<AudioRecorder>;
     explicit AudioRecorder();
 
     std::string mClassName = "recorder";
+    json        mCfg;
 
-    lame_global_flags* mLame{};
-    QAudioInput*       mInputAudio{};
-    QIODevice*         mInputDevice{};
+    QAudioInput* mInputAudio{};
+    QIODevice*   mInputDevice{};
+    QByteArray   mCaptureBuffer;
 
-    QFile   mOutputFile;
-    QString mSavePath;
+    std::unique_ptr<RecordingPipeline> mPipeline;
+    uint64                             mReportedDrops{};
 
-    char* mMp3Data{};
+    BlockLevel         mMeter; // since levelChanged() was last emitted.
+    QElapsedTimer      mMeterTimer;
+    qreal              mLevel{};
+    qreal              mPeak{};
+    VoiceDetector      mDetector;
+    bool               mVoiceActive{};
+    bool               mAutoPause{};
+    std::vector<int16> mPreRoll; // silence kept to lead in when voice comes back.
+    uint64             mSkipped{};
+
+    QString mSavePath;
+    QString mRecordingPath; // opened by the pipeline, mSavePath follows setFileName().
 
     int mState{-1};
+    int mProfile{SpeechProfile};
+
+    [[nodiscard]] const RecordingProfile& _getRecordingProfile() const;
+
+    // Every block read from the device goes through here.
+    void _onCaptured(const int16* samples, size_t count);
 
-    QString _getSavePath();
+    void _resetLevel();
 };
 
 } // namespace mod
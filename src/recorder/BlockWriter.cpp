@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/BlockWriter.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace mod {
+
+constexpr size_t PAGE_SIZE = 4096;
+
+BlockWriter::BlockWriter(size_t blockSize) : mBlockSize((blockSize + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE) {
+    mBuffer = (uint8*)std::aligned_alloc(PAGE_SIZE, mBlockSize);
+}
+
+BlockWriter::~BlockWriter() {
+    close();
+    std::free(mBuffer);
+}
+
+bool BlockWriter::open(const QString& path) {
+    close();
+    mFd      = ::open(path.toUtf8().constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    mFill    = 0;
+    mWritten = 0;
+    return mFd >= 0;
+}
+
+bool BlockWriter::write(const void* data, size_t size) {
+    auto* bytes = (const uint8*)data;
+    while (size > 0) {
+        auto count = std::min(size, mBlockSize - mFill);
+        memcpy(mBuffer + mFill, bytes, count);
+        mFill += count;
+        bytes += count;
+        size  -= count;
+        if (mFill == mBlockSize && !flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BlockWriter::flush() {
+    if (mFd < 0 || mFill == 0) {
+        return mFd >= 0;
+    }
+    if (!_writeAll(mBuffer, mFill)) {
+        return false;
+    }
+    mWritten += (int64)mFill;
+    mFill     = 0;
+    return true;
+}
+
+bool BlockWriter::sync() {
+    if (mFd < 0) {
+        return false;
+    }
+    auto pages = mFill / PAGE_SIZE * PAGE_SIZE;
+    if (pages > 0) {
+        if (!_writeAll(mBuffer, pages)) {
+            return false;
+        }
+        mWritten += (int64)pages;
+        mFill    -= pages;
+        memmove(mBuffer, mBuffer + pages, mFill);
+    }
+    // pwrite() leaves the file offset where the next block goes, over this tail.
+    for (size_t done = 0; done < mFill;) {
+        auto count = ::pwrite(mFd, mBuffer + done, mFill - done, mWritten + (int64)done);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        done += count;
+    }
+    return ::fdatasync(mFd) == 0;
+}
+
+bool BlockWriter::writeAt(int64 offset, const void* data, size_t size) {
+    if (!flush()) {
+        return false;
+    }
+    auto* bytes = (const uint8*)data;
+    while (size > 0) {
+        auto count = ::pwrite(mFd, bytes, size, offset);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes  += count;
+        size   -= count;
+        offset += count;
+    }
+    return true;
+}
+
+bool BlockWriter::close() {
+    if (mFd < 0) {
+        return false;
+    }
+    auto ok = flush();
+    ok      = ::fdatasync(mFd) == 0 && ok;
+    ok      = ::close(mFd) == 0 && ok;
+    mFd     = -1;
+    return ok;
+}
+
+bool BlockWriter::_writeAll(const uint8* data, size_t size) {
+    while (size > 0) {
+        auto count = ::write(mFd, data, size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+} // namespace mod
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+namespace mod {
+
+// Buffers a file being written and hands it to the kernel in whole, page-aligned blocks,
+// so that the flash sees a few large writes instead of one per encoded frame.
+class BlockWriter {
+public:
+    explicit BlockWriter(size_t blockSize = 64 * 1024);
+
+    ~BlockWriter();
+
+    BlockWriter(const BlockWriter&) = delete;
+
+    BlockWriter& operator=(const BlockWriter&) = delete;
+
+    // Truncates the file.
+    bool open(const QString& path);
+
+    [[nodiscard]] bool isOpen() const { return mFd >= 0; }
+
+    // Only full blocks are written here.
+    bool write(const void* data, size_t size);
+
+    // Writes the partial block too.
+    bool flush();
+
+    // Makes everything written so far durable without breaking the alignment of later blocks:
+    // whole pages are written for good, the partial last page is written and written again later.
+    bool sync();
+
+    // Flushes, then overwrites bytes already written, for headers only known at the end.
+    bool writeAt(int64 offset, const void* data, size_t size);
+
+    // Flushes, syncs and closes.
+    bool close();
+
+    // Bytes written so far, buffered ones included.
+    [[nodiscard]] int64 getSize() const { return mWritten + (int64)mFill; }
+
+private:
+    int    mFd{-1};
+    uint8* mBuffer{};
+    size_t mBlockSize;
+    size_t mFill{};
+    int64  mWritten{};
+
+    bool _writeAll(const uint8* data, size_t size);
+};
+
+} // namespace mod
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/LevelMeter.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mod {
+
+constexpr float SILENCE_DB = -96;
+
+constexpr float  MARGIN_DB     = 9;    // above the floor to count as voice.
+constexpr float  MIN_VOICE_DB  = -55;  // quieter than this is never voice.
+constexpr float  FLOOR_RISE    = 0.5f; // dB per second.
+constexpr double HANGOVER_TIME = 1500; // ms
+
+void BlockLevel::merge(const BlockLevel& other) {
+    mSquares += other.mSquares;
+    mCount   += other.mCount;
+    mPeak     = std::max(mPeak, other.mPeak);
+}
+
+float BlockLevel::getRmsDb() const {
+    if (mSquares == 0) {
+        return SILENCE_DB;
+    }
+    auto meanSquare = (double)mSquares / (double)mCount / (32768.0 * 32768.0);
+    return std::max(SILENCE_DB, (float)(10 * std::log10(meanSquare)));
+}
+
+float BlockLevel::getPeakDb() const {
+    return mPeak ? std::max(SILENCE_DB, (float)(20 * std::log10(mPeak / 32768.0))) : SILENCE_DB;
+}
+
+BlockLevel measureLevel(const int16* samples, size_t count) {
+    BlockLevel level{0, count, 0};
+    size_t     i = 0;
+#if defined(__ARM_NEON)
+    auto squares = vdupq_n_u64(0);
+    auto peak    = vdupq_n_s16(0);
+    for (; i + 8 <= count; i += 8) {
+        auto x = vld1q_s16(samples + i);
+        // Each product fits in 31 bits, pairs are widened before adding up.
+        auto lo = vreinterpretq_u32_s32(vmull_s16(vget_low_s16(x), vget_low_s16(x)));
+        auto hi = vreinterpretq_u32_s32(vmull_high_s16(x, x));
+        squares = vpadalq_u32(squares, lo);
+        squares = vpadalq_u32(squares, hi);
+        peak    = vmaxq_s16(peak, vqabsq_s16(x));
+    }
+    level.mSquares = vaddvq_u64(squares);
+    level.mPeak    = vmaxvq_s16(peak);
+#elif defined(__SSE2__)
+    auto zero    = _mm_setzero_si128();
+    auto squares = _mm_setzero_si128();
+    auto peak    = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        auto x = _mm_loadu_si128((const __m128i*)(samples + i));
+        // Sums of two squares reach 2^31, unsigned 32 bits hold them, then they are widened.
+        auto pairs = _mm_madd_epi16(x, x);
+        squares    = _mm_add_epi64(squares, _mm_unpacklo_epi32(pairs, zero));
+        squares    = _mm_add_epi64(squares, _mm_unpackhi_epi32(pairs, zero));
+        peak       = _mm_max_epi16(peak, _mm_max_epi16(x, _mm_subs_epi16(zero, x)));
+    }
+    uint64 lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, squares);
+    level.mSquares = lanes[0] + lanes[1];
+    int16 peaks[8];
+    _mm_storeu_si128((__m128i*)peaks, peak);
+    level.mPeak = *std::max_element(peaks, peaks + 8);
+#endif
+    for (; i < count; i++) {
+        level.mSquares += (uint64)(samples[i] * samples[i]);
+        level.mPeak     = std::max(level.mPeak, std::min(std::abs((int)samples[i]), 32767));
+    }
+    return level;
+}
+
+bool VoiceDetector::update(float rmsDb, double ms) {
+    if (!mFloor || rmsDb < *mFloor) {
+        mFloor = rmsDb;
+    } else {
+        mFloor = std::min(rmsDb, *mFloor + FLOOR_RISE * (float)ms / 1000);
+    }
+    if (rmsDb > *mFloor + MARGIN_DB && rmsDb > MIN_VOICE_DB) {
+        mQuiet = 0;
+    } else {
+        mQuiet += ms;
+    }
+    return mQuiet < HANGOVER_TIME;
+}
+
+void VoiceDetector::reset() {
+    mFloor.reset();
+    mQuiet = 0;
+}
+
+} // namespace mod
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+namespace mod {
+
+// Energy and peak of a block of 16-bit samples, channels mixed together.
+struct BlockLevel {
+    uint64 mSquares{}; // sum of squares.
+    size_t mCount{};   // samples.
+    int    mPeak{};    // largest magnitude, 0 ~ 32767.
+
+    void merge(const BlockLevel& other);
+
+    // dBFS, a full-scale sine is -3dB. -96 for silence.
+    [[nodiscard]] float getRmsDb() const;
+
+    [[nodiscard]] float getPeakDb() const;
+};
+
+// Vectorized, cheap enough for every block read from the device.
+BlockLevel measureLevel(const int16* samples, size_t count);
+
+// Energy-based voice activity: loud enough above a noise floor that follows the room.
+// The floor drops at once with the level and rises slowly, so a pause between words resets it
+// while a fan turning on is learned within seconds.
+class VoiceDetector {
+public:
+    // Feeds a block lasting `ms`, returns whether voice is active.
+    // Activity is held for a while after the last loud block, not to cut the end of a sentence.
+    bool update(float rmsDb, double ms);
+
+    void reset();
+
+private:
+    std::optional<float> mFloor;
+    double               mQuiet{}; // ms since the last loud block.
+};
+
+} // namespace mod
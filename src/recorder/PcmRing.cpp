@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/PcmRing.h"
+
+#include <bit>
+#include <cstring>
+
+namespace mod {
+
+PcmRing::PcmRing(size_t capacity, int channels)
+: mMask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), mChannels(std::max(channels, 1)) {
+    mData = std::make_unique<int16[]>(mMask + 1);
+}
+
+size_t PcmRing::push(const int16* data, size_t count) {
+    auto head  = mHead.load(std::memory_order_relaxed);
+    auto tail  = mTail.load(std::memory_order_acquire);
+    auto free  = capacity() - (head - tail);
+    count      = std::min(count, free) / mChannels * mChannels;
+    auto index = head & mMask;
+    auto first = std::min(count, capacity() - index);
+    memcpy(mData.get() + index, data, first * sizeof(int16));
+    memcpy(mData.get(), data + first, (count - first) * sizeof(int16));
+    mHead.store(head + count, std::memory_order_release);
+    return count;
+}
+
+size_t PcmRing::pop(int16* out, size_t count) {
+    auto tail  = mTail.load(std::memory_order_relaxed);
+    auto head  = mHead.load(std::memory_order_acquire);
+    count      = std::min(count, head - tail);
+    auto index = tail & mMask;
+    auto first = std::min(count, capacity() - index);
+    memcpy(out, mData.get() + index, first * sizeof(int16));
+    memcpy(out + first, mData.get(), (count - first) * sizeof(int16));
+    mTail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+size_t PcmRing::size() const { return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire); }
+
+} // namespace mod
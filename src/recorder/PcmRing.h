@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+namespace mod {
+
+// Single-producer single-consumer ring of interleaved 16-bit samples, allocated once.
+// Neither side ever blocks or allocates, a push that doesn't fit drops the frames that don't.
+class PcmRing {
+public:
+    // `capacity` in samples, rounded up to a power of two.
+    PcmRing(size_t capacity, int channels);
+
+    // Producer side. Whole frames only, returns the number of samples stored.
+    size_t push(const int16* data, size_t count);
+
+    // Consumer side. Returns the number of samples copied to `out`.
+    size_t pop(int16* out, size_t count);
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] size_t capacity() const { return mMask + 1; }
+
+private:
+    std::unique_ptr<int16[]> mData;
+    size_t                   mMask;
+    size_t                   mChannels;
+
+    // On separate cache lines, each is written by one side only.
+    alignas(64) std::atomic<size_t> mHead{0};
+    alignas(64) std::atomic<size_t> mTail{0};
+};
+
+} // namespace mod
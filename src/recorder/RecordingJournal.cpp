@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/RecordingJournal.h"
+
+#include "common/util/System.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstring>
+
+namespace mod {
+
+constexpr quint32 JOURNAL_MAGIC   = 0x504D524A; // "PMRJ"
+constexpr quint32 JOURNAL_VERSION = 1;
+
+constexpr int64 WAV_HEADER_SIZE = 44;
+
+static QString journalFile() { return util::getCachePath("recording"); }
+
+// Length of the MPEG audio layer III frame starting at `data`, 0 if it is not one.
+static size_t mp3FrameSize(const uint8* data) {
+    static const int bitrates[2][16] = {
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0},     // MPEG-2 / 2.5
+        {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0}, // MPEG-1
+    };
+    static const int sampleRates[4][4] = {
+        {11025, 12000, 8000, 0},  // MPEG-2.5
+        {},                       // reserved
+        {22050, 24000, 16000, 0}, // MPEG-2
+        {44100, 48000, 32000, 0}, // MPEG-1
+    };
+    if (data[0] != 0xFF || (data[1] & 0xE0) != 0xE0 || (data[1] & 0x06) != 0x02) {
+        return 0;
+    }
+    auto version    = (data[1] >> 3) & 0x03;
+    auto mpeg1      = version == 3;
+    auto bitrate    = bitrates[mpeg1][data[2] >> 4];
+    auto sampleRate = sampleRates[version][(data[2] >> 2) & 0x03];
+    if (!bitrate || !sampleRate) {
+        return 0;
+    }
+    auto padding = (data[2] >> 1) & 0x01;
+    return (mpeg1 ? 144 : 72) * bitrate * 1000 / sampleRate + padding;
+}
+
+// CRC-16 of LAME's tag, polynomial 0x8005 reflected.
+static uint16 lameCrc(const uint8* data, size_t size) {
+    uint16 crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static void putBigEndian(uint8* data, uint32 value) {
+    for (int i = 0; i < 4; i++) {
+        data[i] = value >> (8 * (3 - i));
+    }
+}
+
+// The Xing/Info frame LAME writes first holds placeholders until the end of encoding,
+// fill in what a player needs to get the duration and seek: frame count, stream size and a linear TOC.
+static void fixXingFrame(uint8* frame, size_t frameSize, uint32 frames, uint32 bytes) {
+    auto mpeg1  = ((frame[1] >> 3) & 0x03) == 3;
+    auto mono   = (frame[3] >> 6) == 3;
+    auto offset = 4 + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+    if (offset + 120 > (int)frameSize) {
+        return;
+    }
+    auto* xing = frame + offset;
+    if (memcmp(xing, "Xing", 4) != 0 && memcmp(xing, "Info", 4) != 0) {
+        return;
+    }
+    auto  flags = xing[7];
+    auto* field = xing + 8;
+    if (flags & 0x01) {
+        putBigEndian(field, frames);
+        field += 4;
+    }
+    if (flags & 0x02) {
+        putBigEndian(field, bytes);
+        field += 4;
+    }
+    if (flags & 0x04) {
+        for (int i = 0; i < 100; i++) {
+            field[i] = i * 256 / 100;
+        }
+        field += 100;
+    }
+    if (flags & 0x08) {
+        field += 4;
+    }
+    // LAME extension, 36 bytes ending with a CRC of the frame up to there.
+    auto ext = field - frame;
+    if (ext + 36 > (int64)frameSize || memcmp(field, "LAME", 4) != 0) {
+        return;
+    }
+    putBigEndian(field + 28, bytes);
+    auto crc  = lameCrc(frame, ext + 34);
+    field[34] = crc >> 8;
+    field[35] = crc;
+}
+
+static bool repairMp3(QFile& file) {
+    auto size = file.size();
+    if (size < 4) {
+        return file.remove();
+    }
+    auto* data = file.map(0, size);
+    if (!data) {
+        return false;
+    }
+    int64  end    = 0;
+    uint32 frames = 0;
+    while (end + 4 <= size) {
+        auto frameSize = mp3FrameSize(data + end);
+        if (!frameSize || end + (int64)frameSize > size) {
+            break;
+        }
+        end += (int64)frameSize;
+        frames++;
+    }
+    if (frames == 0) {
+        file.unmap(data);
+        return file.remove();
+    }
+    std::vector<uint8> first(data, data + mp3FrameSize(data));
+    file.unmap(data);
+    fixXingFrame(first.data(), first.size(), frames - 1, (uint32)end);
+    return file.resize(end) && file.seek(0)
+        && file.write((const char*)first.data(), first.size()) == (qint64)first.size();
+}
+
+static bool repairWav(QFile& file, int sampleRate, int channels) {
+    auto size = file.size();
+    if (size < WAV_HEADER_SIZE) {
+        return file.remove();
+    }
+    auto frameSize = channels * (int64)sizeof(int16);
+    auto end       = WAV_HEADER_SIZE + (size - WAV_HEADER_SIZE) / frameSize * frameSize;
+    auto header    = AudioEncoder::create({RecordingProfile::Format::Wav}, sampleRate, channels)->getFinalHeader(end);
+    return file.resize(end) && file.seek(0)
+        && file.write((const char*)header.data(), header.size()) == (qint64)header.size();
+}
+
+bool RecordingJournal::save() const {
+    QSaveFile out(journalFile());
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&out);
+    stream << JOURNAL_MAGIC << JOURNAL_VERSION << mPath << (quint8)mFormat << (qint32)mSampleRate << (qint32)mChannels;
+    return stream.status() == QDataStream::Ok && out.commit();
+}
+
+std::optional<RecordingJournal> RecordingJournal::load() {
+    QFile in(journalFile());
+    if (!in.open(QIODevice::ReadOnly)) {
+        return std::nullopt;
+    }
+    QDataStream stream(&in);
+    quint32     magic, version;
+    quint8      format;
+    qint32      sampleRate, channels;
+    QString     path;
+    stream >> magic >> version >> path >> format >> sampleRate >> channels;
+    if (stream.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION || channels <= 0) {
+        return std::nullopt;
+    }
+    return RecordingJournal{std::move(path), (RecordingProfile::Format)format, sampleRate, channels};
+}
+
+void RecordingJournal::remove() { QFile::remove(journalFile()); }
+
+bool RecordingJournal::repair() const {
+    QFile file(mPath);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    auto ok = mFormat == RecordingProfile::Format::Wav ? repairWav(file, mSampleRate, mChannels) : repairMp3(file);
+    // Closed if it was removed.
+    return (!file.isOpen() || file.flush()) && ok;
+}
+
+} // namespace mod
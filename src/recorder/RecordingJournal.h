@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "recorder/AudioEncoder.h"
+
+namespace mod {
+
+// Written when a recording starts and removed once it was closed properly.
+// Still there at startup means the app died mid-recording, the file is then repaired with what it holds.
+struct RecordingJournal {
+    QString                  mPath;
+    RecordingProfile::Format mFormat{};
+    int                      mSampleRate{};
+    int                      mChannels{};
+
+    bool save() const;
+
+    static std::optional<RecordingJournal> load();
+
+    static void remove();
+
+    // Cuts a torn last frame off and rewrites the header the encoder had no chance to finish.
+    // A file without a single whole frame, killed before the first checkpoint, is removed as there is nothing to keep.
+    // Returns false if the file is gone or can't be rewritten.
+    [[nodiscard]] bool repair() const;
+};
+
+} // namespace mod
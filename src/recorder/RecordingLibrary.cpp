@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/RecordingLibrary.h"
+
+#include "filemanager/FileEntity.h"
+#include "filemanager/player/MetadataStore.h"
+
+#include "common/Event.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QQmlContext>
+#include <QSet>
+#include <QtEndian>
+
+#include <cstring>
+
+namespace mod {
+
+constexpr auto DIRECTORY    = "/userdisk/Music/录音文件/";
+constexpr auto NAME_PREFIX  = "新录音";
+constexpr int  MAX_NUMBER   = 99999; // larger ones were named by hand, not worth a slot each.
+constexpr int  RESCAN_DELAY = 500;   // ms, copying a few files in is a single rescan.
+
+static const QStringList NAME_FILTERS = {"*.mp3", "*.wav"};
+
+// N of "新录音N.mp3" or "新录音N.wav", 0 for any other name.
+static int parseNumber(const QString& name) {
+    if (!name.startsWith(NAME_PREFIX) || name.size() < 8) {
+        return 0;
+    }
+    bool ok;
+    auto number = name.midRef(3, name.size() - 7).toInt(&ok);
+    return ok && number > 0 && number <= MAX_NUMBER ? number : 0;
+}
+
+// From the header, the data size of a recording that was never finished (0xFFFFFFFF) is capped by the file size.
+static int64 readWavDuration(const QString& path, int64 size) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    auto header = file.read(512);
+    if (header.size() < 12 || !header.startsWith("RIFF") || header.mid(8, 4) != "WAVE") {
+        return 0;
+    }
+    auto*  data     = (const uchar*)header.constData();
+    uint32 byteRate = 0;
+    for (int64 pos = 12; pos + 8 <= header.size();) {
+        auto length = qFromLittleEndian<quint32>(data + pos + 4);
+        if (!memcmp(data + pos, "fmt ", 4) && pos + 20 <= header.size()) {
+            byteRate = qFromLittleEndian<quint32>(data + pos + 16);
+        } else if (!memcmp(data + pos, "data", 4)) {
+            auto dataSize = std::min<int64>(length, size - pos - 8);
+            return byteRate ? dataSize * 1000 / byteRate : 0;
+        }
+        pos += 8 + length + (length & 1);
+    }
+    return 0;
+}
+
+RecordingLibrary::RecordingLibrary() : QAbstractListModel(), Logger("RecordingLibrary") {
+    QDir().mkpath(DIRECTORY);
+    mWatcher.addPath(DIRECTORY);
+    mRescanTimer.setSingleShot(true);
+    mRescanTimer.setInterval(RESCAN_DELAY);
+    connect(&mRescanTimer, &QTimer::timeout, [this]() { _rescan(); });
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged, this, &RecordingLibrary::onDirectoryChanged);
+    connect(
+        &filemanager::MetadataStore::getInstance(),
+        &filemanager::MetadataStore::metadataReady,
+        this,
+        &RecordingLibrary::onMetadataReady
+    );
+    connect(&Event::getInstance(), &Event::uiCompleted, [this]() {
+        if (mReady || mScanner.joinable()) {
+            return;
+        }
+        mScanner = std::thread([this]() {
+            QElapsedTimer timer;
+            timer.start();
+            mScanned = _scan();
+            debug("Scanned {} recordings in {}ms.", mScanned.size(), timer.elapsed());
+            QMetaObject::invokeMethod(this, [this]() { _onScanned(); }, Qt::QueuedConnection);
+        });
+    });
+    connect(&Event::getInstance(), &Event::beforeUiInitialization, [this](QQuickView& view, QQmlContext* context) {
+        context->setContextProperty("recordingLibrary", this);
+    });
+}
+
+RecordingLibrary::~RecordingLibrary() {
+    if (mScanner.joinable()) {
+        mScanner.join();
+    }
+}
+
+int RecordingLibrary::rowCount(const QModelIndex& parent) const { return (int)mRecordings.size(); }
+
+QVariant RecordingLibrary::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= (int)mRecordings.size()) {
+        return {};
+    }
+    auto& recording = mRecordings[index.row()];
+    switch ((UserRoles)role) {
+    case UserRoles::FileName:
+        return recording.mName;
+    case UserRoles::FilePath:
+        return getDirectory() + recording.mName;
+    case UserRoles::Size:
+        return filemanager::formatSize(recording.mSize);
+    case UserRoles::Duration:
+        return recording.mDuration > 0 ? filemanager::formatDuration(recording.mDuration) : QString();
+    case UserRoles::ModifiedTime:
+        return (qint64)recording.mModifiedTime;
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> RecordingLibrary::roleNames() const {
+    return QHash<int, QByteArray>{
+        {(int)UserRoles::FileName,     "fileName"},
+        {(int)UserRoles::FilePath,     "filePath"},
+        {(int)UserRoles::Size,         "size"    },
+        {(int)UserRoles::Duration,     "duration"},
+        {(int)UserRoles::ModifiedTime, "modified"}
+    };
+}
+
+bool RecordingLibrary::isReady() const { return mReady; }
+
+QString RecordingLibrary::getDirectory() { return DIRECTORY; }
+
+QString RecordingLibrary::takeNextPath(const QString& suffix) {
+    if (!mReady) {
+        // Recording before the first scan came back.
+        if (mScanner.joinable()) {
+            mScanner.join();
+        } else {
+            mScanned = _scan();
+        }
+        _onScanned();
+    }
+    auto number = mNextNumber;
+    auto name   = QString("%1%2").arg(NAME_PREFIX).arg(number, 2, 10, QLatin1Char('0')) + suffix;
+    // Listed right away, the file is created when the recording starts.
+    _insert({name, 0, QDateTime::currentMSecsSinceEpoch(), 0, number});
+    return getDirectory() + name;
+}
+
+void RecordingLibrary::onRecordingFinished(const QString& recordedPath, const QString& savedPath, int64 duration) {
+    auto name = QFileInfo(recordedPath).fileName();
+    auto it   = std::find_if(mRecordings.begin(), mRecordings.end(), [&](auto& item) { return item.mName == name; });
+    if (it == mRecordings.end()) {
+        return;
+    }
+    auto row = (int)(it - mRecordings.begin());
+    QFileInfo info(savedPath);
+    if (!info.exists()) {
+        _remove(row);
+        return;
+    }
+    if (info.fileName() != it->mName) {
+        _setTaken(it->mNumber, false);
+        it->mName   = info.fileName();
+        it->mNumber = parseNumber(it->mName);
+        _setTaken(it->mNumber, true);
+    }
+    it->mSize         = info.size();
+    it->mModifiedTime = info.lastModified().toMSecsSinceEpoch();
+    it->mDuration     = duration;
+    emit dataChanged(index(row), index(row));
+}
+
+void RecordingLibrary::onDirectoryChanged(const QString& path) {
+    if (mReady) {
+        mRescanTimer.start();
+    }
+}
+
+void RecordingLibrary::onMetadataReady(const QStringList& paths) {
+    QSet<QString> names;
+    for (auto& path : paths) {
+        if (path.startsWith(DIRECTORY)) {
+            names.insert(path.mid(getDirectory().size()));
+        }
+    }
+    if (names.isEmpty()) {
+        return;
+    }
+    auto& store = filemanager::MetadataStore::getInstance();
+    for (int row = 0; row < (int)mRecordings.size(); row++) {
+        auto& recording = mRecordings[row];
+        if (recording.mDuration > 0 || !names.contains(recording.mName)) {
+            continue;
+        }
+        if (auto meta = store.get(getDirectory() + recording.mName); meta && meta->mDuration > 0) {
+            recording.mDuration = meta->mDuration;
+            emit dataChanged(index(row), index(row));
+        }
+    }
+}
+
+RecordingLibrary::Recording RecordingLibrary::_stat(const QString& name) {
+    QFileInfo info(getDirectory() + name);
+    Recording recording{name, info.size(), info.lastModified().toMSecsSinceEpoch(), 0, parseNumber(name)};
+    if (name.endsWith(".wav", Qt::CaseInsensitive)) {
+        recording.mDuration = readWavDuration(info.filePath(), recording.mSize);
+    }
+    return recording;
+}
+
+std::vector<RecordingLibrary::Recording> RecordingLibrary::_scan() {
+    std::vector<Recording> ret;
+    for (auto& name : QDir(DIRECTORY).entryList(NAME_FILTERS, QDir::Files, QDir::NoSort)) {
+        ret.emplace_back(_stat(name));
+    }
+    std::sort(ret.begin(), ret.end(), [](auto& a, auto& b) { return a.mModifiedTime > b.mModifiedTime; });
+    return ret;
+}
+
+void RecordingLibrary::_onScanned() {
+    if (mReady) {
+        return;
+    }
+    if (mScanner.joinable()) {
+        mScanner.join();
+    }
+    beginResetModel();
+    mRecordings = std::move(mScanned);
+    for (auto& recording : mRecordings) {
+        _setTaken(recording.mNumber, true);
+        _requestDuration(recording);
+    }
+    mReady = true;
+    endResetModel();
+    emit readyChanged();
+}
+
+void RecordingLibrary::_rescan() {
+    auto          names = QDir(DIRECTORY).entryList(NAME_FILTERS, QDir::Files, QDir::NoSort);
+    QSet<QString> present(names.begin(), names.end());
+    QSet<QString> known;
+    for (int row = (int)mRecordings.size() - 1; row >= 0; row--) {
+        if (present.contains(mRecordings[row].mName)) {
+            known.insert(mRecordings[row].mName);
+        } else {
+            _remove(row);
+        }
+    }
+    for (auto& name : names) {
+        if (!known.contains(name)) {
+            auto recording = _stat(name);
+            _requestDuration(recording);
+            _insert(std::move(recording));
+        }
+    }
+}
+
+void RecordingLibrary::_insert(Recording recording) {
+    auto it  = std::find_if(mRecordings.begin(), mRecordings.end(), [&](auto& item) {
+        return item.mModifiedTime < recording.mModifiedTime;
+    });
+    auto row = (int)(it - mRecordings.begin());
+    _setTaken(recording.mNumber, true);
+    beginInsertRows({}, row, row);
+    mRecordings.insert(it, std::move(recording));
+    endInsertRows();
+}
+
+void RecordingLibrary::_remove(int row) {
+    _setTaken(mRecordings[row].mNumber, false);
+    beginRemoveRows({}, row, row);
+    mRecordings.erase(mRecordings.begin() + row);
+    endRemoveRows();
+}
+
+void RecordingLibrary::_setTaken(int number, bool taken) {
+    if (number <= 0) {
+        return;
+    }
+    if ((size_t)number >= mTaken.size()) {
+        mTaken.resize(number + 1);
+    }
+    mTaken[number] += taken ? 1 : -1;
+    if (taken) {
+        while ((size_t)mNextNumber < mTaken.size() && mTaken[mNextNumber] > 0) {
+            mNextNumber++;
+        }
+    } else if (mTaken[number] == 0) {
+        mNextNumber = std::min(mNextNumber, number);
+    }
+}
+
+void RecordingLibrary::_requestDuration(const Recording& recording) {
+    if (recording.mDuration == 0 && recording.mName.endsWith(".mp3", Qt::CaseInsensitive)) {
+        filemanager::MetadataStore::getInstance()
+            .request(getDirectory() + recording.mName, recording.mSize, recording.mModifiedTime);
+    }
+}
+
+} // namespace mod
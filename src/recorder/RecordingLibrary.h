@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "common/service/Logger.h"
+
+#include <QAbstractListModel>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+#include <thread>
+
+namespace mod {
+
+// The recordings folder, newest first.
+// Scanned once on a worker thread, then kept current from directory change notifications,
+// so that neither opening the list nor naming a new recording has to walk the folder again.
+class RecordingLibrary : public QAbstractListModel, public Singleton<RecordingLibrary>, private Logger {
+    Q_OBJECT
+
+    Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged);
+
+public:
+    ~RecordingLibrary() override;
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent) const override;
+
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role) const override;
+
+    [[nodiscard]] QHash<int, QByteArray> roleNames() const override;
+
+    [[nodiscard]] bool isReady() const;
+
+    [[nodiscard]] static QString getDirectory();
+
+    // Absolute path of the next "新录音NN" with `suffix`, the lowest number not taken.
+    // The number is reserved at once, before the file even exists.
+    QString takeNextPath(const QString& suffix);
+
+    // `duration` in ms, known by the recorder without reading the file again.
+    // `savedPath` differs from the `recordedPath` taken above if the recording was renamed meanwhile.
+    void onRecordingFinished(const QString& recordedPath, const QString& savedPath, int64 duration);
+
+    void onDirectoryChanged(const QString& path);
+
+    void onMetadataReady(const QStringList& paths);
+
+signals:
+
+    void readyChanged();
+
+private:
+    friend Singleton<RecordingLibrary>;
+    explicit RecordingLibrary();
+
+    enum class UserRoles { FileName = Qt::UserRole + 1, FilePath, Size, Duration, ModifiedTime };
+
+    struct Recording {
+        QString mName;
+        int64   mSize{};
+        int64   mModifiedTime{};
+        int64   mDuration{}; // ms, 0 until known.
+        int     mNumber{};   // of "新录音NN", 0 for other names.
+    };
+
+    std::vector<Recording> mRecordings;
+    bool                   mReady{};
+
+    std::thread            mScanner;
+    std::vector<Recording> mScanned; // written by mScanner, read once it is joined or has reported back.
+
+    // Files per number (新录音01.mp3 and 新录音01.wav may both exist), and the lowest free number.
+    // Taking one moves mNextNumber up past the taken ones and releasing one moves it down to the gap,
+    // so with recordings numbered in sequence, naming the next one is O(1).
+    std::vector<int> mTaken;
+    int              mNextNumber{1};
+
+    QFileSystemWatcher mWatcher;
+    QTimer             mRescanTimer;
+
+    static Recording _stat(const QString& name);
+
+    static std::vector<Recording> _scan();
+
+    void _onScanned();
+
+    // Names only, files that came or went are the only ones touched.
+    void _rescan();
+
+    void _insert(Recording recording);
+
+    void _remove(int row);
+
+    void _setTaken(int number, bool taken);
+
+    void _requestDuration(const Recording& recording);
+};
+
+} // namespace mod
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#include "recorder/RecordingPipeline.h"
+
+#include <QElapsedTimer>
+
+namespace mod {
+
+constexpr int    RING_SECONDS     = 4;
+constexpr size_t CHUNK_FRAMES     = 4096; // 256ms at 16kHz.
+constexpr auto   IDLE_WAIT        = std::chrono::milliseconds(100);
+constexpr int64  FIRST_CHECKPOINT = 1000;     // ms, so that a short recording doesn't sit in the buffer only.
+constexpr int64  CHECKPOINT       = 5 * 1000; // ms, at most this much is lost if the app dies.
+
+RecordingPipeline::RecordingPipeline(std::unique_ptr<AudioEncoder> encoder, int sampleRate, int channels)
+: mSampleRate(sampleRate),
+  mChannels(channels),
+  mRing((size_t)sampleRate * channels * RING_SECONDS, channels),
+  mEncoder(std::move(encoder)) {}
+
+RecordingPipeline::~RecordingPipeline() { stop(); }
+
+bool RecordingPipeline::start(const QString& path) {
+    if (mThread.joinable() || !mWriter.open(path)) {
+        return false;
+    }
+    mStopping   = false;
+    mFailed     = false;
+    mCaptured   = 0;
+    mDropped    = 0;
+    mEncoded    = 0;
+    mOutput     = 0;
+    mEncodeTime = 0;
+    mThread     = std::thread([this]() { _run(); });
+    return true;
+}
+
+void RecordingPipeline::push(const int16* samples, size_t count) {
+    auto stored  = mRing.push(samples, count);
+    mCaptured   += stored;
+    mDropped    += count - stored;
+    if (mRing.size() >= CHUNK_FRAMES * mChannels) {
+        mWakeUp.notify_one();
+    }
+}
+
+bool RecordingPipeline::stop() {
+    if (!mThread.joinable()) {
+        return false;
+    }
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mWakeUp.notify_one();
+    mThread.join();
+    return !mFailed;
+}
+
+RecordingPipeline::Stats RecordingPipeline::getStats() const { return {mCaptured, mDropped, mEncodeTime, mOutput}; }
+
+double RecordingPipeline::getRealTimeFactor() const {
+    auto audioTime = (double)mEncoded / mChannels / mSampleRate * 1e9;
+    return audioTime > 0 ? (double)mEncodeTime / audioTime : 0;
+}
+
+void RecordingPipeline::_run() {
+    std::vector<int16> pcm(CHUNK_FRAMES * mChannels);
+    std::vector<uint8> out;
+
+    auto write = [&]() {
+        if (!out.empty()) {
+            mOutput += (int64)out.size();
+            if (!mWriter.write(out.data(), out.size())) {
+                mFailed = true;
+            }
+            out.clear();
+        }
+    };
+    auto encode = [&](size_t count) {
+        QElapsedTimer timer;
+        timer.start();
+        mEncoder->encode(pcm.data(), count / mChannels, out);
+        mEncodeTime += timer.nsecsElapsed();
+        mEncoded    += count;
+        write();
+    };
+
+    QElapsedTimer sinceSync;
+    sinceSync.start();
+    auto checkpoint = FIRST_CHECKPOINT;
+    mEncoder->begin(out);
+    write();
+    while (true) {
+        {
+            std::unique_lock lock(mMutex);
+            mWakeUp.wait_for(lock, IDLE_WAIT, [&]() { return mStopping || mRing.size() >= pcm.size(); });
+        }
+        // Read before draining, samples pushed before stop() are all encoded.
+        auto stopping = mStopping.load();
+        while (auto count = mRing.pop(pcm.data(), pcm.size())) {
+            encode(count);
+        }
+        if (stopping) {
+            break;
+        }
+        if (sinceSync.elapsed() >= checkpoint) {
+            if (!mWriter.sync()) {
+                mFailed = true;
+            }
+            sinceSync.restart();
+            checkpoint = CHECKPOINT;
+        }
+    }
+    mEncoder->flush(out);
+    write();
+    if (auto header = mEncoder->getFinalHeader(mWriter.getSize()); !header.empty()) {
+        if (!mWriter.writeAt(0, header.data(), header.size())) {
+            mFailed = true;
+        }
+    }
+    if (!mWriter.close()) {
+        mFailed = true;
+    }
+}
+
+} // namespace mod
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-only
+/*
+ * Copyright (C) 2022-present, PenUniverse.
+ * This file is part of the PenMods open source project.
+ */
+
+#pragma once
+
+#include "recorder/AudioEncoder.h"
+#include "recorder/BlockWriter.h"
+#include "recorder/PcmRing.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace mod {
+
+// Capture -> encode -> write, each stage on its own pace.
+// The capture side only copies PCM into a ring, an encoder thread drains it and hands the frames to a BlockWriter.
+// What was encoded is synced to disk a second in, then every few seconds, see RecordingJournal for what happens
+// after a crash.
+class RecordingPipeline {
+public:
+    struct Stats {
+        uint64 mCaptured{};   // samples accepted.
+        uint64 mDropped{};    // samples lost because the ring was full.
+        int64  mEncodeTime{}; // ns spent in the encoder.
+        int64  mBytes{};      // of output.
+    };
+
+    RecordingPipeline(std::unique_ptr<AudioEncoder> encoder, int sampleRate, int channels);
+
+    ~RecordingPipeline();
+
+    bool start(const QString& path);
+
+    // Capture side, never blocks.
+    void push(const int16* samples, size_t count);
+
+    // Encodes what is left, flushes the encoder, fixes the header up and closes the file.
+    bool stop();
+
+    [[nodiscard]] Stats getStats() const;
+
+    // Samples waiting for the encoder, a push of more than getCapacity() - getBacklog() drops some.
+    [[nodiscard]] size_t getBacklog() const { return mRing.size(); }
+
+    [[nodiscard]] size_t getCapacity() const { return mRing.capacity(); }
+
+    // Time spent encoding / duration of the audio encoded, below 1 the encoder keeps up.
+    [[nodiscard]] double getRealTimeFactor() const;
+
+private:
+    int mSampleRate;
+    int mChannels;
+
+    PcmRing                       mRing;
+    BlockWriter                   mWriter;
+    std::unique_ptr<AudioEncoder> mEncoder;
+
+    std::thread             mThread;
+    std::mutex              mMutex;
+    std::condition_variable mWakeUp;
+    std::atomic<bool>       mStopping{false};
+    std::atomic<bool>       mFailed{false};
+
+    std::atomic<uint64> mCaptured{0};
+    std::atomic<uint64> mDropped{0};
+    std::atomic<uint64> mEncoded{0};
+    std::atomic<int64>  mEncodeTime{0};
+    std::atomic<int64>  mOutput{0};
+
+    void _run();
+};
+
+} // namespace mod
@@ -11,6 +11,8 @@
 
 #include "common/Event.h"
 
+#include "filemanager/player/MusicPlayer.h"
+
 #include <QQmlContext>
 
 namespace mod {
@@ -134,8 +136,8 @@ PEN_HOOK(
     uint64 a4,
     uint64 a5
 ) {
-    mod::ScreenManager ::getInstance().onPlayStateChanged(
-        PEN_CALL(PlayState, "_ZNK19YMediaPlayerManager9playStateEv", uint64)(self)
-    );
+    auto state = PEN_CALL(PlayState, "_ZNK19YMediaPlayerManager9playStateEv", uint64)(self);
+    mod::ScreenManager ::getInstance().onPlayStateChanged(state);
+    mod::filemanager::MusicPlayer::getInstance().onPlayStateChanged(state);
     return origin(self, a5, a2, a3, a4);
 }
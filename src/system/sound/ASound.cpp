@@ -9,47 +9,165 @@
 #include "common/Event.h"
 #include "common/Utils.h"
 
+#include <alsa/asoundlib.h>
+
 namespace mod {
 
+// The range the configuration keeps when the gain stage is there.
+constexpr ASound::VoiceDb BASE_DB = {-50.0, 0.0};
+
+constexpr auto  GAIN_CONTROL    = "PenMods Playback Gain";
+constexpr float GAIN_MIN_DB     = -40;
+constexpr float GAIN_MAX_DB     = 12;  // above unity for quiet tracks, see setTrackGain().
+constexpr int   GAIN_RESOLUTION = 105; // 0.5dB steps, softvol mutes at 0 so that one is never used.
+
+// Between the plug the system plays into and the volume it sets, so that the system volume keeps working as is.
+constexpr auto GAIN_STAGE = R"(
+# PenMods gain stage >>>
+pcm.penmods_gain {
+    type softvol
+    slave.pcm "softvol_ply"
+    control {
+        name "PenMods Playback Gain"
+        card 0
+        count 1
+    }
+    min_dB -40.0
+    max_dB 12.0
+    resolution 105
+}
+# PenMods gain stage <<<
+)";
+
+// plug_ply -> softvol_ply becomes plug_ply -> penmods_gain -> softvol_ply, false if the layout is not that one.
+static bool insertGainStage(QString& content) {
+    const QString slave = "slave.pcm \"softvol_ply\"";
+
+    auto begin = content.indexOf("pcm.plug_ply {");
+    auto end   = begin < 0 ? -1 : content.indexOf('}', begin);
+    auto pos   = begin < 0 ? -1 : content.indexOf(slave, begin);
+    if (pos < 0 || pos > end) {
+        return false;
+    }
+    content.replace(pos, slave.size(), "slave.pcm \"penmods_gain\"");
+    content += GAIN_STAGE;
+    return true;
+}
+
+static bool writeIfChanged(const std::string& path, const std::string& content, bool& changed) {
+    {
+        std::ifstream ifile(path);
+        if (ifile.good() && std::string(std::istreambuf_iterator<char>(ifile), {}) == content) {
+            return true;
+        }
+    }
+    std::ofstream ofile(path);
+    if (!ofile.good()) {
+        return false;
+    }
+    ofile << content;
+    changed = true;
+    return ofile.good();
+}
+
 ASound::ASound() : Logger("ASound") {
 
-    mVoiceDb = {0.0, -50.0};
+    mVoiceDb = BASE_DB;
+
+    // softvol would create it at its maximum the first time something plays, before the UI is up.
+    _setGain(0);
 
     connect(&Event::getInstance(), &Event::uiCompleted, this, &ASound::onUiCompleted);
 }
 
-void ASound::onUiCompleted() { setDb(mVoiceDb); }
+void ASound::onUiCompleted() {
+    mReady = true;
+    _apply();
+}
 
 bool ASound::setDb(VoiceDb val) {
     mVoiceDb = val;
-    return _resetConfig();
+    return !mReady || _apply();
 }
 
 ASound::VoiceDb ASound::getDb() { return mVoiceDb; }
 
-bool ASound::_resetConfig() {
-    auto cfg     = _getConfig();
-    auto content = QString::fromStdString(cfg.mContent)
-                       .replace("{mindb}", QString::number(mVoiceDb.min, 'f', 1))
-                       .replace("{maxdb}", QString::number(mVoiceDb.max, 'f', 1))
-                       .toStdString();
-    std::ofstream ofile(cfg.mPath);
-    if (ofile.good()) {
-        ofile << content;
-    } else {
-        return false;
+bool ASound::setTrackGain(float db) {
+    if (mTrackGain == db) {
+        return true;
     }
-    ofile.close();
-    ofile.open("/etc/asound.conf");
-    if (ofile.good()) {
-        ofile << content;
-    } else {
+    mTrackGain = db;
+    return mReady && mGainStage && _setGain(_getGain());
+}
+
+float ASound::_getGain() const { return mVoiceDb.max - BASE_DB.max + mTrackGain; }
+
+bool ASound::_apply() {
+    auto changed = _resetConfig();
+    if (!changed) {
         return false;
     }
-    ofile.close();
+    if (mGainStage && !_setGain(_getGain())) {
+        warn("Unable to set {}, falling back to rewriting the configuration.", GAIN_CONTROL);
+        mGainUnavailable = true;
+        return _apply();
+    }
+    if (*changed) {
+        // The configuration is only read when a device is opened.
+        exec("killall SoundPlayer");
+    }
     return true;
 }
 
+std::optional<bool> ASound::_resetConfig() {
+    auto cfg     = _getConfig();
+    auto content = QString::fromStdString(cfg.mContent);
+    mGainStage   = !mGainUnavailable && insertGainStage(content);
+    auto range   = mGainStage ? BASE_DB : mVoiceDb;
+    content.replace("{mindb}", QString::number(range.min, 'f', 1));
+    content.replace("{maxdb}", QString::number(range.max, 'f', 1));
+
+    auto data    = content.toStdString();
+    auto changed = false;
+    if (!writeIfChanged(cfg.mPath, data, changed) || !writeIfChanged("/etc/asound.conf", data, changed)) {
+        return std::nullopt;
+    }
+    return changed;
+}
+
+bool ASound::_setGain(float db) {
+    auto value = std::lround((db - GAIN_MIN_DB) / (GAIN_MAX_DB - GAIN_MIN_DB) * (GAIN_RESOLUTION - 1));
+    value      = std::clamp<long>(value, 1, GAIN_RESOLUTION - 1);
+
+    snd_ctl_t* ctl;
+    if (snd_ctl_open(&ctl, "hw:0", 0) < 0) {
+        return false;
+    }
+    snd_ctl_elem_id_t* id;
+    snd_ctl_elem_id_alloca(&id);
+    snd_ctl_elem_id_set_interface(id, SND_CTL_ELEM_IFACE_MIXER);
+    snd_ctl_elem_id_set_name(id, GAIN_CONTROL);
+    snd_ctl_elem_info_t* info;
+    snd_ctl_elem_info_alloca(&info);
+    snd_ctl_elem_info_set_id(info, id);
+    // softvol creates it the first time the device is opened, made the same way if nothing played yet.
+    // One left by an older layout would be read on another scale, softvol would replace it too.
+    auto found = snd_ctl_elem_info(ctl, info) >= 0;
+    auto ok    = found && snd_ctl_elem_info_get_max(info) == GAIN_RESOLUTION - 1;
+    if (!ok && (!found || snd_ctl_elem_remove(ctl, id) >= 0)) {
+        ok = snd_ctl_elem_add_integer(ctl, id, 1, 0, GAIN_RESOLUTION - 1, 1) >= 0;
+    }
+    if (ok) {
+        snd_ctl_elem_value_t* elem;
+        snd_ctl_elem_value_alloca(&elem);
+        snd_ctl_elem_value_set_id(elem, id);
+        snd_ctl_elem_value_set_integer(elem, 0, value);
+        ok = snd_ctl_elem_write(ctl, elem) >= 0;
+    }
+    snd_ctl_close(ctl);
+    return ok;
+}
+
 std::string ASound::_getRawConfigure(const char* model) {
     switch (H(model)) {
     case H("V4"):
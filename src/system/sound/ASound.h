@@ -21,10 +21,18 @@ public:
         float max;
     };
 
+    // Range of the system volume. Applied live through PenMods' gain stage when the configuration has one,
+    // the stage then shifts the default range by the difference in max. Otherwise the range is written
+    // into the configuration and SoundPlayer is restarted to pick it up.
+    // Before the UI is up, the range is only kept to be applied then.
     bool setDb(VoiceDb);
 
     VoiceDb getDb();
 
+    // Offset of the track being played, on top of the range. Only applied through the gain stage,
+    // SoundPlayer can't be restarted for every track.
+    bool setTrackGain(float db);
+
 private:
     friend Singleton<ASound>;
     explicit ASound();
@@ -35,8 +43,20 @@ private:
     };
 
     VoiceDb mVoiceDb{};
+    float   mTrackGain{};
+    bool    mReady{};
+    bool    mGainStage{};       // the configuration on disk has it.
+    bool    mGainUnavailable{}; // setting it failed, back to rewriting the range.
+
+    bool _apply();
+
+    // Writes the configuration if it differs from what is on disk.
+    // Returns whether it changed, nullopt if it couldn't be written.
+    std::optional<bool> _resetConfig();
+
+    [[nodiscard]] float _getGain() const;
 
-    bool _resetConfig();
+    bool _setGain(float db);
 
     Config _getConfig();
 
@@ -12,6 +12,10 @@ add_requires('lame          3.100', {
 add_requires('libxcrypt     4.4.38', {
     configs = {shared = true}
 })
+add_requires('alsa-lib      1.2.10', {
+    -- the system's libasound, so that the controls are those SoundPlayer sees.
+    configs = {shared = true}
+})
 
 --- options
 
@@ -89,7 +93,9 @@ target('PenMods')
         'dobby',
         'lame',
         -- crypt, src/helper/ServiceManager.cpp
-        'libxcrypt')
+        'libxcrypt',
+        -- snd_ctl, src/system/sound/ASound.cpp
+        'alsa-lib')
     set_pcxxheader('src/base/Base.h')
     add_includedirs(
         'src',
@@ -117,3 +123,180 @@ target('QrcExporter')
     add_packages(
         'spdlog',
         'dobby')
+
+-- Host benchmark of the recording pipeline, run it on any arm64 Linux box (or under qemu-user):
+--    xmake build RecordingBench && xmake run RecordingBench --seconds 10,60
+target('RecordingBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/RecordingBench.cpp')
+    add_files(
+        'src/recorder/AudioEncoder.cpp',
+        'src/recorder/BlockWriter.cpp',
+        'src/recorder/LevelMeter.cpp',
+        'src/recorder/PcmRing.cpp',
+        'src/recorder/RecordingPipeline.cpp')
+    add_packages(
+        'spdlog',
+        'dobby',
+        'lame')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Host benchmark of the loudness analysis behind playback normalization:
+--    xmake build LoudnessBench && xmake run LoudnessBench --seconds 60 /path/to/*.mp3
+target('LoudnessBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/LoudnessBench.cpp')
+    add_files(
+        'src/filemanager/player/Loudness.cpp',
+        'src/filemanager/player/TrackMetadata.cpp',
+        'src/filemanager/player/TrackProbe.cpp',
+        'src/recorder/LevelMeter.cpp')
+    add_packages(
+        'spdlog',
+        'dobby',
+        'lame')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Host checks of the shuffle order of random mode, fails if a track is skipped, repeated or favoured:
+--    xmake build ShuffleQueueBench && xmake run ShuffleQueueBench --size 65536
+target('ShuffleQueueBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/ShuffleQueueBench.cpp')
+    add_files('src/filemanager/player/ShuffleQueue.cpp')
+    add_packages(
+        'spdlog',
+        'dobby')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Host benchmark of scrolling the file list, the delegate bound to cached role values or, with --uncached,
+-- to values resolved on every data() call:
+--    xmake build ScrollBench && QT_QPA_PLATFORM=offscreen xmake run ScrollBench --files 2000
+target('ScrollBench')
+    set_default(false)
+    add_rules('qt.quickapp')
+    add_files('resource/bench/ScrollBench.cpp')
+    add_files(
+        'src/common/util/Pinyin.cpp',
+        'src/filemanager/FileEntity.cpp',
+        'src/filemanager/FileSorter.cpp',
+        'src/filemanager/player/TrackMetadata.cpp',
+        'src/filemanager/player/TrackProbe.cpp')
+    add_frameworks(
+        'QtQuick',
+        'QtQml',
+        'QtGui')
+    add_packages(
+        'spdlog',
+        'dobby')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Host benchmark of the file name search index, over a synthetic tree or an existing one:
+--    xmake build SearchIndexBench && xmake run SearchIndexBench --files 100000
+target('SearchIndexBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/SearchIndexBench.cpp')
+    add_files(
+        'src/common/util/Pinyin.cpp',
+        'src/filemanager/search/SearchIndex.cpp')
+    add_packages(
+        'spdlog',
+        'dobby')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Fixture for the gap between two tracks, written on the host, played and recorded on the pen, measured again
+-- on the host:
+--    xmake build GapBench && xmake run GapBench --write /tmp/gap && xmake run GapBench --measure recording.wav
+target('GapBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/GapBench.cpp')
+    add_files(
+        'src/filemanager/player/TrackProbe.cpp',
+        'src/recorder/AudioEncoder.cpp')
+    add_packages(
+        'spdlog',
+        'dobby',
+        'lame')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Host benchmark of the LRC parser, lookups and cache, over synthetic lyrics up to 100000 lines:
+--    xmake build LrcBench && xmake run LrcBench --lines 1000,10000,100000
+target('LrcBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/LrcBench.cpp')
+    add_files(
+        'src/common/util/TextEncoding.cpp',
+        'src/filemanager/player/Lyrics.cpp')
+    add_packages(
+        'spdlog',
+        'dobby')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Benchmark of UTF-8 validation in MB/s, NEON when built for the pen, SSE2 on an x86 host:
+--    xmake build Utf8Bench && xmake run Utf8Bench --mb 16
+target('Utf8Bench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/Utf8Bench.cpp')
+    add_files('src/common/util/TextEncoding.cpp')
+    add_packages(
+        'spdlog',
+        'dobby')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+
+-- Kills a recording mid-way for every profile and checks that the journal repairs it, on the pen or any Linux box
+-- that can write the PenMods cache directory:
+--    xmake build RecordingRecoveryBench && xmake run RecordingRecoveryBench --rounds 3 --pcm fixture.s16le
+target('RecordingRecoveryBench')
+    set_default(false)
+    add_rules('qt.console')
+    add_files('resource/bench/RecordingRecoveryBench.cpp')
+    add_files(
+        'src/common/util/System.cpp',
+        'src/filemanager/player/TrackMetadata.cpp',
+        'src/filemanager/player/TrackProbe.cpp',
+        'src/recorder/AudioEncoder.cpp',
+        'src/recorder/BlockWriter.cpp',
+        'src/recorder/PcmRing.cpp',
+        'src/recorder/RecordingJournal.cpp',
+        'src/recorder/RecordingPipeline.cpp')
+    add_packages(
+        'spdlog',
+        'dobby',
+        'lame')
+    set_pcxxheader('src/base/Base.h')
+    add_includedirs(
+        'src',
+        'src/base')
+    add_links(
+        -- dladdr, src/common/util/System.cpp
+        'dl')